@@ -0,0 +1,202 @@
+/*
+ * EEL6528 Lab 1: Latency-targeted dynamic block sizing
+ *
+ * A fixed 10000-sample block is 10 ms of buffering at 1 MHz but 0.4 ms at
+ * 25 MHz; neither is chosen for latency or for efficiency. The controller
+ * moves the block size at run time toward one of two targets.
+ *
+ * MODEL (from what the processing threads measure on every block):
+ *   work(N)    = c0 + c1 * N      fixed per-block cost + per-sample cost
+ *   latency(N) = N / rate + wait + work(N)
+ * latency is that of a block's first sample: it waits for the block to
+ * fill, then in the queue, then for the block to be processed. c1 comes
+ * from the thread CPU time of the per-sample stages, c0 from the CPU time
+ * of the rest of the block handling (result reporting, bookkeeping); CPU
+ * time is not inflated when workers share cores. For the latency, work is
+ * scaled by the measured wall / CPU ratio of the workers.
+ *
+ * TARGETS:
+ * - LATENCY: largest block with latency(N) <= target (fewest blocks,
+ *   least overhead, that still meets the deadline)
+ *     N = (target - wait - c0) / (1 / rate + c1)
+ * - OVERHEAD: smallest block whose fixed cost is at most a fraction r of
+ *   its work (lowest latency at that efficiency)
+ *     N = c0 * (1 - r) / (r * c1)
+ * Either way N never goes below the size at which the workers would be
+ * busier than MAX_UTILIZATION (work(N) per N / rate of stream, per worker
+ * that has a core). In overload (the per-sample cost alone exceeds that,
+ * or blocks wait in the queue longer than they take to fill, e.g. because
+ * other threads compete for the cores) no block size meets the target and
+ * the size grows instead, to shed per-block overhead.
+ *
+ * UPDATES:
+ * Workers add their measurements to relaxed atomic counters. The RX thread
+ * asks for the next size at each block boundary; a new size is computed
+ * once UPDATE_BLOCKS blocks have been measured since the last decision,
+ * goes half way (geometrically) toward the model's answer, at most 2x, is
+ * rounded to a multiple of BLOCK_QUANTUM and is applied only if it differs
+ * by more than HYSTERESIS. The stream never stops: the next recv() simply
+ * asks for the new size. The worker count comes with each request, so the
+ * utilization limit follows pool resizes.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+enum class BlockTarget { LATENCY, OVERHEAD };
+
+/**
+ * BlockSizeDecision: the measurements behind the latest size decision
+ */
+struct BlockSizeDecision {
+    size_t size = 0;                // Block size chosen (samples)
+    double latency_s = 0.0;         // Modelled latency at the measured size
+    double wait_s = 0.0;            // Mean queue wait
+    double fixed_s = 0.0;           // c0: fixed CPU cost per block
+    double per_sample_s = 0.0;      // c1: CPU cost per sample
+    double stretch = 1.0;           // Wall time / CPU time of the work
+    bool overloaded = false;        // Workers cannot keep up at any size
+    double overhead = 0.0;          // c0 / work(N) at the measured size
+};
+
+/**
+ * BlockSizeController: shared by the RX thread (decides) and the workers
+ * (measure)
+ */
+class BlockSizeController {
+public:
+    static constexpr size_t MIN_BLOCK = 1024;
+    static constexpr size_t MAX_BLOCK = 1 << 18;
+    static constexpr size_t BLOCK_QUANTUM = 64;      // SIMD kernels' unroll
+    static constexpr uint64_t UPDATE_BLOCKS = 16;
+    static constexpr double MAX_UTILIZATION = 0.7;
+    static constexpr double HYSTERESIS = 0.1;
+
+    /**
+     * Constructor
+     * @param target_kind: What `target` means
+     * @param target: Latency in seconds, or the overhead fraction
+     * @param sample_rate: Stream rate (samples/s)
+     */
+    BlockSizeController(BlockTarget target_kind, double target, double sample_rate)
+        : kind(target_kind), goal(target), rate(sample_rate) {}
+
+    /**
+     * record(): One processed block (any worker, lock-free)
+     * @param samples: Block size
+     * @param wait_s: Time the block spent queued
+     * @param wall_s: Wall time from dequeue to done
+     * @param sample_work_s: CPU time in the per-sample stages
+     * @param fixed_work_s: CPU time of the rest of the block's handling
+     */
+    void record(size_t samples, double wait_s, double wall_s, double sample_work_s, double fixed_work_s) {
+        blocks.fetch_add(1, std::memory_order_relaxed);
+        total_samples.fetch_add(samples, std::memory_order_relaxed);
+        wait_ns.fetch_add(to_ns(wait_s), std::memory_order_relaxed);
+        wall_ns.fetch_add(to_ns(wall_s), std::memory_order_relaxed);
+        sample_ns.fetch_add(to_ns(sample_work_s), std::memory_order_relaxed);
+        fixed_ns.fetch_add(to_ns(fixed_work_s), std::memory_order_relaxed);
+    }
+
+    /**
+     * next_size(): Block size for the next recv() (RX thread only)
+     * @param current: Size in use
+     * @param workers: Processing threads sharing the load now (at most one
+     *   per core)
+     * @return: current, or the new size once enough blocks were measured
+     */
+    size_t next_size(size_t current, size_t workers) {
+        if (largest == 0) smallest = largest = current;
+        const uint64_t n = blocks.load(std::memory_order_relaxed);
+        if (n - seen.blocks < UPDATE_BLOCKS) return current;
+        Counters now{n, total_samples.load(std::memory_order_relaxed), wait_ns.load(std::memory_order_relaxed),
+                     wall_ns.load(std::memory_order_relaxed), sample_ns.load(std::memory_order_relaxed),
+                     fixed_ns.load(std::memory_order_relaxed)};
+        const double count = static_cast<double>(now.blocks - seen.blocks);
+        const double samples = static_cast<double>(now.samples - seen.samples);
+        BlockSizeDecision d;
+        d.wait_s = (now.wait - seen.wait) * 1e-9 / count;
+        d.fixed_s = (now.fixed - seen.fixed) * 1e-9 / count;
+        d.per_sample_s = samples > 0.0 ? (now.sample - seen.sample) * 1e-9 / samples : 0.0;
+        const double cpu = (now.sample - seen.sample) + (now.fixed - seen.fixed);
+        d.stretch = cpu > 0.0 ? std::max(1.0, (now.wall - seen.wall) / cpu) : 1.0;
+        seen = now;
+
+        const double n_cur = static_cast<double>(current);
+        const double work = d.fixed_s + d.per_sample_s * n_cur;
+        d.latency_s = n_cur / rate + d.wait_s + work * d.stretch;
+        d.overhead = work > 0.0 ? d.fixed_s / work : 0.0;
+
+        double wanted;
+        if (kind == BlockTarget::LATENCY) {
+            wanted = (goal - d.wait_s - d.fixed_s * d.stretch) / (1.0 / rate + d.per_sample_s * d.stretch);
+        } else {
+            wanted = d.per_sample_s > 0.0 ? d.fixed_s * (1.0 - goal) / (goal * d.per_sample_s) : MAX_BLOCK;
+        }
+
+        // Keep the workers below MAX_UTILIZATION: work(N) <= U * threads * N / rate
+        const double threads = static_cast<double>(std::max<size_t>(workers, 1));
+        const double capacity = MAX_UTILIZATION * threads / rate - d.per_sample_s;
+        if (capacity > 0.0) wanted = std::max(wanted, d.fixed_s / capacity);
+
+        // Overload (per-sample cost alone above the limit, or blocks waiting
+        // longer than they take to fill): smaller blocks would only add
+        // overhead, so grow toward efficiency instead
+        d.overloaded = capacity <= 0.0 || d.wait_s > n_cur / rate;
+        if (d.overloaded) wanted = n_cur * 2;
+
+        wanted = std::sqrt(n_cur * std::max(wanted, 1.0));
+        wanted = std::min(std::max(wanted, n_cur / 2), n_cur * 2);
+        size_t next = static_cast<size_t>(wanted / BLOCK_QUANTUM + 0.5) * BLOCK_QUANTUM;
+        next = std::min(std::max(next, MIN_BLOCK), MAX_BLOCK);
+        if (std::fabs(static_cast<double>(next) - n_cur) <= HYSTERESIS * n_cur) next = current;
+
+        d.size = next;
+        last = d;
+        if (next != current) {
+            changes++;
+            smallest = std::min(smallest, next);
+            largest = std::max(largest, next);
+        }
+        return next;
+    }
+
+    const BlockSizeDecision& last_decision() const { return last; }
+    uint64_t size_changes() const { return changes; }
+    size_t smallest_size() const { return smallest; }
+    size_t largest_size() const { return largest; }
+    BlockTarget target_kind() const { return kind; }
+    double target() const { return goal; }
+
+private:
+    struct Counters {
+        uint64_t blocks = 0, samples = 0, wait = 0, wall = 0, sample = 0, fixed = 0;
+    };
+
+    static uint64_t to_ns(double seconds) {
+        return seconds > 0.0 ? static_cast<uint64_t>(seconds * 1e9) : 0;
+    }
+
+    BlockTarget kind;
+    double goal;
+    double rate;
+
+    // Written by the workers
+    std::atomic<uint64_t> blocks{0};
+    std::atomic<uint64_t> total_samples{0};
+    std::atomic<uint64_t> wait_ns{0};
+    std::atomic<uint64_t> wall_ns{0};
+    std::atomic<uint64_t> sample_ns{0};
+    std::atomic<uint64_t> fixed_ns{0};
+
+    // RX thread only
+    Counters seen;
+    BlockSizeDecision last;
+    uint64_t changes = 0;
+    size_t smallest = MAX_BLOCK;
+    size_t largest = 0;
+};
@@ -0,0 +1,282 @@
+/*
+ * EEL6528 Lab 1: Burst extraction
+ *
+ * On a sparse channel most samples are noise. The segmenter finds the
+ * active regions of the stream and emits them as variable-length burst
+ * records, so recording and analysis see only the interesting data.
+ *
+ * DETECTION (per sample, in stream order):
+ *   s[n] = s[n-1] + (|x[n]|^2 - s[n-1]) / SMOOTHING   (one-pole power smoother)
+ *   start: s[n] > on_level
+ *   end:   s[n] < off_level for HANGOVER consecutive samples
+ * on_level / off_level sit on_db / off_db above the noise floor (hysteresis).
+ *
+ * PADDING:
+ * Each record starts pre_pad samples before the trigger and runs post_pad
+ * samples past the end of the hangover. A new trigger during the post pad
+ * extends the current burst instead of starting another.
+ *
+ * BLOCK BOUNDARIES:
+ * All detector state (smoother, hysteresis state, pre-pad ring, the open
+ * record) persists across process() calls, so a burst straddling any number
+ * of blocks comes out as one record. Blocks must be fed in stream order.
+ *
+ * STORAGE:
+ * Record samples live in buffers from a SamplePool; a buffer returns to the
+ * pool when the last reference to the record's samples is dropped, so
+ * steady-state extraction does not allocate.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// ============================================================================
+// POOLED SAMPLE STORAGE
+// ============================================================================
+
+using SampleBuffer = std::vector<std::complex<float>>;
+
+/**
+ * SamplePool: recycles sample buffers between burst records
+ *
+ * acquire() hands out a cleared buffer wrapped in a shared_ptr whose deleter
+ * puts it back on the free list. The free list is shared with the deleters,
+ * so buffers may safely outlive the pool object itself.
+ */
+class SamplePool {
+public:
+    /**
+     * Constructor
+     * @param reserve_samples: Capacity reserved for newly allocated buffers
+     * @param max_free: Buffers kept on the free list (extra ones are freed)
+     */
+    explicit SamplePool(size_t reserve_samples = 16384, size_t max_free = 64)
+        : state(std::make_shared<State>()) {
+        state->reserve_samples = reserve_samples;
+        state->max_free = max_free;
+    }
+
+    std::shared_ptr<SampleBuffer> acquire() {
+        SampleBuffer* buffer = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(state->mtx);
+            if (!state->free_list.empty()) {
+                buffer = state->free_list.back().release();
+                state->free_list.pop_back();
+                state->reused++;
+            } else {
+                state->allocated++;
+            }
+        }
+        if (!buffer) {
+            buffer = new SampleBuffer();
+            buffer->reserve(state->reserve_samples);
+        }
+        buffer->clear();
+        std::shared_ptr<State> shared = state;
+        return std::shared_ptr<SampleBuffer>(buffer, [shared](SampleBuffer* b) {
+            std::lock_guard<std::mutex> lock(shared->mtx);
+            if (shared->free_list.size() < shared->max_free) shared->free_list.emplace_back(b);
+            else delete b;
+        });
+    }
+
+    uint64_t buffers_allocated() const { std::lock_guard<std::mutex> lock(state->mtx); return state->allocated; }
+    uint64_t buffers_reused() const { std::lock_guard<std::mutex> lock(state->mtx); return state->reused; }
+
+private:
+    struct State {
+        std::mutex mtx;
+        std::vector<std::unique_ptr<SampleBuffer>> free_list;
+        size_t reserve_samples = 0;
+        size_t max_free = 0;
+        uint64_t allocated = 0;
+        uint64_t reused = 0;
+    };
+    std::shared_ptr<State> state;
+};
+
+// ============================================================================
+// BURST RECORDS AND SEGMENTER
+// ============================================================================
+
+/**
+ * BurstRecord: one active segment of the stream
+ */
+struct BurstRecord {
+    uint64_t sample_offset = 0;           // Stream index of samples[0]
+    uint64_t length = 0;                  // Number of samples (incl. padding)
+    std::shared_ptr<SampleBuffer> samples; // Pooled sample storage
+    double peak_power = 0.0;              // Largest smoothed power inside the burst
+    double avg_power = 0.0;               // Mean |x|^2 over the record
+    bool truncated = false;               // Split at max_length (burst continues)
+};
+
+/**
+ * BurstSegmenter: stateful in-order burst detector
+ */
+class BurstSegmenter {
+public:
+    static const size_t SMOOTHING = 32;   // Power smoother length (samples)
+    static const size_t HANGOVER = 256;   // Quiet samples that end a burst
+
+    /**
+     * Constructor
+     * @param on_db: Smoothed power above the noise floor that starts a burst
+     * @param off_db: Level below which the hangover counts (on_db - hysteresis)
+     * @param pre_pad: Samples kept before the trigger
+     * @param post_pad: Samples kept after the hangover
+     * @param max_length: Records longer than this are split (bounds memory)
+     */
+    BurstSegmenter(double on_db, double off_db, size_t pre_pad = 256, size_t post_pad = 256,
+                   size_t max_length = 1 << 20)
+        : on_ratio(std::pow(10.0, on_db / 10.0)), off_ratio(std::pow(10.0, off_db / 10.0)),
+          pre(pre_pad), post(post_pad), max_len(max_length), ring(std::max<size_t>(pre_pad, 1)) {}
+
+    /**
+     * set_noise_floor(): Noise power the thresholds are relative to
+     */
+    void set_noise_floor(double floor) {
+        on_level = static_cast<float>(floor * on_ratio);
+        off_level = static_cast<float>(floor * off_ratio);
+    }
+
+    /**
+     * process(): Run the detector over the next block of the stream
+     * @param offset: Stream index of in[0] (must continue the previous call)
+     * @param in: Samples
+     * @param n: Number of samples
+     * @param completed: Finished records are appended here
+     */
+    void process(uint64_t offset, const std::complex<float>* in, size_t n,
+                 std::vector<BurstRecord>& completed) {
+        // |x|^2 for the whole block first (vectorizable), then the scalar state machine
+        power.resize(n);
+        const float* x = reinterpret_cast<const float*>(in);
+        for (size_t i = 0; i < n; i++) power[i] = x[2 * i] * x[2 * i] + x[2 * i + 1] * x[2 * i + 1];
+
+        const float weight = 1.0f / SMOOTHING;
+        for (size_t i = 0; i < n; i++) {
+            smoothed += weight * (power[i] - smoothed);
+            const uint64_t index = offset + i;
+
+            if (state == IDLE) {
+                if (smoothed > on_level && on_level > 0.0f) {
+                    open_record(index);
+                    state = ACTIVE;
+                    quiet = 0;
+                } else {
+                    push_ring(in[i]);
+                    continue;
+                }
+            } else if (state == ACTIVE) {
+                quiet = (smoothed < off_level) ? quiet + 1 : 0;
+                if (quiet >= HANGOVER) {
+                    state = TAIL;
+                    tail_left = post;
+                }
+            } else {   // TAIL
+                if (smoothed > on_level) {
+                    state = ACTIVE;       // Re-triggered inside the post pad: same burst
+                    quiet = 0;
+                } else if (tail_left == 0) {
+                    finish_record(completed, false);
+                    state = IDLE;
+                    push_ring(in[i]);
+                    continue;
+                } else {
+                    tail_left--;
+                }
+            }
+
+            // Sample belongs to the open record
+            current.samples->push_back(in[i]);
+            energy += power[i];
+            current.peak_power = std::max(current.peak_power, double(smoothed));
+            if (current.samples->size() >= max_len) {
+                finish_record(completed, true);
+                open_record(index + 1, false);
+            }
+        }
+        samples_seen += n;
+    }
+
+    /**
+     * flush(): Emit the open record at end of stream
+     */
+    void flush(std::vector<BurstRecord>& completed) {
+        if (state != IDLE) finish_record(completed, false);
+        state = IDLE;
+    }
+
+    bool active() const { return state != IDLE; }
+    uint64_t total_samples() const { return samples_seen; }
+    uint64_t burst_samples() const { return samples_emitted; }
+    uint64_t bursts() const { return bursts_emitted; }
+    const SamplePool& pool() const { return buffers; }
+
+private:
+    enum State { IDLE, ACTIVE, TAIL };
+
+    void push_ring(const std::complex<float>& sample) {
+        if (pre == 0) return;
+        ring[ring_head] = sample;
+        if (++ring_head == pre) ring_head = 0;     // No division in the per-sample path
+        if (ring_count < pre) ring_count++;
+    }
+
+    // Start a record at stream index `start`, preceded by the pre-pad ring
+    void open_record(uint64_t start, bool with_padding = true) {
+        current = BurstRecord();
+        current.samples = buffers.acquire();
+        energy = 0.0;
+        const size_t padding = with_padding ? ring_count : 0;
+        current.sample_offset = start - padding;
+        for (size_t k = 0; k < padding; k++) {
+            const std::complex<float>& s = ring[(ring_head + pre - padding + k) % pre];
+            current.samples->push_back(s);
+            energy += std::norm(s);
+        }
+        ring_count = 0;
+    }
+
+    void finish_record(std::vector<BurstRecord>& completed, bool truncated) {
+        current.length = current.samples->size();
+        current.avg_power = current.length ? energy / current.length : 0.0;
+        current.truncated = truncated;
+        samples_emitted += current.length;
+        bursts_emitted++;
+        completed.push_back(std::move(current));
+        current = BurstRecord();
+    }
+
+    double on_ratio, off_ratio;           // Thresholds relative to the floor (linear)
+    float on_level = 0.0f;                // Absolute thresholds (0 = floor not set yet)
+    float off_level = 0.0f;
+    size_t pre, post, max_len;
+
+    State state = IDLE;
+    float smoothed = 0.0f;                // Smoothed |x|^2
+    size_t quiet = 0;                     // Consecutive samples below off_level
+    size_t tail_left = 0;                 // Post-pad samples still to take
+
+    std::vector<std::complex<float>> ring; // Last pre_pad idle samples
+    size_t ring_head = 0;
+    size_t ring_count = 0;
+
+    BurstRecord current;                  // Open record (state != IDLE)
+    double energy = 0.0;                  // Sum |x|^2 of the open record
+    std::vector<float> power;             // Per-block |x|^2, reused
+    SamplePool buffers;
+
+    uint64_t samples_seen = 0;
+    uint64_t samples_emitted = 0;
+    uint64_t bursts_emitted = 0;
+};
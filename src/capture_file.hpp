@@ -0,0 +1,598 @@
+/*
+ * EEL6528 Lab 1: Capture files
+ *
+ * A capture is the sample stream exactly as the RX thread queued it (after
+ * IQ correction, in the host format fc32 or sc8). Block k of the file is
+ * block k of the live run, so offline processing can be compared with live
+ * results block by block.
+ *
+ * CONTAINER LAYOUT (written by lab1 --record, little-endian):
+ *   CaptureFileHeader, padded to CAPTURE_HEADER_BYTES
+ *       RX frequency / rate / gain actually used, sample format and scale,
+ *       block size, wall-clock start; protected by its own CRC
+ *   chunk[0..N)     fixed size: ChunkHeader (32 B) + one block of samples
+ *       ChunkHeader: block number, timestamp, avg/peak power and a CRC-32C
+ *       over the rest of the header and the payload
+ *   PowerIndexEntry[N]   trailing index (see power_index.hpp)
+ *   CaptureFooter   locates the index, with its CRC
+ *
+ * RANDOM ACCESS:
+ * Chunks are fixed-size, so chunk i starts at
+ * CAPTURE_HEADER_BYTES + i * chunk_bytes. CaptureReader maps the whole file;
+ * payloads are plain pointers into the page cache, usable from any thread.
+ *
+ * CRASH TOLERANCE:
+ * The footer is written last. Without a valid footer (recording killed),
+ * the reader rebuilds the index from the chunk headers, stops at the first
+ * missing or torn chunk and checks the checksum of the last one. Appending
+ * (CaptureWriter::append) truncates a file back to its last good chunk and
+ * continues after it.
+ *
+ * Plain headerless dumps (fc32 / sc8 samples back to back) are still read
+ * with view_capture(), given the format on the command line.
+ */
+
+#pragma once
+
+#include "sample_block.hpp"
+#include "power_index.hpp"
+#include "checksum.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <chrono>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ============================================================================
+// MEMORY-MAPPED READING
+// ============================================================================
+
+/**
+ * MappedFile: read-only mapping of a whole file (RAII)
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    /**
+     * open(): Map the file
+     * @param error: Reason on failure
+     */
+    bool open(const std::string& path, std::string& error) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            error = path + ": " + std::strerror(errno);
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            error = path + ": " + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        length = static_cast<size_t>(st.st_size);
+        if (length > 0) {
+            void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                error = path + ": mmap: " + std::strerror(errno);
+                ::close(fd);
+                length = 0;
+                return false;
+            }
+            base = static_cast<const uint8_t*>(mapped);
+            // Each worker streams through its own region front to back
+            madvise(mapped, length, MADV_SEQUENTIAL);
+        }
+        ::close(fd);   // The mapping keeps the file referenced
+        return true;
+    }
+
+    void close() {
+        if (base) munmap(const_cast<uint8_t*>(base), length);
+        base = nullptr;
+        length = 0;
+    }
+
+    const uint8_t* data() const { return base; }
+    size_t size() const { return length; }
+
+private:
+    const uint8_t* base = nullptr;
+    size_t length = 0;
+};
+
+/**
+ * CaptureView: a mapped capture seen as a sequence of fixed-size blocks
+ *
+ * Works for both layouts: in a container, consecutive payloads are
+ * chunk_bytes apart and each is preceded by its ChunkHeader.
+ */
+struct CaptureView {
+    const uint8_t* data = nullptr;      // First sample of block 0
+    SampleFormat format = SampleFormat::FC32; // FC32 or SC8
+    float int_scale = 1.0f;             // fc32 amplitude of one int8 step (SC8)
+    size_t block_samples = 0;           // Samples per block
+    uint64_t num_blocks = 0;            // Complete blocks in the file
+    size_t stride = 0;                  // Bytes from one block to the next
+    bool chunked = false;               // Container: blocks carry a ChunkHeader
+
+    size_t bytes_per_sample() const {
+        return format == SampleFormat::SC8 ? sizeof(std::complex<int8_t>) : sizeof(std::complex<float>);
+    }
+    size_t block_bytes() const { return block_samples * bytes_per_sample(); }
+    const uint8_t* block(uint64_t index) const { return data + index * stride; }
+};
+
+/**
+ * view_capture(): Interpret a headerless dump as blocks (a partial last
+ * block, e.g. from an interrupted recording, is ignored)
+ */
+inline CaptureView view_capture(const MappedFile& file, SampleFormat format, float int_scale,
+                                size_t block_samples) {
+    CaptureView view;
+    view.data = file.data();
+    view.format = format;
+    view.int_scale = int_scale;
+    view.block_samples = block_samples;
+    view.stride = view.block_bytes();
+    view.num_blocks = block_samples ? file.size() / view.block_bytes() : 0;
+    return view;
+}
+
+/**
+ * capture_block_power(): Average power of one captured block, computed with
+ * the same kernels as block_avg_power() in the processing threads
+ */
+inline double capture_block_power(const CaptureView& view, uint64_t index) {
+    const uint8_t* block = view.block(index);
+    if (view.format == SampleFormat::SC8) {
+        return avg_power_sc8(reinterpret_cast<const std::complex<int8_t>*>(block), view.block_samples,
+                             view.int_scale);
+    }
+    return avg_power_fc32(reinterpret_cast<const std::complex<float>*>(block), view.block_samples);
+}
+
+// ============================================================================
+// CONTAINER FORMAT
+// ============================================================================
+
+const char CAPTURE_MAGIC[8] = {'L', '1', 'C', 'A', 'P', 'T', 'U', 'R'};
+const char CAPTURE_FOOTER_MAGIC[8] = {'L', '1', 'C', 'I', 'N', 'D', 'E', 'X'};
+const uint32_t CAPTURE_VERSION = 1;
+const uint32_t CHUNK_MAGIC = 0x4B43314C;          // "L1CK"
+const size_t CAPTURE_HEADER_BYTES = 4096;          // Header padded to one page
+
+/**
+ * CaptureFileHeader: recording parameters (start of the file)
+ */
+struct CaptureFileHeader {
+    char magic[8];                  // CAPTURE_MAGIC
+    uint32_t version;               // CAPTURE_VERSION
+    uint32_t sc8;                   // 1 = sc8 samples, 0 = fc32
+    uint64_t block_samples;         // Samples per chunk
+    uint64_t chunk_bytes;           // sizeof(ChunkHeader) + payload
+    double rx_freq;                 // Actual RX frequency (Hz)
+    double rx_rate;                 // Actual RX rate (samples/s)
+    double rx_gain;                 // Actual RX gain (dB)
+    double int_scale;               // fc32 amplitude of one int8 step (sc8)
+    int64_t start_unix_ns;          // Wall-clock time of timestamp 0
+    uint8_t reserved[52];
+    uint32_t header_crc;            // CRC-32C of the bytes above
+};
+
+/**
+ * ChunkHeader: precedes every block of samples
+ */
+struct ChunkHeader {
+    uint32_t magic;                 // CHUNK_MAGIC
+    uint32_t crc;                   // CRC-32C of the fields below + payload
+    uint64_t block_number;          // Block number in the recorded stream
+    double timestamp;               // Seconds since start_unix_ns
+    float avg_power;                // (1/N) * sum(|x[n]|^2), fc32 units
+    float peak_power;               // max |x[n]|^2, fc32 units
+};
+
+/**
+ * CaptureFooter: last bytes of a cleanly closed capture
+ */
+struct CaptureFooter {
+    char magic[8];                  // CAPTURE_FOOTER_MAGIC
+    uint64_t index_offset;          // File offset of PowerIndexEntry[0]
+    uint64_t count;                 // Index entries (= chunks)
+    uint32_t index_crc;             // CRC-32C of the index entries
+    uint32_t footer_crc;            // CRC-32C of the footer bytes above
+};
+
+static_assert(sizeof(CaptureFileHeader) == 128, "capture header layout");
+static_assert(sizeof(ChunkHeader) == 32, "chunk header layout");
+static_assert(sizeof(CaptureFooter) == 32, "capture footer layout");
+
+/**
+ * CaptureInfo: recording parameters in memory
+ */
+struct CaptureInfo {
+    SampleFormat format = SampleFormat::FC32;  // FC32 or SC8
+    float int_scale = 1.0f;
+    size_t block_samples = 0;
+    double rx_freq = 0.0;
+    double rx_rate = 0.0;
+    double rx_gain = 0.0;
+    int64_t start_unix_ns = 0;
+
+    size_t payload_bytes() const {
+        return block_samples * (format == SampleFormat::SC8 ? sizeof(std::complex<int8_t>)
+                                                            : sizeof(std::complex<float>));
+    }
+    size_t chunk_bytes() const { return sizeof(ChunkHeader) + payload_bytes(); }
+};
+
+/**
+ * chunk_crc(): Checksum stored in a ChunkHeader
+ */
+inline uint32_t chunk_crc(const ChunkHeader& header, const void* payload, size_t payload_bytes) {
+    const size_t skip = offsetof(ChunkHeader, block_number);
+    uint32_t crc = crc32c(0, reinterpret_cast<const uint8_t*>(&header) + skip, sizeof(header) - skip);
+    return crc32c(crc, payload, payload_bytes);
+}
+
+/**
+ * verify_chunk(): Check block `index` of a container view against its CRC
+ */
+inline bool verify_chunk(const CaptureView& view, uint64_t index) {
+    if (!view.chunked) return true;
+    const uint8_t* payload = view.block(index);
+    ChunkHeader header;
+    std::memcpy(&header, payload - sizeof(ChunkHeader), sizeof(header));
+    return header.magic == CHUNK_MAGIC && header.crc == chunk_crc(header, payload, view.block_bytes());
+}
+
+/**
+ * parse_capture_header(): Validate the file header
+ * @return: false if the bytes are not a capture container (error says why)
+ */
+inline bool parse_capture_header(const uint8_t* data, size_t size, CaptureInfo& info, std::string& error) {
+    if (size < CAPTURE_HEADER_BYTES || std::memcmp(data, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != 0) {
+        error = "not a capture container";
+        return false;
+    }
+    CaptureFileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.header_crc != crc32c(0, &header, offsetof(CaptureFileHeader, header_crc))) {
+        error = "capture header checksum mismatch";
+        return false;
+    }
+    if (header.version != CAPTURE_VERSION) {
+        error = "unsupported capture version " + std::to_string(header.version);
+        return false;
+    }
+    info.format = header.sc8 ? SampleFormat::SC8 : SampleFormat::FC32;
+    info.int_scale = static_cast<float>(header.int_scale);
+    info.block_samples = header.block_samples;
+    info.rx_freq = header.rx_freq;
+    info.rx_rate = header.rx_rate;
+    info.rx_gain = header.rx_gain;
+    info.start_unix_ns = header.start_unix_ns;
+    if (info.block_samples == 0 || header.chunk_bytes != info.chunk_bytes()) {
+        error = "inconsistent chunk size in capture header";
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// CONTAINER READER
+// ============================================================================
+
+/**
+ * CaptureReader: random-access reader of a mapped container
+ */
+class CaptureReader {
+public:
+    /**
+     * open(): Map and validate a container, load or rebuild its index
+     * @param error: Reason on failure
+     */
+    bool open(const std::string& path, std::string& error) {
+        if (!file.open(path, error)) return false;
+        return attach(error);
+    }
+
+    const CaptureInfo& info() const { return capture; }
+    uint64_t num_chunks() const { return count; }
+    bool index_recovered() const { return recovered; }
+    uint64_t torn_bytes() const { return torn; }
+    const MappedFile& mapping() const { return file; }
+
+    // Index entries (copy of the trailing index, or rebuilt from the chunk headers)
+    const PowerIndexEntry* entries() const { return index; }
+
+    uint64_t chunk_offset(uint64_t i) const { return CAPTURE_HEADER_BYTES + i * capture.chunk_bytes(); }
+    const uint8_t* chunk(uint64_t i) const { return file.data() + chunk_offset(i); }
+    const uint8_t* payload(uint64_t i) const { return chunk(i) + sizeof(ChunkHeader); }
+
+    // The chunks as a block view (for the shared block kernels)
+    CaptureView view() const {
+        CaptureView v;
+        v.data = file.data() + CAPTURE_HEADER_BYTES + sizeof(ChunkHeader);
+        v.format = capture.format;
+        v.int_scale = capture.int_scale;
+        v.block_samples = capture.block_samples;
+        v.num_blocks = count;
+        v.stride = capture.chunk_bytes();
+        v.chunked = true;
+        return v;
+    }
+
+private:
+    bool attach(std::string& error) {
+        const uint8_t* data = file.data();
+        const size_t size = file.size();
+        if (!parse_capture_header(data, size, capture, error)) return false;
+        const size_t chunk_size = capture.chunk_bytes();
+
+        // Clean close: the footer points at an index right after the chunks
+        if (size >= CAPTURE_HEADER_BYTES + sizeof(CaptureFooter)) {
+            CaptureFooter footer;
+            std::memcpy(&footer, data + size - sizeof(footer), sizeof(footer));
+            const uint64_t index_bytes = footer.count * sizeof(PowerIndexEntry);
+            if (std::memcmp(footer.magic, CAPTURE_FOOTER_MAGIC, sizeof(footer.magic)) == 0 &&
+                footer.footer_crc == crc32c(0, &footer, offsetof(CaptureFooter, footer_crc)) &&
+                footer.index_offset == CAPTURE_HEADER_BYTES + footer.count * chunk_size &&
+                footer.index_offset + index_bytes + sizeof(footer) == size &&
+                footer.index_crc == crc32c(0, data + footer.index_offset, index_bytes)) {
+                // Copied out: with an odd sc8 block size the chunks are not
+                // a multiple of 8 bytes and the index is misaligned in place
+                count = footer.count;
+                rebuilt.resize(count);
+                std::memcpy(rebuilt.data(), data + footer.index_offset, index_bytes);
+                index = rebuilt.data();
+                return true;
+            }
+        }
+
+        // No valid footer: rebuild from chunk headers up to the first bad one
+        recovered = true;
+        const uint64_t whole = (size - CAPTURE_HEADER_BYTES) / chunk_size;
+        rebuilt.reserve(whole);
+        for (uint64_t i = 0; i < whole; i++) {
+            ChunkHeader header;
+            std::memcpy(&header, chunk(i), sizeof(header));
+            if (header.magic != CHUNK_MAGIC) break;
+            PowerIndexEntry entry;
+            entry.block_number = header.block_number;
+            entry.timestamp = header.timestamp;
+            entry.file_offset = chunk_offset(i);
+            entry.avg_power = header.avg_power;
+            entry.peak_power = header.peak_power;
+            rebuilt.push_back(entry);
+        }
+        // The last chunk is the one a crash may have left half written
+        count = rebuilt.size();
+        if (count > 0 && !verify_chunk(view(), count - 1)) {
+            rebuilt.pop_back();
+            count--;
+        }
+        index = rebuilt.data();
+        torn = size - chunk_offset(count);
+        return true;
+    }
+
+    MappedFile file;
+    CaptureInfo capture;
+    const PowerIndexEntry* index = nullptr;
+    uint64_t count = 0;
+    bool recovered = false;             // Index rebuilt (no valid footer)
+    uint64_t torn = 0;                  // Bytes after the last good chunk (recovered)
+    std::vector<PowerIndexEntry> rebuilt;
+};
+
+// ============================================================================
+// CONTAINER WRITER
+// ============================================================================
+
+/**
+ * CaptureWriter: appends blocks to a container
+ *
+ * Used by one thread at a time. Chunks go through a large stdio buffer and
+ * are handed to the kernel every FLUSH_CHUNKS chunks, so a crash of the
+ * recording process loses at most that many; the index entries are kept in
+ * memory (32 bytes per block) and written behind the chunks on close().
+ */
+class CaptureWriter {
+public:
+    static const size_t BUFFER_BYTES = 4 << 20;
+    static const uint64_t FLUSH_CHUNKS = 64;
+
+    ~CaptureWriter() { close(); }
+
+    /**
+     * create(): Start a new container (truncates an existing file)
+     * @param info: Recording parameters; start_unix_ns 0 = now
+     * @param error: Reason on failure
+     */
+    bool create(const std::string& path, CaptureInfo info, std::string& error) {
+        if (info.start_unix_ns == 0) info.start_unix_ns = unix_now_ns();
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            error = path + ": " + std::strerror(errno);
+            return false;
+        }
+        std::setvbuf(file, nullptr, _IOFBF, BUFFER_BYTES);
+        capture = info;
+        std::vector<uint8_t> header(CAPTURE_HEADER_BYTES, 0);
+        encode_header(info, header.data());
+        if (std::fwrite(header.data(), 1, header.size(), file) != header.size()) {
+            error = path + ": " + std::strerror(errno);
+            close();
+            return false;
+        }
+        start_clock();
+        return true;
+    }
+
+    /**
+     * append(): Continue an existing container after its last good chunk
+     *
+     * A torn final chunk and the old index/footer are cut off; new chunks
+     * continue the block numbering and the timestamps (same time origin).
+     *
+     * @param info: Receives the container's recording parameters
+     * @param error: Reason on failure
+     */
+    bool append(const std::string& path, CaptureInfo& info, std::string& error) {
+        uint64_t keep_bytes = 0;
+        {
+            CaptureReader reader;
+            if (!reader.open(path, error)) return false;
+            info = capture = reader.info();
+            entries.assign(reader.entries(), reader.entries() + reader.num_chunks());
+            keep_bytes = reader.chunk_offset(reader.num_chunks());
+        }
+        next_block = entries.empty() ? 0 : entries.back().block_number + 1;
+        if (truncate(path.c_str(), static_cast<off_t>(keep_bytes)) != 0 ||
+            !(file = std::fopen(path.c_str(), "ab"))) {
+            error = path + ": " + std::strerror(errno);
+            close();
+            return false;
+        }
+        std::setvbuf(file, nullptr, _IOFBF, BUFFER_BYTES);
+        start_clock();
+        return true;
+    }
+
+    /**
+     * write(): Append one block as a chunk (format and size must match
+     * the container)
+     * @return: false on a write error or mismatched block
+     */
+    bool write(const SampleBlock& block) {
+        if (!file || block.size() != capture.block_samples ||
+            (block.format == SampleFormat::SC8) != (capture.format == SampleFormat::SC8)) {
+            return false;
+        }
+        ChunkHeader header;
+        header.magic = CHUNK_MAGIC;
+        header.block_number = next_block;
+        header.timestamp = clock_origin + std::chrono::duration<double>(block.timestamp - clock_anchor).count();
+        const void* payload;
+        if (block.format == SampleFormat::SC8) {
+            payload = block.samples_sc8.data();
+            header.avg_power = static_cast<float>(avg_power_sc8(block.samples_sc8.data(), block.size(),
+                                                                capture.int_scale));
+            header.peak_power = block_peak_sc8(block.samples_sc8.data(), block.size(), capture.int_scale);
+        } else {
+            payload = block.samples.data();
+            header.avg_power = static_cast<float>(avg_power_fc32(block.samples.data(), block.size()));
+            header.peak_power = block_peak_fc32(block.samples.data(), block.size());
+        }
+        header.crc = chunk_crc(header, payload, capture.payload_bytes());
+        return put_chunk(header, payload);
+    }
+
+    /**
+     * copy_chunk(): Append a chunk taken from another container with the
+     * same parameters (header, numbering and checksum kept as they are)
+     */
+    bool copy_chunk(const uint8_t* chunk) {
+        ChunkHeader header;
+        std::memcpy(&header, chunk, sizeof(header));
+        return put_chunk(header, chunk + sizeof(ChunkHeader));
+    }
+
+    /**
+     * close(): Write the trailing index and footer, then close the file
+     * @return: false if anything failed to reach the file
+     */
+    bool close() {
+        if (!file) return true;
+        bool ok = !failed;
+        CaptureFooter footer;
+        std::memset(&footer, 0, sizeof(footer));
+        std::memcpy(footer.magic, CAPTURE_FOOTER_MAGIC, sizeof(footer.magic));
+        footer.index_offset = CAPTURE_HEADER_BYTES + entries.size() * capture.chunk_bytes();
+        footer.count = entries.size();
+        footer.index_crc = crc32c(0, entries.data(), entries.size() * sizeof(PowerIndexEntry));
+        footer.footer_crc = crc32c(0, &footer, offsetof(CaptureFooter, footer_crc));
+        if (ok) {
+            ok = std::fwrite(entries.data(), sizeof(PowerIndexEntry), entries.size(), file) == entries.size()
+              && std::fwrite(&footer, sizeof(footer), 1, file) == 1;
+        }
+        ok = (std::fclose(file) == 0) && ok;
+        file = nullptr;
+        return ok;
+    }
+
+    uint64_t chunks() const { return entries.size(); }
+    uint64_t bytes() const { return CAPTURE_HEADER_BYTES + entries.size() * capture.chunk_bytes(); }
+
+private:
+    static int64_t unix_now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // Timestamps: seconds since start_unix_ns, advanced with the steady clock
+    void start_clock() {
+        clock_anchor = std::chrono::steady_clock::now();
+        clock_origin = (unix_now_ns() - capture.start_unix_ns) / 1e9;
+    }
+
+    static void encode_header(const CaptureInfo& info, uint8_t* out) {
+        CaptureFileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+        header.version = CAPTURE_VERSION;
+        header.sc8 = (info.format == SampleFormat::SC8) ? 1 : 0;
+        header.block_samples = info.block_samples;
+        header.chunk_bytes = info.chunk_bytes();
+        header.rx_freq = info.rx_freq;
+        header.rx_rate = info.rx_rate;
+        header.rx_gain = info.rx_gain;
+        header.int_scale = info.int_scale;
+        header.start_unix_ns = info.start_unix_ns;
+        header.header_crc = crc32c(0, &header, offsetof(CaptureFileHeader, header_crc));
+        std::memcpy(out, &header, sizeof(header));
+    }
+
+    bool put_chunk(const ChunkHeader& header, const void* payload) {
+        if (!file || failed) return false;
+        const size_t payload_bytes = capture.payload_bytes();
+        if (std::fwrite(&header, sizeof(header), 1, file) != 1 ||
+            std::fwrite(payload, 1, payload_bytes, file) != payload_bytes) {
+            failed = true;
+            return false;
+        }
+        PowerIndexEntry entry;
+        entry.block_number = header.block_number;
+        entry.timestamp = header.timestamp;
+        entry.file_offset = bytes();
+        entry.avg_power = header.avg_power;
+        entry.peak_power = header.peak_power;
+        entries.push_back(entry);
+        next_block = header.block_number + 1;
+        if (entries.size() % FLUSH_CHUNKS == 0 && std::fflush(file) != 0) failed = true;
+        return !failed;
+    }
+
+    std::FILE* file = nullptr;
+    CaptureInfo capture;
+    std::vector<PowerIndexEntry> entries;   // Trailing index, written on close
+    uint64_t next_block = 0;
+    bool failed = false;
+    std::chrono::steady_clock::time_point clock_anchor;
+    double clock_origin = 0.0;
+};
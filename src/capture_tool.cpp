@@ -0,0 +1,803 @@
+/*
+ * EEL6528 Lab 1: Offline capture processing
+ *
+ * Works on capture containers written by `lab1 --record=<file>` (see
+ * capture_file.hpp), which carry their recording parameters, chunk
+ * checksums and power index, and on headerless sample dumps (format given
+ * with the format options). No hardware or UHD is required, and nothing is
+ * paced at the radio's rate: a file is processed as fast as memory or disk
+ * allows.
+ *
+ * COMMANDS:
+ * - info: recording parameters and index summary of a container; reports
+ *   whether the index had to be rebuilt after a crash.
+ * - batch: per-block average power of every block in the file, identical to
+ *   what processing_thread reports live, printed in block order. The file
+ *   is memory-mapped and split into chunks of consecutive blocks; worker
+ *   threads take chunks as they become free (map), and the chunk results
+ *   are put back in order with a ReorderBuffer and folded into the summary
+ *   (reduce). The summary is the same for any thread count. Container
+ *   chunks are checked against their CRC-32C on the way.
+ * - index: build the per-block power index (<file>.idx, see
+ *   power_index.hpp) of a headerless dump, with the same parallel pass.
+ *   Containers have theirs built in.
+ * - query: find blocks by time range and/or power threshold from the
+ *   index alone, print them as runs of consecutive blocks, and optionally
+ *   extract just those blocks into a new capture. The IQ is never scanned.
+ * - trend: min / mean / max per second, minute or hour of a series in
+ *   the trend files written by `lab1 --history=<dir>` (see
+ *   rollup_store.hpp), e.g. <dir>/power.rollup.
+ *
+ * COMPILATION:
+ * g++ -std=c++17 -O3 -pthread -o capture_tool capture_tool.cpp   (or: make capture_tool)
+ *
+ * USAGE:
+ * ./capture_tool info <file>
+ * ./capture_tool batch <file> [--format=fc32|sc8] [--sc8-peak=<0..1>] [--block=<samples>]
+ *                             [--threads=<N>] [--chunk-blocks=<N>] [--rate=<Hz>] [--stats] [--quiet]
+ * ./capture_tool index <file> [format options] [--rate=<Hz>] [--index=<file>]
+ * ./capture_tool query <file> [--index=<file>] [--from=<s>] [--to=<s>] [--above-db=<dB>] [--peak]
+ *                             [--extract=<file>]
+ * ./capture_tool trend <series.rollup> [--tier=second|minute|hour] [--from=<s>] [--to=<s>]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sample_format.hpp"
+#include "sample_block.hpp"
+#include "dsp_stages.hpp"
+#include "capture_file.hpp"
+#include "power_index.hpp"
+#include "rollup_store.hpp"
+
+// ============================================================================
+// OPTIONS
+// ============================================================================
+
+/**
+ * ToolOptions: --name=value flags shared by all commands
+ *
+ * - format / sc8_peak / block (headerless dumps only; containers record
+ *   them): host format, sc8 peak (--wire / --sc8-peak of the live run)
+ *   and samples per block (SAMPLES_PER_BLOCK)
+ * - threads: batch workers (default: one per core)
+ * - chunk_blocks: consecutive blocks handed to a worker at a time
+ * - rate: sampling rate of the capture, only used to report how much
+ *   faster than real time the batch ran
+ * - stats: also report the peak sample power of each block
+ * - quiet: summary only, no per-block lines
+ * - index: power index file (default <capture>.idx)
+ * - from / to: query time range in seconds from block 0; for trend, in
+ *   seconds before the newest point (default: all the tier retains)
+ * - above_db: query threshold on the block average power (dB, fc32
+ *   units: 10*log10(avg_power)); with peak, on the peak sample power
+ * - extract: write the blocks a query selects to a new capture (container,
+ *   or dump + index)
+ * - tier: trend resolution
+ */
+struct ToolOptions {
+    SampleFormat format = SampleFormat::FC32;   // --format=fc32|sc8
+    double sc8_peak = 1.0;                      // --sc8-peak=<0..1>
+    size_t block = 10000;                       // --block=<samples>
+    size_t threads = 0;                         // --threads=<N> (0 = one per core)
+    size_t chunk_blocks = 64;                   // --chunk-blocks=<N>
+    double rate = 0.0;                          // --rate=<Hz> (0 = unknown)
+    bool stats = false;                         // --stats
+    bool quiet = false;                         // --quiet
+    std::string index;                          // --index=<file> (default <capture>.idx)
+    double from = 0.0;                          // --from=<s>
+    double to = 0.0;                            // --to=<s> (0 = end of capture)
+    double above_db = -400.0;                   // --above-db=<dB> (default: every block)
+    bool peak = false;                          // --peak
+    std::string extract;                        // --extract=<file>
+    RollupTier tier = RollupTier::MINUTE;       // --tier=second|minute|hour
+};
+
+ToolOptions options;
+
+/**
+ * apply_option(): Apply one --name=value flag
+ * @return: false if the flag or its value is not recognized (numeric values
+ *          are converted with std::stod / std::stoul, which may throw)
+ */
+bool apply_option(const std::string& arg) {
+    size_t eq = arg.find('=');
+    std::string name = arg.substr(2, eq == std::string::npos ? std::string::npos : eq - 2);
+    std::string value = (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+
+    if (name == "format") {
+        if (value == "fc32") { options.format = SampleFormat::FC32; return true; }
+        if (value == "sc8")  { options.format = SampleFormat::SC8;  return true; }
+        return false;
+    }
+    if (name == "sc8-peak") {
+        options.sc8_peak = std::stod(value);
+        return options.sc8_peak > 0.0 && options.sc8_peak <= 1.0;
+    }
+    if (name == "block") {
+        options.block = std::stoul(value);
+        return options.block > 0;
+    }
+    if (name == "threads") {
+        options.threads = std::stoul(value);
+        return options.threads > 0;
+    }
+    if (name == "chunk-blocks") {
+        options.chunk_blocks = std::stoul(value);
+        return options.chunk_blocks > 0;
+    }
+    if (name == "rate") {
+        options.rate = std::stod(value);
+        return options.rate > 0.0;
+    }
+    if (name == "stats") {
+        options.stats = true;
+        return value.empty();
+    }
+    if (name == "quiet") {
+        options.quiet = true;
+        return value.empty();
+    }
+    if (name == "index") {
+        options.index = value;
+        return !value.empty();
+    }
+    if (name == "from") {
+        options.from = std::stod(value);
+        return options.from >= 0.0;
+    }
+    if (name == "to") {
+        options.to = std::stod(value);
+        return options.to > 0.0;
+    }
+    if (name == "above-db") {
+        options.above_db = std::stod(value);
+        return true;
+    }
+    if (name == "peak") {
+        options.peak = true;
+        return value.empty();
+    }
+    if (name == "extract") {
+        options.extract = value;
+        return !value.empty();
+    }
+    if (name == "tier") {
+        return parse_rollup_tier(value, options.tier);
+    }
+    return false;
+}
+
+/**
+ * parse_option(): apply_option() with malformed numbers (--flag-db=abc,
+ * out-of-range values) reported as an unrecognized value
+ * @param arg: Command line argument starting with "--"
+ * @return: false if the flag or its value is not recognized
+ */
+bool parse_option(const std::string& arg) {
+    try {
+        return apply_option(arg);
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// ============================================================================
+// BATCH: PARALLEL MAP-REDUCE OVER BLOCKS
+// ============================================================================
+
+/**
+ * BatchSummary: reduction over any run of blocks (mergeable)
+ */
+struct BatchSummary {
+    uint64_t blocks = 0;
+    double sum_power = 0.0;             // Sum of block average powers
+    double min_power = std::numeric_limits<double>::infinity();
+    double max_power = 0.0;
+    uint64_t max_block = 0;             // Block with the largest average power
+    double peak_sample = 0.0;           // Largest |x|^2 seen (--stats)
+    uint64_t corrupt = 0;               // Container chunks failing their checksum
+
+    void add(uint64_t block, double power, double peak) {
+        blocks++;
+        sum_power += power;
+        min_power = std::min(min_power, power);
+        if (power > max_power || blocks == 1) {
+            max_power = power;
+            max_block = block;
+        }
+        peak_sample = std::max(peak_sample, peak);
+    }
+
+    void merge(const BatchSummary& other) {
+        if (other.blocks == 0) return;
+        if (other.max_power > max_power || blocks == 0) {
+            max_power = other.max_power;
+            max_block = other.max_block;
+        }
+        blocks += other.blocks;
+        sum_power += other.sum_power;
+        min_power = std::min(min_power, other.min_power);
+        peak_sample = std::max(peak_sample, other.peak_sample);
+        corrupt += other.corrupt;
+    }
+};
+
+/**
+ * ChunkResult: per-block values and partial summary of one chunk
+ */
+struct ChunkResult {
+    uint64_t first_block = 0;
+    std::vector<double> power;          // Average power per block
+    std::vector<double> peak;           // Peak |x|^2 per block (--stats)
+    std::vector<uint8_t> corrupt;       // 1 = chunk failed its checksum
+    BatchSummary summary;
+};
+
+/**
+ * block_peak_power(): Largest |x|^2 in a captured block (fc32 units)
+ */
+double block_peak_power(const CaptureView& view, uint64_t index) {
+    const uint8_t* block = view.block(index);
+    if (view.format == SampleFormat::SC8) {
+        return block_peak_sc8(reinterpret_cast<const std::complex<int8_t>*>(block), view.block_samples,
+                              view.int_scale);
+    }
+    return block_peak_fc32(reinterpret_cast<const std::complex<float>*>(block), view.block_samples);
+}
+
+/**
+ * map_chunk(): Process blocks [first, first + count) of the capture
+ * (container chunks are checked against their CRC first)
+ * @param with_peak: Also compute the peak sample power of each block
+ */
+ChunkResult map_chunk(const CaptureView& view, uint64_t first, uint64_t count, bool with_peak) {
+    ChunkResult result;
+    result.first_block = first;
+    result.power.resize(count);
+    result.corrupt.assign(count, 0);
+    if (with_peak) result.peak.resize(count);
+    for (uint64_t k = 0; k < count; k++) {
+        if (!verify_chunk(view, first + k)) {
+            result.corrupt[k] = 1;
+            result.summary.corrupt++;
+        }
+        result.power[k] = capture_block_power(view, first + k);
+        double peak = 0.0;
+        if (with_peak) peak = result.peak[k] = block_peak_power(view, first + k);
+        result.summary.add(first + k, result.power[k], peak);
+    }
+    return result;
+}
+
+/**
+ * map_reduce_capture(): Run map_chunk over the whole capture in parallel and
+ * hand the chunk results to reduce() in file order
+ * @param with_peak: Passed to map_chunk
+ * @param reduce: Called once per chunk, in order, never concurrently
+ * @return: Elapsed wall time (s)
+ */
+double map_reduce_capture(const CaptureView& view, bool with_peak,
+                          const std::function<void(ChunkResult&)>& reduce) {
+    const uint64_t num_chunks = (view.num_blocks + options.chunk_blocks - 1) / options.chunk_blocks;
+    size_t threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<size_t>(std::min<uint64_t>(threads, std::max<uint64_t>(num_chunks, 1)));
+    std::cerr << "Capture: " << view.num_blocks << " blocks of " << view.block_samples << " "
+              << (view.format == SampleFormat::SC8 ? "sc8" : "fc32") << " samples, "
+              << num_chunks << " chunks, " << threads << " threads" << std::endl;
+
+    // Reduce: chunks are folded in file order, so results do not depend on
+    // which worker finished first
+    ReorderBuffer<ChunkResult> ordered([&reduce](uint64_t, ChunkResult& chunk) { reduce(chunk); });
+
+    // Map: each worker claims the next unprocessed chunk until none are left
+    std::atomic<uint64_t> next_chunk(0);
+    auto worker = [&]() {
+        for (uint64_t c = next_chunk++; c < num_chunks; c = next_chunk++) {
+            const uint64_t first = c * options.chunk_blocks;
+            const uint64_t count = std::min<uint64_t>(options.chunk_blocks, view.num_blocks - first);
+            ordered.push(c, map_chunk(view, first, count, with_peak));
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; t++) pool.emplace_back(worker);
+    for (auto& t : pool) t.join();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * OpenCapture: a capture opened as a container, or as a headerless dump
+ */
+struct OpenCapture {
+    CaptureReader container;
+    MappedFile raw;
+    bool is_container = false;
+    CaptureView view;
+};
+
+/**
+ * print_capture_info(): Recording parameters of a container
+ */
+void print_capture_info(const std::string& path, const CaptureReader& reader) {
+    const CaptureInfo& info = reader.info();
+    const double duration = reader.num_chunks() * info.block_samples / std::max(info.rx_rate, 1.0);
+    std::cerr << std::fixed << path << ": " << reader.num_chunks() << " chunks of " << info.block_samples
+              << " " << (info.format == SampleFormat::SC8 ? "sc8" : "fc32") << " samples ("
+              << std::setprecision(1) << duration << " s)" << std::endl
+              << "  RX: " << std::setprecision(6) << info.rx_freq / 1e9 << " GHz, "
+              << info.rx_rate / 1e6 << " MS/s, gain " << std::setprecision(1) << info.rx_gain << " dB";
+    if (info.format == SampleFormat::SC8) {
+        std::cerr << ", sc8 peak " << std::setprecision(3) << info.int_scale * SC8_FULL_SCALE;
+    }
+    const time_t start = static_cast<time_t>(info.start_unix_ns / 1000000000);
+    char when[64];
+    std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S UTC", std::gmtime(&start));
+    std::cerr << std::endl << "  Started: " << when << std::endl
+              << "  Index: " << (reader.index_recovered()
+                                   ? "rebuilt from chunk headers (not closed cleanly)" : "trailing index");
+    if (reader.torn_bytes() > 0) {
+        std::cerr << ", " << reader.torn_bytes() << " bytes after the last good chunk ignored";
+    }
+    std::cerr << std::endl;
+}
+
+/**
+ * open_capture(): Open a container (settings from its header) or a
+ * headerless dump (settings from the format options)
+ */
+bool open_capture(const std::string& path, OpenCapture& capture) {
+    std::string error;
+    if (capture.container.open(path, error)) {
+        capture.is_container = true;
+        capture.view = capture.container.view();
+        print_capture_info(path, capture.container);
+        return true;
+    }
+    if (error != "not a capture container") {
+        std::cerr << "Cannot open capture: " << error << std::endl;
+        return false;
+    }
+    if (!capture.raw.open(path, error)) {
+        std::cerr << "Cannot open capture: " << error << std::endl;
+        return false;
+    }
+    const float scale = static_cast<float>(options.sc8_peak / SC8_FULL_SCALE);
+    capture.view = view_capture(capture.raw, options.format, scale, options.block);
+    if (capture.raw.size() % capture.view.block_bytes() != 0) {
+        std::cerr << "Ignoring " << capture.raw.size() % capture.view.block_bytes()
+                  << " trailing bytes (partial block)" << std::endl;
+    }
+    return true;
+}
+
+/**
+ * print_chunk(): Block lines in the same layout as lab1's result lines
+ */
+void print_chunk(const ChunkResult& chunk) {
+    std::cout << std::fixed << std::setprecision(8);
+    for (size_t k = 0; k < chunk.power.size(); k++) {
+        std::cout << "Block #" << std::setw(6) << chunk.first_block + k
+                  << " | Avg Power:  " << std::setw(13) << chunk.power[k];
+        if (options.stats) {
+            std::cout << " | Peak: " << std::setw(13) << chunk.peak[k];
+        }
+        std::cout << (chunk.corrupt[k] ? " [CHECKSUM ERROR]" : "") << '\n';
+    }
+}
+
+/**
+ * run_batch(): batch command
+ */
+int run_batch(const std::string& path) {
+    OpenCapture capture;
+    if (!open_capture(path, capture)) return 1;
+    const CaptureView& view = capture.view;
+
+    BatchSummary total;
+    const double seconds = map_reduce_capture(view, options.stats, [&total](ChunkResult& chunk) {
+        if (!options.quiet) print_chunk(chunk);
+        total.merge(chunk.summary);
+    });
+    std::cout.flush();
+
+    const uint64_t samples = total.blocks * view.block_samples;
+    const double bytes = static_cast<double>(total.blocks) * view.block_bytes();
+    std::cerr << std::fixed << std::setprecision(8)
+              << "\n=== Batch Summary ===" << std::endl
+              << "Blocks: " << total.blocks << " (" << samples << " samples)" << std::endl
+              << "Mean block power: " << (total.blocks ? total.sum_power / total.blocks : 0.0)
+              << " (min " << (total.blocks ? total.min_power : 0.0) << ", max " << total.max_power
+              << " in block #" << total.max_block << ")" << std::endl;
+    if (options.stats) {
+        std::cerr << "Peak sample power: " << total.peak_sample << std::endl;
+    }
+    if (capture.is_container) {
+        std::cerr << "Checksums: " << total.blocks - total.corrupt << " chunks OK, " << total.corrupt
+                  << " corrupt" << std::endl;
+    }
+    std::cerr << std::setprecision(3) << "Elapsed: " << seconds << " s, "
+              << std::setprecision(1) << samples / std::max(seconds, 1e-9) / 1e6 << " MS/s, "
+              << std::setprecision(2) << bytes / std::max(seconds, 1e-9) / 1e9 << " GB/s";
+    if (options.rate > 0.0) {
+        std::cerr << std::setprecision(1) << " (" << samples / options.rate / std::max(seconds, 1e-9)
+                  << "x real time)";
+    }
+    std::cerr << std::endl;
+    return total.corrupt ? 2 : 0;
+}
+
+// ============================================================================
+// INDEX: BUILD THE POWER INDEX OF AN EXISTING CAPTURE
+// ============================================================================
+
+/**
+ * run_index(): index command (for headerless dumps; containers carry
+ * their own index)
+ *
+ * Timestamps are block_number * block / rate; without --rate they are 0
+ * and only power queries are meaningful.
+ */
+int run_index(const std::string& path) {
+    OpenCapture capture;
+    if (!open_capture(path, capture)) return 1;
+    if (capture.is_container) {
+        std::cerr << "Capture containers have a built-in index; nothing to do" << std::endl;
+        return 0;
+    }
+    const CaptureView& view = capture.view;
+    if (options.rate <= 0.0) {
+        std::cerr << "No --rate given: timestamps will be 0" << std::endl;
+    }
+
+    const std::string index_path = options.index.empty() ? index_path_for(path) : options.index;
+    PowerIndexWriter writer;
+    std::string error;
+    if (!writer.open(index_path, make_index_header(view.format == SampleFormat::SC8, view.block_samples,
+                                                   options.rate, view.int_scale, 0), error)) {
+        std::cerr << "Cannot create index: " << error << std::endl;
+        return 1;
+    }
+
+    bool ok = true;
+    const double seconds = map_reduce_capture(view, true, [&](ChunkResult& chunk) {
+        for (size_t k = 0; k < chunk.power.size(); k++) {
+            const uint64_t block = chunk.first_block + k;
+            PowerIndexEntry entry;
+            entry.block_number = block;
+            entry.timestamp = options.rate > 0.0 ? block * view.block_samples / options.rate : 0.0;
+            entry.file_offset = block * view.block_bytes();
+            entry.avg_power = static_cast<float>(chunk.power[k]);
+            entry.peak_power = static_cast<float>(chunk.peak[k]);
+            ok = writer.append(entry) && ok;
+        }
+    });
+    writer.close();
+    if (!ok) {
+        std::cerr << "Index write failed: " << index_path << std::endl;
+        return 1;
+    }
+    std::cerr << "Indexed " << writer.size() << " blocks into " << index_path << " in "
+              << std::fixed << std::setprecision(3) << seconds << " s" << std::endl;
+    return 0;
+}
+
+// ============================================================================
+// QUERY: FIND AND EXTRACT BLOCKS USING THE INDEX ONLY
+// ============================================================================
+
+/**
+ * BlockRun: consecutive matching blocks, reported as one range
+ */
+struct BlockRun {
+    uint64_t first = 0;                 // First index entry of the run
+    uint64_t count = 0;
+    float max_avg = 0.0f;
+    float max_peak = 0.0f;
+};
+
+inline double power_db(double power) {
+    return 10.0 * std::log10(std::max(power, 1e-30));
+}
+
+/**
+ * extract_chunks(): Copy the selected chunks of a container into a new
+ * container (same recording parameters, chunks copied verbatim)
+ */
+int extract_chunks(const CaptureReader& container, const PowerIndexView& index,
+                   const std::vector<BlockRun>& runs) {
+    CaptureWriter writer;
+    std::string error;
+    if (!writer.create(options.extract, container.info(), error)) {
+        std::cerr << "Cannot create " << options.extract << ": " << error << std::endl;
+        return 1;
+    }
+    bool ok = true;
+    for (const BlockRun& run : runs) {
+        for (uint64_t i = run.first; i < run.first + run.count && ok; i++) {
+            ok = writer.copy_chunk(container.mapping().data() + index.entries[i].file_offset);
+        }
+    }
+    ok = writer.close() && ok;
+    if (!ok) {
+        std::cerr << "Extraction failed" << std::endl;
+        return 1;
+    }
+    std::cerr << "Extracted " << writer.chunks() << " chunks (" << std::fixed << std::setprecision(1)
+              << writer.bytes() / 1e6 << " MB) to " << options.extract << std::endl;
+    return 0;
+}
+
+/**
+ * extract_blocks(): Copy the selected blocks of a headerless dump into a
+ * new dump with its own side index
+ */
+int extract_blocks(const std::string& path, const PowerIndexView& index,
+                   const std::vector<BlockRun>& runs, uint64_t block_bytes) {
+    std::string error;
+    MappedFile capture;
+    if (!capture.open(path, error)) {
+        std::cerr << "Cannot open capture: " << error << std::endl;
+        return 1;
+    }
+    std::FILE* out = std::fopen(options.extract.c_str(), "wb");
+    PowerIndexWriter out_index;
+    if (!out || !out_index.open(index_path_for(options.extract), *index.header, error)) {
+        std::cerr << "Cannot create " << options.extract << ": " << (out ? error : std::strerror(errno)) << std::endl;
+        if (out) std::fclose(out);
+        return 1;
+    }
+    uint64_t written = 0;
+    bool ok = true;
+    for (const BlockRun& run : runs) {
+        for (uint64_t i = run.first; i < run.first + run.count && ok; i++) {
+            PowerIndexEntry entry = index.entries[i];
+            if (entry.file_offset + block_bytes > capture.size()) {
+                std::cerr << "Index entry for block " << entry.block_number << " is past the end of the capture" << std::endl;
+                ok = false;
+                break;
+            }
+            ok = std::fwrite(capture.data() + entry.file_offset, 1, block_bytes, out) == block_bytes;
+            entry.file_offset = written;
+            ok = ok && out_index.append(entry);
+            written += block_bytes;
+        }
+    }
+    ok = (std::fclose(out) == 0) && ok;
+    out_index.close();
+    if (!ok) {
+        std::cerr << "Extraction failed" << std::endl;
+        return 1;
+    }
+    std::cerr << "Extracted " << out_index.size() << " blocks (" << std::fixed << std::setprecision(1) << written / 1e6
+              << " MB) to " << options.extract << " (+ " << index_path_for(options.extract) << ")" << std::endl;
+    return 0;
+}
+
+/**
+ * run_query(): query command
+ *
+ * Selects entries in [--from, --to) seconds whose average power (or peak,
+ * with --peak) is at least --above-db dB, using a binary search on the
+ * timestamps and a scan of the selected entries only. Matching blocks are
+ * printed as runs; --extract copies just those blocks out of the capture
+ * into a new capture of the same kind (original block numbers kept).
+ * Containers use their built-in index, headerless dumps the .idx side file.
+ */
+int run_query(const std::string& path) {
+    // Containers carry their index; headerless dumps use the side file
+    CaptureReader container;
+    MappedFile index_file;
+    PowerIndexView index;
+    std::string error;
+    uint64_t block_bytes = 0;
+    if (container.open(path, error)) {
+        index.entries = container.entries();
+        index.count = container.num_chunks();
+        block_bytes = container.info().payload_bytes();
+        if (container.index_recovered()) {
+            std::cerr << "Note: " << path << " was not closed cleanly; index rebuilt from "
+                      << index.count << " chunk headers" << std::endl;
+        }
+    } else if (error != "not a capture container") {
+        std::cerr << "Cannot open capture: " << error << std::endl;
+        return 1;
+    } else {
+        const std::string index_path = options.index.empty() ? index_path_for(path) : options.index;
+        if (!index_file.open(index_path, error) ||
+            !view_power_index(index_file.data(), index_file.size(), index, error)) {
+            std::cerr << "Cannot read index " << index_path << ": " << error
+                      << " (build one with: capture_tool index " << path << ")" << std::endl;
+            return 1;
+        }
+        block_bytes = index.header->block_samples *
+            (index.header->sc8 ? sizeof(std::complex<int8_t>) : sizeof(std::complex<float>));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    const uint64_t begin = index.first_at_or_after(options.from);
+    const uint64_t end = (options.to > 0.0) ? index.first_at_or_after(options.to) : index.count;
+    const double threshold = std::pow(10.0, options.above_db / 10.0);
+    const bool by_power = options.above_db > -300.0;
+
+    std::vector<BlockRun> runs;
+    uint64_t matched = 0;
+    for (uint64_t i = begin; i < end; i++) {
+        const PowerIndexEntry& e = index.entries[i];
+        const double level = options.peak ? e.peak_power : e.avg_power;
+        if (by_power && level < threshold) continue;
+        matched++;
+        if (runs.empty() || runs.back().first + runs.back().count != i ||
+            index.entries[i - 1].block_number + 1 != e.block_number) {
+            runs.push_back(BlockRun());
+            runs.back().first = i;
+        }
+        BlockRun& run = runs.back();
+        run.count++;
+        run.max_avg = std::max(run.max_avg, e.avg_power);
+        run.max_peak = std::max(run.max_peak, e.peak_power);
+    }
+    const double search_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::fixed;
+    for (const BlockRun& run : runs) {
+        const PowerIndexEntry& first = index.entries[run.first];
+        const PowerIndexEntry& last = index.entries[run.first + run.count - 1];
+        std::cout << "Blocks " << std::setw(8) << first.block_number << " - " << std::setw(8) << last.block_number
+                  << " | " << std::setprecision(3) << std::setw(10) << first.timestamp << " s - "
+                  << std::setw(10) << last.timestamp << " s | Offset " << first.file_offset
+                  << " | Max Avg: " << std::setprecision(1) << power_db(run.max_avg) << " dB"
+                  << " | Max Peak: " << power_db(run.max_peak) << " dB" << std::endl;
+    }
+    std::cerr << "Query: " << matched << " of " << index.count << " blocks in " << runs.size()
+              << " runs (" << std::setprecision(1) << matched * block_bytes / 1e6 << " MB of IQ); "
+              << end - begin << " index entries examined in " << std::setprecision(3)
+              << search_seconds * 1e3 << " ms" << std::endl;
+
+    if (options.extract.empty()) return 0;
+    return index.header ? extract_blocks(path, index, runs, block_bytes)
+                        : extract_chunks(container, index, runs);
+}
+
+// ============================================================================
+// TREND: ROLLUP FILES OF A LIVE RUN
+// ============================================================================
+
+/**
+ * run_trend(): trend command (one line per point, UTC times; power series
+ * also in dB)
+ */
+int run_trend(const std::string& path) {
+    RollupFile file;
+    std::string error;
+    if (!file.open(path, "", false, error)) {
+        std::cerr << "Cannot open trend file: " << error << std::endl;
+        return 1;
+    }
+    const std::string series = file.header().series;
+    const int64_t step = ROLLUP_RESOLUTION[static_cast<size_t>(options.tier)];
+    const int64_t newest = file.newest(options.tier);
+    if (newest == 0) {
+        std::cerr << series << ": no " << rollup_tier_name(options.tier) << " points" << std::endl;
+        return 0;
+    }
+    const int64_t to = newest + step - static_cast<int64_t>(options.to);
+    const int64_t from = options.from > 0.0 ? newest + step - static_cast<int64_t>(options.from)
+                                            : std::numeric_limits<int32_t>::min();
+    const std::vector<RollupPoint> points = file.points(options.tier, from, to);
+    const bool in_db = series == "power";
+
+    std::cout << std::setprecision(6);
+    for (const RollupPoint& p : points) {
+        char when[32];
+        const time_t t = static_cast<time_t>(p.start);
+        struct tm utc;
+        gmtime_r(&t, &utc);
+        std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &utc);
+        std::cout << when << " | " << std::setw(8) << p.count << " values | min " << p.min
+                  << " | mean " << p.mean << " | max " << p.max;
+        if (in_db) {
+            std::cout << std::fixed << std::setprecision(1) << " | " << power_db(p.min) << " / "
+                      << power_db(p.mean) << " / " << power_db(p.max) << " dB" << std::defaultfloat
+                      << std::setprecision(6);
+        }
+        std::cout << std::endl;
+    }
+    std::cerr << series << ": " << points.size() << " " << rollup_tier_name(options.tier) << " points" << std::endl;
+    return 0;
+}
+
+// ============================================================================
+// INFO: RECORDING PARAMETERS AND INDEX SUMMARY
+// ============================================================================
+
+/**
+ * run_info(): info command (header and built-in index of a container;
+ * reads no IQ)
+ */
+int run_info(const std::string& path) {
+    CaptureReader reader;
+    std::string error;
+    if (!reader.open(path, error)) {
+        std::cerr << "Cannot open capture: " << error << std::endl;
+        return 1;
+    }
+    print_capture_info(path, reader);
+    if (reader.num_chunks() == 0) return 0;
+
+    const PowerIndexEntry* entries = reader.entries();
+    double total = 0.0;
+    uint64_t busiest = 0, quietest = 0;
+    for (uint64_t i = 0; i < reader.num_chunks(); i++) {
+        total += entries[i].avg_power;
+        if (entries[i].avg_power > entries[busiest].avg_power) busiest = i;
+        if (entries[i].avg_power < entries[quietest].avg_power) quietest = i;
+    }
+    const PowerIndexEntry& first = entries[0];
+    const PowerIndexEntry& last = entries[reader.num_chunks() - 1];
+    std::cerr << std::fixed << "  Blocks: " << first.block_number << " - " << last.block_number
+              << " (" << std::setprecision(3) << first.timestamp << " s - " << last.timestamp << " s)"
+              << std::endl << "  Avg Power: mean " << std::setprecision(1) << power_db(total / reader.num_chunks())
+              << " dB, min " << power_db(entries[quietest].avg_power) << " dB (block "
+              << entries[quietest].block_number << "), max " << power_db(entries[busiest].avg_power)
+              << " dB (block " << entries[busiest].block_number << ")" << std::endl;
+    return 0;
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " info <file>" << std::endl
+              << "       " << program << " batch <file> [--format=fc32|sc8] [--sc8-peak=<0..1>]"
+              << " [--block=<samples>] [--threads=<N>] [--chunk-blocks=<N>] [--rate=<Hz>]"
+              << " [--stats] [--quiet]" << std::endl
+              << "       " << program << " index <file> [format options] [--rate=<Hz>] [--index=<file>]" << std::endl
+              << "       " << program << " query <file> [--index=<file>] [--from=<s>] [--to=<s>]"
+              << " [--above-db=<dB>] [--peak] [--extract=<file>]" << std::endl
+              << "       " << program << " trend <series.rollup> [--tier=second|minute|hour] [--from=<s>] [--to=<s>]"
+              << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) == 0) {
+            if (!parse_option(arg)) {
+                std::cerr << "Invalid option: " << arg << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (positional.size() == 2) {
+        if (positional[0] == "info") return run_info(positional[1]);
+        if (positional[0] == "batch") return run_batch(positional[1]);
+        if (positional[0] == "index") return run_index(positional[1]);
+        if (positional[0] == "query") return run_query(positional[1]);
+        if (positional[0] == "trend") return run_trend(positional[1]);
+    }
+    print_usage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,91 @@
+/*
+ * EEL6528 Lab 1: CRC-32C checksums for capture chunks
+ *
+ * CRC-32C (Castagnoli, reflected polynomial 0x82F63B78) detects every burst
+ * error up to 32 bits and is what the SSE4.2 crc32 instruction computes.
+ *
+ * IMPLEMENTATIONS:
+ * - SSE4.2 crc32 instruction, 8 bytes per step (~8 GB/s), selected at run
+ *   time so the binary still runs on CPUs without SSE4.2
+ * - Portable slicing-by-8 tables (~1-2 GB/s) everywhere else
+ * Both give identical results.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define CRC32C_HAVE_SSE42_PATH 1
+#endif
+
+/**
+ * Crc32cTables: slicing-by-8 lookup tables (built once)
+ */
+struct Crc32cTables {
+    uint32_t table[8][256];
+
+    Crc32cTables() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1u)));
+            table[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; i++) {
+            for (int t = 1; t < 8; t++) table[t][i] = (table[t - 1][i] >> 8) ^ table[0][table[t - 1][i] & 0xFF];
+        }
+    }
+};
+
+/**
+ * crc32c_portable(): Continue a CRC-32C over more bytes (table driven)
+ * @param crc: Running value (0 for a new checksum)
+ */
+inline uint32_t crc32c_portable(uint32_t crc, const void* data, size_t size) {
+    static const Crc32cTables tables;
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (; size >= 8; size -= 8, p += 8) {
+        uint32_t lo, hi;
+        std::memcpy(&lo, p, 4);
+        std::memcpy(&hi, p + 4, 4);
+        lo ^= crc;
+        crc = tables.table[7][lo & 0xFF] ^ tables.table[6][(lo >> 8) & 0xFF] ^
+              tables.table[5][(lo >> 16) & 0xFF] ^ tables.table[4][lo >> 24] ^
+              tables.table[3][hi & 0xFF] ^ tables.table[2][(hi >> 8) & 0xFF] ^
+              tables.table[1][(hi >> 16) & 0xFF] ^ tables.table[0][hi >> 24];
+    }
+    for (; size > 0; size--, p++) crc = (crc >> 8) ^ tables.table[0][(crc ^ *p) & 0xFF];
+    return ~crc;
+}
+
+#ifdef CRC32C_HAVE_SSE42_PATH
+__attribute__((target("sse4.2")))
+inline uint32_t crc32c_sse42(uint32_t crc, const void* data, size_t size) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint64_t c = ~crc;
+    for (; size >= 8; size -= 8, p += 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        c = _mm_crc32_u64(c, word);
+    }
+    uint32_t c32 = static_cast<uint32_t>(c);
+    for (; size > 0; size--, p++) c32 = _mm_crc32_u8(c32, *p);
+    return ~c32;
+}
+#endif
+
+/**
+ * crc32c(): Continue a CRC-32C over more bytes (fastest available path)
+ * @param crc: Running value (0 for a new checksum)
+ */
+inline uint32_t crc32c(uint32_t crc, const void* data, size_t size) {
+#ifdef CRC32C_HAVE_SSE42_PATH
+    static const bool sse42 = __builtin_cpu_supports("sse4.2");
+    if (sse42) return crc32c_sse42(crc, data, size);
+#endif
+    return crc32c_portable(crc, data, size);
+}
@@ -0,0 +1,218 @@
+/*
+ * EEL6528 Lab 1: Local control socket for runtime reconfiguration
+ *
+ * Changing the worker count or the output mode used to mean restarting
+ * the program: samples are lost and the 1 s hardware settling delay is
+ * paid again. ControlServer listens on a Unix-domain stream socket and
+ * passes each command line it receives to a handler owned by the program;
+ * the handler's answer is written back.
+ *
+ * PROTOCOL (one command per line, any number per connection):
+ *   <command> [arguments...]\n  ->  ok [details]\n  or  error: <reason>\n
+ * Answers may span several lines; the last line of every answer is "."
+ * so scripts can read until it. Usable with e.g.
+ *   echo stats | socat - UNIX-CONNECT:/tmp/lab1.sock
+ *
+ * THREADING:
+ * run() is the body of one control thread. It serves one client at a
+ * time and polls with a short timeout, so it notices shutdown without
+ * extra wakeups. Only filesystem permissions guard the socket (it is
+ * created with the process umask, local users only). A socket left at the
+ * path by an earlier run (nobody accepts connections on it) is replaced;
+ * a live socket of another instance, or any other file, is an error and
+ * never removed. close() removes the path only while it is still the
+ * socket this server bound.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <poll.h>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * split_command(): Whitespace-separated words of a command line
+ */
+inline std::vector<std::string> split_command(const std::string& line) {
+    std::istringstream in(line);
+    std::vector<std::string> words;
+    std::string word;
+    while (in >> word) words.push_back(word);
+    return words;
+}
+
+/**
+ * ControlServer: line-oriented command server on a Unix-domain socket
+ */
+class ControlServer {
+public:
+    static const int POLL_MS = 200;              // Shutdown check interval
+    static const size_t MAX_LINE = 4096;         // Longer lines are rejected
+
+    /**
+     * Handler: answer for one command (words[0] is the command name);
+     * start with "ok" or "error:"
+     */
+    using Handler = std::function<std::string(const std::vector<std::string>& words)>;
+
+    ~ControlServer() { close(); }
+
+    /**
+     * open(): Create and bind the socket, replacing a stale one
+     * @param socket_path: Filesystem path of the socket
+     * @param error: Reason on failure
+     * @return: false if the socket cannot be created
+     */
+    bool open(const std::string& socket_path, std::string& error) {
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (socket_path.size() >= sizeof(addr.sun_path)) {
+            error = "socket path too long";
+            return false;
+        }
+        std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+        listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd < 0) {
+            error = std::strerror(errno);
+            return false;
+        }
+        struct stat existing;
+        if (::lstat(socket_path.c_str(), &existing) == 0) {
+            if (!S_ISSOCK(existing.st_mode)) {
+                error = "path exists and is not a socket";
+                ::close(listen_fd);
+                listen_fd = -1;
+                return false;
+            }
+            if (!is_stale(addr, error)) {
+                ::close(listen_fd);
+                listen_fd = -1;
+                return false;
+            }
+            ::unlink(socket_path.c_str());     // Stale socket of an earlier run
+        }
+        struct stat bound;
+        if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+            ::listen(listen_fd, 4) < 0 || ::lstat(socket_path.c_str(), &bound) < 0) {
+            error = std::strerror(errno);
+            ::close(listen_fd);
+            listen_fd = -1;
+            return false;
+        }
+        path = socket_path;
+        bound_dev = bound.st_dev;
+        bound_ino = bound.st_ino;
+        return true;
+    }
+
+    /**
+     * run(): Serve clients until `stopping` is set
+     * @param stopping: Program shutdown flag
+     * @param handler: Executes one command
+     */
+    void run(const std::atomic<bool>& stopping, const Handler& handler) {
+        while (listen_fd >= 0 && !stopping.load()) {
+            if (!wait_readable(listen_fd)) continue;
+            const int client = ::accept(listen_fd, nullptr, nullptr);
+            if (client < 0) continue;
+            serve(client, stopping, handler);
+            ::close(client);
+        }
+    }
+
+    /**
+     * close(): Stop listening and remove the socket file, unless another
+     * process has put its own at the path since
+     */
+    void close() {
+        if (listen_fd < 0) return;
+        ::close(listen_fd);
+        listen_fd = -1;
+        struct stat current;
+        if (::lstat(path.c_str(), &current) == 0 &&
+            current.st_dev == bound_dev && current.st_ino == bound_ino) {
+            ::unlink(path.c_str());
+        }
+    }
+
+    bool listening() const { return listen_fd >= 0; }
+    uint64_t commands() const { return command_count.load(); }
+
+private:
+    // A socket nobody listens on (connect() refused); a live one is in use
+    static bool is_stale(const sockaddr_un& addr, std::string& error) {
+        const int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (probe < 0) {
+            error = std::strerror(errno);
+            return false;
+        }
+        const bool connected = ::connect(probe, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0;
+        const int reason = errno;
+        ::close(probe);
+        if (connected) {
+            error = "socket in use by another process";
+            return false;
+        }
+        if (reason != ECONNREFUSED) {
+            error = std::string("cannot probe the existing socket: ") + std::strerror(reason);
+            return false;
+        }
+        return true;
+    }
+
+    // Readable within POLL_MS
+    static bool wait_readable(int fd) {
+        pollfd p{fd, POLLIN, 0};
+        return ::poll(&p, 1, POLL_MS) > 0;
+    }
+
+    // One client: execute its lines until it disconnects
+    void serve(int client, const std::atomic<bool>& stopping, const Handler& handler) {
+        std::string buffer;
+        char chunk[512];
+        while (!stopping.load()) {
+            if (!wait_readable(client)) continue;
+            const ssize_t n = ::read(client, chunk, sizeof(chunk));
+            if (n <= 0) return;
+            buffer.append(chunk, static_cast<size_t>(n));
+            size_t newline;
+            while ((newline = buffer.find('\n')) != std::string::npos) {
+                const std::vector<std::string> words = split_command(buffer.substr(0, newline));
+                buffer.erase(0, newline + 1);
+                if (words.empty()) continue;
+                command_count++;
+                if (!send_all(client, handler(words) + "\n.\n")) return;
+            }
+            if (buffer.size() > MAX_LINE) {
+                send_all(client, "error: line too long\n.\n");
+                return;
+            }
+        }
+    }
+
+    static bool send_all(int fd, const std::string& text) {
+        size_t sent = 0;
+        while (sent < text.size()) {
+            const ssize_t n = ::send(fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    int listen_fd = -1;
+    std::string path;
+    dev_t bound_dev = 0;                         // Identity of the socket file we bound
+    ino_t bound_ino = 0;
+    std::atomic<uint64_t> command_count{0};
+};
@@ -0,0 +1,753 @@
+/*
+ * EEL6528 Lab 1: DSP stage benchmarks
+ *
+ * Stand-alone checks and timings for the processing stages used by lab1.cpp.
+ * No hardware or UHD is required; every section generates its own
+ * synthetic stream.
+ *
+ * SECTIONS:
+ * - ordered: channel selector (mixer + lowpass FIR) run over blocks in
+ *   parallel with overlap-save history, put back in order with a
+ *   ReorderBuffer. Verifies the output is bit-identical to one sequential
+ *   pass over the whole stream and reports the speedup per worker count.
+ * - fastconv: direct FIR vs FFT overlap-save across tap counts, for one
+ *   filter and for a bank of filters sharing each forward transform.
+ *   Reports the crossover tap count and the FFT error vs direct.
+ * - resample: polyphase rational resampler throughput on one core for the
+ *   conversions lab1 needs (N210 rates -> OFDM / DSSS rates), and a check
+ *   that block-by-block output equals one pass over the whole stream.
+ * - iqcorr: DC / IQ-imbalance corrector cost per sample (fc32 and sc8),
+ *   convergence of its estimates and the image rejection it achieves on
+ *   a tone with known impairments.
+ * - bursts: burst segmenter on a sparse stream with bursts placed across
+ *   block boundaries; checks one record per burst, reports the data
+ *   reduction and the cost per sample.
+ * - tones: Goertzel bank vs one FFT of the block across bin counts.
+ *   Reports the crossover bin count, the bank's error against a direct
+ *   DFT and the frequency offset the tracker measures on a detuned tone.
+ * - magnitude: approximate |x| (alpha-max-plus-beta-min, polynomial
+ *   sqrt) and fast dB conversion against std::abs() / std::log10():
+ *   measured worst-case error and cost per value.
+ *
+ * COMPILATION:
+ * g++ -std=c++17 -O3 -pthread -o dsp_bench dsp_bench.cpp   (or: make bench)
+ *
+ * USAGE:
+ * ./dsp_bench [section]    (default: run every section)
+ */
+
+#include <atomic>
+#include <chrono>
+#include <complex>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sample_block.hpp"
+#include "dsp_stages.hpp"
+#include "fast_convolution.hpp"
+#include "resampler.hpp"
+#include "iq_correction.hpp"
+#include "burst_segmenter.hpp"
+#include "goertzel_bank.hpp"
+#include "fast_magnitude.hpp"
+
+// ============================================================================
+// BENCHMARK CONFIGURATION
+// ============================================================================
+
+const size_t BLOCK_SIZE = 10000;          // Same block size as lab1.cpp
+const size_t NUM_BLOCKS = 200;            // 2 M samples per run
+const double TONE_FREQ = 0.05;            // Test tone (fraction of the rate)
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+/**
+ * make_stream(): Tone plus uniform noise, deterministic for a given seed
+ */
+std::vector<std::complex<float>> make_stream(size_t count, uint64_t seed) {
+    std::vector<std::complex<float>> stream(count);
+    uint64_t state = seed * 0x9E3779B97F4A7C15ull + 1;
+    auto noise = [&state]() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return static_cast<float>((state >> 11) * (1.0 / 9007199254740992.0) - 0.5) * 0.02f;
+    };
+    for (size_t i = 0; i < count; i++) {
+        double phase = 2.0 * DSP_PI * TONE_FREQ * i;
+        stream[i] = std::complex<float>(0.1f * std::cos(phase) + noise(),
+                                        0.1f * std::sin(phase) + noise());
+    }
+    return stream;
+}
+
+/**
+ * seconds_since(): Wall time elapsed since start
+ */
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ============================================================================
+// ORDERED PARALLEL CHANNEL SELECTION
+// ============================================================================
+
+/**
+ * bench_ordered(): Sequential reference vs W workers with overlap-save
+ *
+ * Reference: the whole stream mixed in one pass, then filtered in one pass
+ * with zero initial state. Parallel run: blocks carry their sample_offset
+ * and the previous (taps - 1) raw samples, workers pull the next block
+ * from a shared counter, and a ReorderBuffer writes results in order.
+ * Speedup is relative to one worker: the single-pass reference walks a
+ * 16 MB buffer once per tap and is not a fair (cache-blocked) baseline.
+ */
+void bench_ordered() {
+    const size_t NUM_TAPS = 129;
+    const double MIX_FREQ = TONE_FREQ;
+    const double CUTOFF = 0.2;
+    const size_t total = BLOCK_SIZE * NUM_BLOCKS;
+
+    std::cout << "\n=== Ordered channel selection (" << NUM_TAPS << " taps, "
+              << NUM_BLOCKS << " blocks of " << BLOCK_SIZE << ") ===" << std::endl;
+
+    std::vector<std::complex<float>> stream = make_stream(total, 1);
+
+    // Sequential reference over the whole stream
+    ChannelSelector reference_selector(MIX_FREQ, NUM_TAPS, CUTOFF, ConvolutionMethod::DIRECT);
+    std::vector<std::complex<float>> zeros(reference_selector.history_length());
+    std::vector<std::complex<float>> reference(total);
+    auto start = std::chrono::steady_clock::now();
+    reference_selector.process(0, zeros.data(), stream.data(), total, reference.data());
+    const double sequential_sec = seconds_since(start);
+
+    // Blocks as the RX thread would queue them in ordered mode
+    const size_t hist = reference_selector.history_length();
+    std::vector<SampleBlock> blocks(NUM_BLOCKS);
+    for (size_t b = 0; b < NUM_BLOCKS; b++) {
+        SampleBlock& block = blocks[b];
+        block.block_number = b;
+        block.sample_offset = b * BLOCK_SIZE;
+        block.samples.assign(stream.begin() + b * BLOCK_SIZE, stream.begin() + (b + 1) * BLOCK_SIZE);
+        block.history.assign(hist, std::complex<float>(0.0f, 0.0f));
+        const size_t available = std::min(hist, b * BLOCK_SIZE);
+        std::copy(stream.begin() + b * BLOCK_SIZE - available, stream.begin() + b * BLOCK_SIZE,
+                  block.history.end() - available);
+    }
+
+    std::cout << std::left << std::setw(10) << "Workers" << std::setw(12) << "Time (ms)"
+              << std::setw(11) << "Speedup" << std::setw(15) << "Peak reorder" << "Output" << std::endl;
+    std::cout << std::setw(10) << "seq" << std::setw(12) << std::fixed << std::setprecision(1)
+              << sequential_sec * 1e3 << std::setw(11) << "-" << std::setw(15) << "-"
+              << "reference" << std::endl;
+
+    double one_worker_sec = 0.0;
+    for (int workers : {1, 2, 4, 8}) {
+        std::vector<std::complex<float>> output(total);
+        size_t write_pos = 0;
+        ReorderBuffer<std::vector<std::complex<float>>> reorder(
+            [&](uint64_t, std::vector<std::complex<float>>& result) {
+                std::copy(result.begin(), result.end(), output.begin() + write_pos);
+                write_pos += result.size();
+            });
+
+        std::atomic<size_t> next_block(0);
+        start = std::chrono::steady_clock::now();
+        std::vector<std::thread> pool;
+        for (int w = 0; w < workers; w++) {
+            pool.emplace_back([&]() {
+                ChannelSelector selector(MIX_FREQ, NUM_TAPS, CUTOFF, ConvolutionMethod::DIRECT);
+                for (size_t b = next_block++; b < NUM_BLOCKS; b = next_block++) {
+                    const SampleBlock& block = blocks[b];
+                    std::vector<std::complex<float>> out(block.size());
+                    selector.process(block.sample_offset, block.history.data(),
+                                     block.samples.data(), block.size(), out.data());
+                    reorder.push(block.block_number, std::move(out));
+                }
+            });
+        }
+        for (auto& t : pool) t.join();
+        const double parallel_sec = seconds_since(start);
+        if (workers == 1) one_worker_sec = parallel_sec;
+
+        const bool identical = write_pos == total &&
+            std::memcmp(output.data(), reference.data(), total * sizeof(output[0])) == 0;
+        std::cout << std::setw(10) << workers << std::setw(12) << parallel_sec * 1e3
+                  << std::setw(11) << std::setprecision(2) << one_worker_sec / parallel_sec
+                  << std::setw(15) << reorder.peak_pending()
+                  << (identical ? "bit-identical" : "MISMATCH") << std::setprecision(1) << std::endl;
+    }
+    std::cout << std::right << "Hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+}
+
+// ============================================================================
+// DIRECT FIR VS FFT OVERLAP-SAVE
+// ============================================================================
+
+/**
+ * time_per_sample(): Best-of-3 wall time per input sample of run() in ns
+ * @param run: Filters `samples` input samples once
+ */
+double time_per_sample(const std::function<void()>& run, size_t samples) {
+    double best = 0.0;
+    for (int rep = 0; rep < 3; rep++) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        double sec = seconds_since(start);
+        if (rep == 0 || sec < best) best = sec;
+    }
+    return best * 1e9 / samples;
+}
+
+/**
+ * bench_fastconv(): Cost per sample of direct vs FFT filtering
+ *
+ * Each run filters FASTCONV_BLOCKS blocks of BLOCK_SIZE samples with
+ * overlap-save history, exactly as ChannelSelector does. The bank rows
+ * apply BANK_FILTERS lowpass filters (different cutoffs) to every block:
+ * direct pays for each filter in full, the FFT bank shares the forward
+ * transform.
+ */
+void bench_fastconv() {
+    const size_t FASTCONV_BLOCKS = 20;
+    const size_t BANK_FILTERS = 4;
+    const size_t total = BLOCK_SIZE * FASTCONV_BLOCKS;
+
+    std::cout << "\n=== Direct FIR vs FFT overlap-save (" << FASTCONV_BLOCKS << " blocks of "
+              << BLOCK_SIZE << ", ns per input sample) ===" << std::endl;
+    std::vector<std::complex<float>> stream = make_stream(total + 4096, 2);
+
+    std::cout << std::left << std::setw(7) << "Taps" << std::setw(7) << "FFT N"
+              << std::setw(10) << "Direct" << std::setw(10) << "FFT"
+              << std::setw(12) << "Direct x" + std::to_string(BANK_FILTERS)
+              << std::setw(12) << "FFT bank" << "Rel. error" << std::endl;
+
+    size_t crossover_single = 0, crossover_bank = 0;
+    for (size_t taps : {8, 16, 32, 48, 64, 96, 128, 256, 512, 1024}) {
+        const size_t hist = taps - 1;
+        std::vector<std::vector<float>> bank;
+        for (size_t f = 0; f < BANK_FILTERS; f++) bank.push_back(design_lowpass(taps, 0.05 * (f + 1)));
+        // Stream with hist leading samples so every block has real history
+        const std::complex<float>* base = stream.data() + 4096 - hist;
+
+        std::vector<FirFilter> direct;
+        for (const auto& h : bank) direct.emplace_back(h);
+        FftFilterBank fft_single({bank[0]});
+        FftFilterBank fft_bank(bank);
+
+        std::vector<std::vector<std::complex<float>>> direct_out(BANK_FILTERS, std::vector<std::complex<float>>(total));
+        std::vector<std::vector<std::complex<float>>> fft_out(BANK_FILTERS, std::vector<std::complex<float>>(total));
+        std::vector<std::complex<float>> scratch;
+
+        auto run_direct = [&](size_t filters) {
+            for (size_t b = 0; b < FASTCONV_BLOCKS; b++) {
+                const std::complex<float>* in = base + hist + b * BLOCK_SIZE;
+                for (size_t f = 0; f < filters; f++) {
+                    direct[f].filter(in - hist, in, BLOCK_SIZE, direct_out[f].data() + b * BLOCK_SIZE, scratch);
+                }
+            }
+        };
+        auto run_fft = [&](FftFilterBank& engine) {
+            for (size_t b = 0; b < FASTCONV_BLOCKS; b++) {
+                const std::complex<float>* in = base + hist + b * BLOCK_SIZE;
+                std::vector<std::complex<float>*> outs;
+                for (size_t f = 0; f < engine.num_filters(); f++) outs.push_back(fft_out[f].data() + b * BLOCK_SIZE);
+                engine.filter(in - hist, in, BLOCK_SIZE, outs.data());
+            }
+        };
+
+        double direct_ns = time_per_sample([&]() { run_direct(1); }, total);
+        double fft_ns = time_per_sample([&]() { run_fft(fft_single); }, total);
+        double direct_bank_ns = time_per_sample([&]() { run_direct(BANK_FILTERS); }, total);
+        double fft_bank_ns = time_per_sample([&]() { run_fft(fft_bank); }, total);
+
+        // Largest deviation of the FFT bank from the direct filters
+        double max_err = 0.0, max_ref = 0.0;
+        for (size_t f = 0; f < BANK_FILTERS; f++) {
+            for (size_t i = 0; i < total; i++) {
+                max_err = std::max(max_err, double(std::abs(fft_out[f][i] - direct_out[f][i])));
+                max_ref = std::max(max_ref, double(std::abs(direct_out[f][i])));
+            }
+        }
+
+        if (crossover_single == 0 && fft_ns < direct_ns) crossover_single = taps;
+        if (crossover_bank == 0 && fft_bank_ns < direct_bank_ns) crossover_bank = taps;
+
+        std::cout << std::setw(7) << taps << std::setw(7) << fft_single.fft_size()
+                  << std::fixed << std::setprecision(2)
+                  << std::setw(10) << direct_ns << std::setw(10) << fft_ns
+                  << std::setw(12) << direct_bank_ns << std::setw(12) << fft_bank_ns
+                  << std::scientific << std::setprecision(1) << max_err / max_ref
+                  << std::defaultfloat << std::endl;
+    }
+    std::cout << std::right << "Measured crossover: " << crossover_single << " taps (1 filter), "
+              << crossover_bank << " taps (" << BANK_FILTERS << "-filter bank); "
+              << "compiled-in FFT_CROSSOVER_TAPS = " << FFT_CROSSOVER_TAPS << std::endl;
+}
+
+// ============================================================================
+// RATIONAL RESAMPLER
+// ============================================================================
+
+/**
+ * bench_resample(): Single-core throughput of the polyphase resampler
+ *
+ * The stream is resampled once in a single call (reference) and once in
+ * BLOCK_SIZE blocks with state carried between calls; the two outputs must
+ * match exactly. Throughput is input samples per second of one thread,
+ * shown against the input rate it has to sustain in real time.
+ */
+void bench_resample() {
+    struct Conversion { double in_rate; double out_rate; const char* use; };
+    const Conversion conversions[] = {
+        {25e6, 20e6, "OFDM from 100/4"},
+        {12.5e6, 11e6, "DSSS from 100/8"},
+        {100e6 / 3, 20e6, "OFDM from 100/3"},
+        {10e6, 1e6, "decimate 100/10"},
+    };
+    const size_t total = BLOCK_SIZE * NUM_BLOCKS;
+    std::vector<std::complex<float>> stream = make_stream(total, 3);
+
+    std::cout << "\n=== Polyphase rational resampler (one core, " << total / 1e6
+              << " M input samples) ===" << std::endl;
+    std::cout << std::left << std::setw(20) << "Conversion" << std::setw(9) << "L/M"
+              << std::setw(8) << "Taps" << std::setw(13) << "In (MS/s)" << std::setw(14) << "Out (MS/s)"
+              << std::setw(11) << "Realtime" << "Blocks vs single pass" << std::endl;
+
+    for (const auto& conv : conversions) {
+        uint32_t interp = 1, decim = 1;
+        rational_ratio(conv.out_rate, conv.in_rate, interp, decim);
+
+        RationalResampler single(interp, decim);
+        std::vector<std::complex<float>> reference;
+        single.process(stream.data(), total, reference);
+
+        RationalResampler blocked(interp, decim);
+        std::vector<std::complex<float>> output, chunk;
+        output.reserve(reference.size());
+        auto start = std::chrono::steady_clock::now();
+        for (size_t b = 0; b < NUM_BLOCKS; b++) {
+            blocked.process(stream.data() + b * BLOCK_SIZE, BLOCK_SIZE, chunk);
+            output.insert(output.end(), chunk.begin(), chunk.end());
+        }
+        const double sec = seconds_since(start);
+
+        const bool identical = output.size() == reference.size() &&
+            std::memcmp(output.data(), reference.data(), output.size() * sizeof(output[0])) == 0;
+        const double in_msps = total / sec / 1e6;
+        std::string name = std::to_string(int(conv.in_rate / 1e5) / 10.0).substr(0, 4) + "->"
+                         + std::to_string(int(conv.out_rate / 1e6)) + " MHz";
+        std::cout << std::setw(20) << name
+                  << std::setw(9) << (std::to_string(interp) + "/" + std::to_string(decim))
+                  << std::setw(8) << interp * blocked.taps_per_phase()
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(13) << in_msps << std::setw(14) << output.size() / sec / 1e6
+                  << std::setw(11) << (std::to_string(int(100 * in_msps * 1e6 / conv.in_rate)) + "%")
+                  << (identical ? "bit-identical" : "MISMATCH") << "  (" << conv.use << ")" << std::endl;
+    }
+    std::cout << std::right;
+}
+
+// ============================================================================
+// DC / IQ-IMBALANCE CORRECTION
+// ============================================================================
+
+/**
+ * tone_image_db(): Power of the tone over its mirror image (dB)
+ * Correlates with e^{+j w n} (tone) and e^{-j w n} (image), DC removed.
+ */
+double tone_image_db(const std::vector<std::complex<float>>& x, double freq) {
+    std::complex<double> tone, image, mean;
+    for (const auto& v : x) mean += std::complex<double>(v);
+    mean /= static_cast<double>(x.size());
+    for (size_t i = 0; i < x.size(); i++) {
+        std::complex<double> v = std::complex<double>(x[i]) - mean;
+        std::complex<double> w = std::polar(1.0, 2.0 * DSP_PI * freq * i);
+        tone += v * std::conj(w);
+        image += v * w;
+    }
+    return 10.0 * std::log10(std::norm(tone) / std::norm(image));
+}
+
+/**
+ * bench_iqcorr(): Corrector cost and accuracy on an impaired tone
+ */
+void bench_iqcorr() {
+    const std::complex<float> DC(0.01f, -0.006f);
+    const double GAIN = 1.05, PHASE_DEG = 4.0;
+    const size_t total = BLOCK_SIZE * NUM_BLOCKS;
+
+    std::vector<std::complex<float>> ideal = make_stream(total, 4);
+    std::vector<std::complex<float>> impaired(total);
+    const double phi = PHASE_DEG * DSP_PI / 180.0;
+    for (size_t i = 0; i < total; i++) {
+        const float re = ideal[i].real(), im = ideal[i].imag();
+        impaired[i] = std::complex<float>(re + DC.real(),
+            static_cast<float>(GAIN * (im * std::cos(phi) + re * std::sin(phi))) + DC.imag());
+    }
+
+    std::cout << "\n=== DC / IQ-imbalance correction (" << NUM_BLOCKS << " blocks of "
+              << BLOCK_SIZE << ") ===" << std::endl;
+    std::cout << "Injected: DC " << std::fixed << std::setprecision(4) << DC.real()
+              << (DC.imag() < 0 ? " - j" : " + j") << std::abs(DC.imag()) << ", gain "
+              << std::setprecision(2) << 20.0 * std::log10(GAIN) << " dB, phase "
+              << PHASE_DEG << " deg" << std::endl;
+
+    // fc32: corrected in place block by block
+    std::vector<std::complex<float>> corrected = impaired;
+    IqCorrector corrector;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t b = 0; b < NUM_BLOCKS; b++) corrector.correct(corrected.data() + b * BLOCK_SIZE, BLOCK_SIZE);
+    const double fc32_ns = seconds_since(start) * 1e9 / total;
+    IqEstimates est = corrector.estimates();
+
+    // sc8: same stream quantized, corrected through the staging buffer
+    const float scale = 0.3f / 127.0f;
+    std::vector<std::complex<int8_t>> packed(total);
+    pack_sc8(impaired.data(), total, packed.data(), 1.0f / scale);
+    IqCorrector corrector_sc8;
+    start = std::chrono::steady_clock::now();
+    for (size_t b = 0; b < NUM_BLOCKS; b++) corrector_sc8.correct(packed.data() + b * BLOCK_SIZE, BLOCK_SIZE, scale);
+    const double sc8_ns = seconds_since(start) * 1e9 / total;
+
+    // Image rejection over the second half (after convergence)
+    std::vector<std::complex<float>> before(impaired.begin() + total / 2, impaired.end());
+    std::vector<std::complex<float>> after(corrected.begin() + total / 2, corrected.end());
+    std::cout << "Estimated: DC " << std::setprecision(4) << est.dc.real()
+              << (est.dc.imag() < 0 ? " - j" : " + j") << std::abs(est.dc.imag()) << ", gain " << std::setprecision(2) << est.gain_db << " dB, phase "
+              << est.phase_deg << " deg (after " << est.blocks << " blocks)" << std::endl;
+    std::cout << "Image rejection: " << std::setprecision(1) << tone_image_db(before, TONE_FREQ)
+              << " dB raw -> " << tone_image_db(after, TONE_FREQ) << " dB corrected" << std::endl;
+    std::cout << "Cost: " << std::setprecision(2) << fc32_ns << " ns/sample fc32, "
+              << sc8_ns << " ns/sample sc8 (incl. unpack/requantize)" << std::endl;
+}
+
+// ============================================================================
+// BURST EXTRACTION
+// ============================================================================
+
+/**
+ * bench_bursts(): Segmenter accuracy and cost on a sparse stream
+ *
+ * Noise at a known floor with NUM_BURSTS tone bursts; every third burst is
+ * centred on a block boundary, one spans several blocks.
+ */
+void bench_bursts() {
+    const size_t NUM_BURSTS = 24;
+    const size_t total = BLOCK_SIZE * NUM_BLOCKS;
+    const float NOISE = 0.02f;                       // Uniform +-0.01 per component
+    const double floor = 2.0 * (NOISE * NOISE / 12.0);
+
+    std::vector<std::complex<float>> stream = make_stream(total, 5);
+    std::vector<std::pair<size_t, size_t>> truth;    // (start, length)
+    const size_t spacing = total / NUM_BURSTS;
+    for (size_t k = 0; k < NUM_BURSTS; k++) {
+        size_t length = (k == 5) ? 3 * BLOCK_SIZE : 500 + 300 * (k % 7);
+        size_t start = (k % 3 == 0) ? ((k * spacing) / BLOCK_SIZE + 1) * BLOCK_SIZE - length / 2
+                                    : k * spacing + 1000;
+        truth.emplace_back(start, length);
+    }
+    // Noise everywhere, tone only inside the bursts
+    std::vector<std::complex<float>> sparse(total);
+    uint64_t state = 77;
+    for (size_t i = 0; i < total; i++) {
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+        float a = ((state & 0xffff) / 65536.0f - 0.5f) * NOISE;
+        float b = (((state >> 16) & 0xffff) / 65536.0f - 0.5f) * NOISE;
+        sparse[i] = std::complex<float>(a, b);
+    }
+    for (const auto& burst : truth) {
+        for (size_t i = burst.first; i < burst.first + burst.second; i++) sparse[i] += stream[i];
+    }
+
+    std::cout << "\n=== Burst extraction (" << NUM_BURSTS << " bursts in "
+              << total / 1e6 << " M samples) ===" << std::endl;
+
+    BurstSegmenter segmenter(10.0, 7.0);
+    segmenter.set_noise_floor(floor);
+    std::vector<BurstRecord> records, completed;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t b = 0; b < NUM_BLOCKS; b++) {
+        segmenter.process(b * BLOCK_SIZE, sparse.data() + b * BLOCK_SIZE, BLOCK_SIZE, completed);
+        for (auto& r : completed) records.push_back(std::move(r));
+        completed.clear();
+    }
+    segmenter.flush(records);
+    const double ns = seconds_since(start) * 1e9 / total;
+
+    // Each true burst must lie inside exactly one record, and the record's
+    // samples must be the stream's samples at its offset
+    size_t matched = 0, straddling = 0;
+    bool samples_ok = true;
+    for (const auto& burst : truth) {
+        size_t covering = 0;
+        for (const auto& r : records) {
+            if (r.sample_offset <= burst.first && r.sample_offset + r.length >= burst.first + burst.second) covering++;
+        }
+        if (covering == 1) matched++;
+        if (burst.first / BLOCK_SIZE != (burst.first + burst.second - 1) / BLOCK_SIZE) straddling++;
+    }
+    for (const auto& r : records) {
+        samples_ok = samples_ok && std::memcmp(r.samples->data(), sparse.data() + r.sample_offset,
+                                               r.length * sizeof(sparse[0])) == 0;
+    }
+    const uint64_t kept = segmenter.burst_samples();
+    std::cout << "Records: " << records.size() << " for " << NUM_BURSTS << " bursts ("
+              << straddling << " straddle block boundaries); " << matched << "/" << NUM_BURSTS
+              << " covered by exactly one record; samples " << (samples_ok ? "match the stream" : "MISMATCH")
+              << std::endl;
+    std::cout << "Kept " << kept << " of " << total << " samples (" << std::fixed << std::setprecision(0)
+              << static_cast<double>(total) / kept << "x reduction); "
+              << std::setprecision(2) << ns << " ns/sample; pool "
+              << segmenter.pool().buffers_allocated() << " allocated / "
+              << segmenter.pool().buffers_reused() << " reused" << std::endl;
+}
+
+// ============================================================================
+// GOERTZEL BANK VS FFT
+// ============================================================================
+
+/**
+ * bench_tones(): Cost of K Goertzel bins vs one FFT per block
+ *
+ * The FFT row zero-pads each block to the next power of two and takes
+ * the power of every bin, which is what a spectrum stage would do; its
+ * cost does not depend on K. Accuracy: bin values of the bank against a
+ * double-precision DFT at the same absolute indices. Tracking: the tone
+ * sits OFFSET above bin 0, which the tracker should report.
+ */
+void bench_tones() {
+    const size_t TONE_BLOCKS = 20;
+    const double OFFSET = 2e-5;                      // Tone - bin 0 (fraction of the rate)
+    const size_t total = BLOCK_SIZE * TONE_BLOCKS;
+
+    std::cout << "\n=== Goertzel bank vs FFT (" << TONE_BLOCKS << " blocks of "
+              << BLOCK_SIZE << ", ns per input sample) ===" << std::endl;
+    std::vector<std::complex<float>> stream = make_stream(total, 6);
+
+    size_t fft_size = 2;
+    while (fft_size < BLOCK_SIZE) fft_size <<= 1;
+    Fft fft(fft_size);
+    std::vector<std::complex<float>> padded(fft_size);
+    std::vector<float> spectrum(fft_size);
+    const double fft_ns = time_per_sample([&]() {
+        for (size_t b = 0; b < TONE_BLOCKS; b++) {
+            std::copy(stream.begin() + b * BLOCK_SIZE, stream.begin() + (b + 1) * BLOCK_SIZE, padded.begin());
+            std::fill(padded.begin() + BLOCK_SIZE, padded.end(), std::complex<float>(0.0f, 0.0f));
+            fft.forward(padded.data());
+            for (size_t k = 0; k < fft_size; k++) spectrum[k] = std::norm(padded[k]);
+        }
+    }, total);
+
+    std::cout << std::left << std::setw(7) << "Bins" << std::setw(12) << "Goertzel"
+              << std::setw(12) << "FFT " + std::to_string(fft_size) << "Rel. error" << std::endl;
+    size_t crossover = 0;
+    for (size_t bins : {1, 2, 4, 8, 16, 24, 32, 48, 64, 128}) {
+        std::vector<double> freqs;
+        for (size_t k = 0; k < bins; k++) freqs.push_back(TONE_FREQ - OFFSET + 0.37 * k / bins);
+        GoertzelBank bank(freqs);
+        std::vector<std::vector<ToneBin>> out(TONE_BLOCKS);
+        const double goertzel_ns = time_per_sample([&]() {
+            for (size_t b = 0; b < TONE_BLOCKS; b++) {
+                bank.process(b * BLOCK_SIZE, stream.data() + b * BLOCK_SIZE, BLOCK_SIZE, out[b]);
+            }
+        }, total);
+
+        // Every bin of the last block against the direct DFT
+        const size_t b = TONE_BLOCKS - 1;
+        double max_err = 0.0, max_ref = 0.0;
+        for (size_t k = 0; k < bins; k++) {
+            std::complex<double> ref;
+            for (size_t i = 0; i < BLOCK_SIZE; i++) {
+                const uint64_t index = b * BLOCK_SIZE + i;
+                double cycles = freqs[k] * static_cast<double>(index);
+                cycles -= std::floor(cycles);
+                ref += std::complex<double>(stream[index]) * std::polar(1.0, -2.0 * DSP_PI * cycles);
+            }
+            max_err = std::max(max_err, std::abs(out[b][k].value - ref));
+            max_ref = std::max(max_ref, std::abs(ref));
+        }
+
+        if (crossover == 0 && fft_ns < goertzel_ns) crossover = bins;
+        std::cout << std::setw(7) << bins << std::fixed << std::setprecision(2)
+                  << std::setw(12) << goertzel_ns << std::setw(12) << fft_ns
+                  << std::scientific << std::setprecision(1) << max_err / max_ref
+                  << std::defaultfloat << std::endl;
+    }
+    std::cout << std::right << "Measured crossover: " << crossover << " bins; "
+              << "compiled-in GOERTZEL_CROSSOVER_BINS = " << GOERTZEL_CROSSOVER_BINS << std::endl;
+
+    // Near DC the recursion coefficient 2 cos(w) approaches 2 and rounding
+    // in the state grows fastest: worst case for the precision bound
+    const size_t LONG_BLOCK = 262144;
+    std::vector<std::complex<float>> long_stream = make_stream(LONG_BLOCK, 7);
+    for (size_t i = 0; i < LONG_BLOCK; i++) long_stream[i] += std::complex<float>(0.05f, -0.03f);   // DC
+    std::cout << "Near-DC rel. error:";
+    for (size_t n : {BLOCK_SIZE, LONG_BLOCK}) {
+        for (double f : {0.0, 1e-4}) {
+            GoertzelBank dc_bank({f});
+            std::vector<ToneBin> dc_bin;
+            dc_bank.process(0, long_stream.data(), n, dc_bin);
+            std::complex<double> ref;
+            for (size_t i = 0; i < n; i++) {
+                double cycles = f * static_cast<double>(i);
+                cycles -= std::floor(cycles);
+                ref += std::complex<double>(long_stream[i]) * std::polar(1.0, -2.0 * DSP_PI * cycles);
+            }
+            std::cout << " N=" << n << " f=" << f << ": " << std::scientific << std::setprecision(1)
+                      << std::abs(dc_bin[0].value - ref) / std::abs(ref) << std::defaultfloat;
+        }
+    }
+    std::cout << std::endl;
+
+    // Tracking across blocks: one bin, tone detuned by OFFSET
+    GoertzelBank bank({TONE_FREQ - OFFSET});
+    ToneTracker tracker(1);
+    std::vector<ToneBin> bin;
+    for (size_t b = 0; b < TONE_BLOCKS; b++) {
+        bank.process(b * BLOCK_SIZE, stream.data() + b * BLOCK_SIZE, BLOCK_SIZE, bin);
+        tracker.update(b, b * BLOCK_SIZE, BLOCK_SIZE, bin);
+    }
+    // Tone power 0.01 less the scalloping loss of a bin OFFSET away
+    const double scallop = std::sin(DSP_PI * OFFSET * BLOCK_SIZE) / (BLOCK_SIZE * std::sin(DSP_PI * OFFSET));
+    const ToneTracker::Track& track = tracker.track(0);
+    std::cout << "Tracker: offset " << std::scientific << std::setprecision(3) << track.offset
+              << " (true " << OFFSET << "), power " << std::fixed << std::setprecision(2)
+              << 10.0 * std::log10(track.power) << " dB (expected "
+              << 10.0 * std::log10(0.01 * scallop * scallop) << " dB)" << std::defaultfloat << std::endl;
+}
+
+// ============================================================================
+// APPROXIMATE MAGNITUDE AND dB
+// ============================================================================
+
+/**
+ * bench_magnitude(): Error bounds and cost of the fast_magnitude.hpp kernels
+ *
+ * Samples have uniformly distributed angles and magnitudes spread evenly in
+ * dB over 10^-6..1, so every exponent and every mantissa is exercised.
+ * Errors are the worst case over all samples against double precision.
+ */
+void bench_magnitude() {
+    const size_t total = BLOCK_SIZE * NUM_BLOCKS;
+
+    std::cout << "\n=== Approximate magnitude and dB (" << total / 1e6
+              << " M values, ns per value) ===" << std::endl;
+    std::vector<std::complex<float>> samples(total);
+    uint64_t state = 99;
+    auto uniform = [&state]() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return (state >> 11) * (1.0 / 9007199254740992.0);
+    };
+    for (auto& x : samples) {
+        x = std::polar(static_cast<float>(std::pow(10.0, -6.0 * uniform())),
+                       static_cast<float>(2.0 * DSP_PI * uniform()));
+    }
+    std::vector<float> powers(total);
+    for (size_t i = 0; i < total; i++) powers[i] = std::norm(samples[i]);
+
+    std::vector<float> exact(total), approx(total);
+    auto max_rel_error = [&]() {
+        double worst = 0.0;
+        for (size_t i = 0; i < total; i++) {
+            const double ref = std::abs(std::complex<double>(samples[i]));
+            worst = std::max(worst, std::abs(approx[i] - ref) / ref);
+        }
+        return worst;
+    };
+
+    const double abs_ns = time_per_sample([&]() {
+        for (size_t i = 0; i < total; i++) exact[i] = std::abs(samples[i]);
+    }, total);
+    const double sqrt_ns = time_per_sample([&]() {
+        for (size_t i = 0; i < total; i++) exact[i] = std::sqrt(std::norm(samples[i]));
+    }, total);
+    const double ambm_ns = time_per_sample([&]() { magnitude_amax_bmin(samples.data(), total, approx.data()); }, total);
+    const double ambm_err = max_rel_error();
+    const double poly_ns = time_per_sample([&]() { magnitude_poly(samples.data(), total, approx.data()); }, total);
+    const double poly_err = max_rel_error();
+
+    const double log_ns = time_per_sample([&]() {
+        for (size_t i = 0; i < total; i++) exact[i] = 10.0f * std::log10(powers[i]);
+    }, total);
+    const double db_ns = time_per_sample([&]() { power_to_db(powers.data(), total, approx.data()); }, total);
+    double db_err = 0.0, scalar_err = 0.0;
+    for (size_t i = 0; i < total; i++) {
+        const double ref = 10.0 * std::log10(static_cast<double>(powers[i]));
+        db_err = std::max(db_err, std::abs(approx[i] - ref));
+        scalar_err = std::max(scalar_err, std::abs(fast_db(powers[i]) - ref));
+    }
+
+    std::cout << std::left << std::setw(26) << "Kernel" << std::setw(10) << "Cost"
+              << "Max error" << std::endl << std::fixed;
+    std::cout << std::setw(26) << "std::abs" << std::setw(10) << std::setprecision(2) << abs_ns
+              << "reference" << std::endl;
+    std::cout << std::setw(26) << "std::sqrt(std::norm)" << std::setw(10) << sqrt_ns
+              << "reference" << std::endl;
+    std::cout << std::setw(26) << "alpha-max-plus-beta-min" << std::setw(10) << ambm_ns
+              << std::setprecision(3) << 100.0 * ambm_err << "% ("
+              << 20.0 * std::log10(1.0 + ambm_err) << " dB)" << std::endl;
+    std::cout << std::setw(26) << "polynomial sqrt" << std::setw(10) << std::setprecision(2) << poly_ns
+              << std::setprecision(3) << 100.0 * poly_err << "% ("
+              << 20.0 * std::log10(1.0 + poly_err) << " dB)" << std::endl;
+    std::cout << std::setw(26) << "10 * std::log10" << std::setw(10) << std::setprecision(2) << log_ns
+              << "reference" << std::endl;
+    std::cout << std::setw(26) << "power_to_db" << std::setw(10) << db_ns
+              << std::setprecision(4) << db_err << " dB (scalar fast_db " << scalar_err << " dB)"
+              << std::right << std::defaultfloat << std::endl;
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+int main(int argc, char* argv[]) {
+    std::string section = (argc > 1) ? argv[1] : "all";
+    bool ran = false;
+
+    if (section == "all" || section == "ordered") {
+        bench_ordered();
+        ran = true;
+    }
+    if (section == "all" || section == "fastconv") {
+        bench_fastconv();
+        ran = true;
+    }
+    if (section == "all" || section == "resample") {
+        bench_resample();
+        ran = true;
+    }
+    if (section == "all" || section == "iqcorr") {
+        bench_iqcorr();
+        ran = true;
+    }
+    if (section == "all" || section == "bursts") {
+        bench_bursts();
+        ran = true;
+    }
+    if (section == "all" || section == "tones") {
+        bench_tones();
+        ran = true;
+    }
+    if (section == "all" || section == "magnitude") {
+        bench_magnitude();
+        ran = true;
+    }
+
+    if (!ran) {
+        std::cerr << "Unknown section: " << section << std::endl;
+        std::cerr << "Usage: " << argv[0] << " [all|ordered|fastconv|resample|iqcorr|bursts|tones|magnitude]" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,293 @@
+/*
+ * EEL6528 Lab 1: Stateful DSP stages that still run in parallel across blocks
+ *
+ * A stateful stage normally needs blocks in order because its output depends
+ * on earlier samples. Both stages here make that dependency explicit so any
+ * worker can process any block:
+ * - Mixer: the oscillator phase is a function of the absolute sample index,
+ *   so it is computed from the block's sample_offset instead of carried over
+ * - FirFilter: the only state is the last (taps - 1) input samples, which the
+ *   producer hands to each block as its history (overlap-save)
+ *
+ * Every block is processed by the same deterministic code from the same
+ * inputs, so the output is bit-identical to a sequential run. Results are
+ * put back in block order with a ReorderBuffer. (With the FFT filter the
+ * segment grid follows block boundaries: a sequential run over the same
+ * blocks is still identical, a single pass over the stream agrees to
+ * within float rounding.)
+ */
+
+#pragma once
+
+#include "fast_convolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+const double DSP_PI = 3.14159265358979323846;
+
+/**
+ * design_lowpass(): Windowed-sinc (Hamming) lowpass filter taps
+ * @param num_taps: Filter length (odd gives a symmetric, integer delay)
+ * @param cutoff: Cutoff frequency as a fraction of the sampling rate (0..0.5)
+ * @return: Taps normalized to unity DC gain
+ */
+inline std::vector<float> design_lowpass(size_t num_taps, double cutoff) {
+    std::vector<float> taps(num_taps);
+    const double center = (num_taps - 1) / 2.0;
+    double sum = 0.0;
+    for (size_t k = 0; k < num_taps; k++) {
+        double t = k - center;
+        double sinc = (t == 0.0) ? 2.0 * cutoff : std::sin(2.0 * DSP_PI * cutoff * t) / (DSP_PI * t);
+        double window = (num_taps > 1)
+            ? 0.54 - 0.46 * std::cos(2.0 * DSP_PI * k / (num_taps - 1)) : 1.0;
+        taps[k] = static_cast<float>(sinc * window);
+        sum += taps[k];
+    }
+    for (auto& tap : taps) tap = static_cast<float>(tap / sum);
+    return taps;
+}
+
+/**
+ * FirFilter: direct-form FIR with real taps on complex samples
+ *
+ * y[i] = sum_k h[k] * x[i - k], where x[-1] .. x[-(L-1)] come from history.
+ * The loop runs tap-by-tap over the whole block (y += h[k] * x shifted), a
+ * contiguous multiply-add over floats that the compiler vectorizes without
+ * reassociating any sums.
+ */
+class FirFilter {
+public:
+    explicit FirFilter(std::vector<float> filter_taps) : taps(std::move(filter_taps)) {}
+
+    size_t num_taps() const { return taps.size(); }
+
+    // Input samples from the previous block each block needs
+    size_t history_length() const { return taps.empty() ? 0 : taps.size() - 1; }
+
+    /**
+     * filter(): Filter one block given the previous block's tail
+     * @param history: Last history_length() input samples before the block
+     * @param in: Block input samples
+     * @param n: Number of samples in the block
+     * @param out: Output samples (n)
+     * @param scratch: Caller-owned work buffer (reused across calls)
+     */
+    void filter(const std::complex<float>* history, const std::complex<float>* in, size_t n,
+                std::complex<float>* out, std::vector<std::complex<float>>& scratch) const {
+        const size_t hist = history_length();
+        scratch.resize(hist + n);
+        std::copy(history, history + hist, scratch.begin());
+        std::copy(in, in + n, scratch.begin() + hist);
+
+        const float* x = reinterpret_cast<const float*>(scratch.data());
+        float* y = reinterpret_cast<float*>(out);
+        std::fill(y, y + 2 * n, 0.0f);
+        // Tap k multiplies x[i - k], i.e. scratch[hist + i - k]
+        for (size_t k = 0; k < taps.size(); k++) {
+            const float h = taps[k];
+            const float* xk = x + 2 * (hist - k);
+            for (size_t i = 0; i < 2 * n; i++) {
+                y[i] += h * xk[i];
+            }
+        }
+    }
+
+    const std::vector<float>& coefficients() const { return taps; }
+
+private:
+    std::vector<float> taps;
+};
+
+/**
+ * Mixer: frequency shift by exp(-j*2*pi*f*n) with n the absolute sample index
+ *
+ * The phase is recomputed exactly (2*pi*frac(f*n)) at every absolute index
+ * that is a multiple of ANCHOR and advanced by a fixed rotation in between.
+ * The mixed value of sample n therefore depends only on n and x[n], not on
+ * where a block starts: blocks can be mixed in any order, on any thread,
+ * and match a single pass over the whole stream bit for bit.
+ */
+class Mixer {
+public:
+    static const uint64_t ANCHOR = 64;
+
+    /**
+     * Constructor
+     * @param freq_norm: Shift as a fraction of the sampling rate (signal at
+     *                   +freq_norm moves to DC)
+     */
+    explicit Mixer(double freq_norm)
+        : freq(freq_norm), step(std::polar(1.0f, static_cast<float>(-2.0 * DSP_PI * freq_norm))) {}
+
+    bool enabled() const { return freq != 0.0; }
+
+    /**
+     * mix(): Shift a run of samples starting at absolute index start_index
+     */
+    void mix(uint64_t start_index, const std::complex<float>* in, size_t n,
+             std::complex<float>* out) const {
+        if (!enabled()) {
+            std::copy(in, in + n, out);
+            return;
+        }
+        uint64_t index = start_index;
+        size_t i = 0;
+        while (i < n) {
+            const uint64_t anchor = index - index % ANCHOR;
+            std::complex<float> phasor = anchor_phasor(anchor);
+            for (uint64_t skip = anchor; skip < index; skip++) phasor *= step;   // Run starts mid-chunk
+            const size_t end = std::min<size_t>(n, i + (anchor + ANCHOR - index));
+            for (; i < end; i++, index++) {
+                out[i] = in[i] * phasor;
+                phasor *= step;
+            }
+        }
+    }
+
+private:
+    std::complex<float> anchor_phasor(uint64_t index) const {
+        double cycles = freq * static_cast<double>(index);
+        cycles -= std::floor(cycles);
+        return std::polar(1.0f, static_cast<float>(-2.0 * DSP_PI * cycles));
+    }
+
+    double freq;
+    std::complex<float> step;
+};
+
+/**
+ * ChannelSelector: Mixer followed by a lowpass filter
+ *
+ * The history handed in is the raw (unmixed) input, so the producer only
+ * has to keep the tail of the received stream; it is mixed here at its own
+ * absolute indices before filtering. The lowpass runs as a direct FIR or
+ * by FFT overlap-save, chosen from the tap count unless forced.
+ */
+class ChannelSelector {
+public:
+    ChannelSelector(double freq_norm, size_t num_taps, double cutoff,
+                    ConvolutionMethod requested = ConvolutionMethod::AUTO)
+        : mixer(freq_norm), fir(design_lowpass(num_taps, cutoff)),
+          conv(choose_convolution(num_taps, requested)) {
+        if (conv == ConvolutionMethod::FFT) {
+            fft_fir.reset(new FftFilterBank({fir.coefficients()}));
+        }
+    }
+
+    size_t history_length() const { return fir.history_length(); }
+
+    // Method actually used for the lowpass (never AUTO)
+    ConvolutionMethod method() const { return conv; }
+
+    /**
+     * process(): Mix and filter one block
+     * @param start_index: Absolute index of in[0] in the stream
+     * @param history: history_length() raw samples preceding in[0]
+     * @param in: Raw block samples
+     * @param n: Block length
+     * @param out: Filtered output (n)
+     */
+    void process(uint64_t start_index, const std::complex<float>* history,
+                 const std::complex<float>* in, size_t n, std::complex<float>* out) {
+        const size_t hist = history_length();
+        mixed.resize(hist + n);
+        // History before the start of the stream is zero padding (mixes to zero)
+        const size_t padding = (start_index >= hist) ? 0 : hist - start_index;
+        std::copy(history, history + padding, mixed.begin());
+        mixer.mix(start_index + padding - hist, history + padding, hist - padding,
+                  mixed.data() + padding);
+        mixer.mix(start_index, in, n, mixed.data() + hist);
+        if (fft_fir) {
+            fft_fir->filter(mixed.data(), mixed.data() + hist, n, &out);
+        } else {
+            fir.filter(mixed.data(), mixed.data() + hist, n, out, scratch);
+        }
+    }
+
+private:
+    Mixer mixer;
+    FirFilter fir;
+    ConvolutionMethod conv;
+    std::unique_ptr<FftFilterBank> fft_fir;     // Set when conv == FFT
+    std::vector<std::complex<float>> mixed;     // Work buffers, reused per block
+    std::vector<std::complex<float>> scratch;
+};
+
+/**
+ * ReorderBuffer: put results from parallel workers back in sequence order
+ *
+ * Workers insert results tagged with their block number as they finish.
+ * Whenever the next expected number is present, the contiguous run is
+ * passed to the emit callback in order. One pushing thread at a time
+ * drains the buffer and runs emit outside the lock: the others only insert
+ * and return, so a slow emit never holds up the workers, and emitted
+ * results never interleave.
+ */
+template <typename T>
+class ReorderBuffer {
+public:
+    using Emit = std::function<void(uint64_t, T&)>;
+
+    ReorderBuffer(Emit emit_fn, uint64_t first_sequence = 0)
+        : emit(std::move(emit_fn)), next(first_sequence) {}
+
+    /**
+     * push(): Insert the result for one sequence number
+     */
+    void push(uint64_t sequence, T value) {
+        std::unique_lock<std::mutex> lock(mtx);
+        waiting.emplace(sequence, std::move(value));
+        if (waiting.size() > peak) peak = waiting.size();
+        if (emitting) return;           // The current emitter will take it
+        emitting = true;
+        std::vector<std::pair<uint64_t, T>> run;
+        for (;;) {
+            for (auto it = waiting.begin(); it != waiting.end() && it->first == next;
+                 it = waiting.erase(it), next++) {
+                run.emplace_back(it->first, std::move(it->second));
+            }
+            if (run.empty()) break;
+            lock.unlock();
+            for (auto& item : run) {
+                emit(item.first, item.second);
+            }
+            run.clear();
+            lock.lock();
+        }
+        emitting = false;
+    }
+
+    // Results held back waiting for an earlier block
+    size_t pending() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return waiting.size();
+    }
+
+    // Largest number of results held back at once
+    size_t peak_pending() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return peak;
+    }
+
+    // Next sequence number to be emitted
+    uint64_t next_sequence() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return next;
+    }
+
+private:
+    std::mutex mtx;
+    Emit emit;
+    std::map<uint64_t, T> waiting;
+    uint64_t next;
+    size_t peak = 0;
+    bool emitting = false;          // A push() is running emit
+};
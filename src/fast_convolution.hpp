@@ -0,0 +1,202 @@
+/*
+ * EEL6528 Lab 1: FFT overlap-save convolution and filter banks
+ *
+ * A direct FIR costs L multiply-adds per output sample. Overlap-save costs
+ * one forward FFT per segment of M = N - (L - 1) outputs, plus one spectrum
+ * multiply and one inverse FFT per filter:
+ *   direct:  ~L per output (per filter)
+ *   FFT:     ~(N log2 N + F * (N + N log2 N)) / M per output for F filters
+ * Long filters (hundreds of taps) are therefore much cheaper in the
+ * frequency domain, and the forward transform of a block is shared by every
+ * filter applied to it.
+ *
+ * The crossover depends on the machine; `./dsp_bench fastconv` measures it
+ * and FFT_CROSSOVER_TAPS records the value used by choose_convolution().
+ */
+
+#pragma once
+
+#include "fft.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// METHOD SELECTION
+// ============================================================================
+
+/**
+ * ConvolutionMethod: how a FIR stage is computed
+ */
+enum class ConvolutionMethod {
+    AUTO,     // Pick from the tap count (choose_convolution)
+    DIRECT,   // Time-domain multiply-add per tap
+    FFT       // Overlap-save in the frequency domain
+};
+
+// Tap count from which one FFT filter beats the direct FIR on 10000-sample
+// blocks (x86-64, -O3, `./dsp_bench fastconv`; rerun on a new machine)
+const size_t FFT_CROSSOVER_TAPS = 64;
+
+// Largest transform fft_size_for() considers, and the longest filter it can
+// place in one (a segment must be longer than twice the history)
+const size_t FFT_MAX_SIZE = size_t(1) << 16;
+const size_t FFT_MAX_TAPS = FFT_MAX_SIZE / 2;
+
+inline const char* convolution_method_name(ConvolutionMethod method) {
+    switch (method) {
+        case ConvolutionMethod::DIRECT: return "direct";
+        case ConvolutionMethod::FFT:    return "fft";
+        default:                        return "auto";
+    }
+}
+
+/**
+ * parse_convolution_method(): Parse "auto" / "direct" / "fft"
+ * @return: true if the name was recognized
+ */
+inline bool parse_convolution_method(const std::string& name, ConvolutionMethod& method) {
+    if (name == "auto")   { method = ConvolutionMethod::AUTO;   return true; }
+    if (name == "direct") { method = ConvolutionMethod::DIRECT; return true; }
+    if (name == "fft")    { method = ConvolutionMethod::FFT;    return true; }
+    return false;
+}
+
+/**
+ * choose_convolution(): Resolve AUTO to the faster method for a tap count
+ * @param num_taps: Filter length
+ * @param requested: Explicit method, or AUTO
+ * @param crossover: Tap count from which FFT is faster
+ */
+inline ConvolutionMethod choose_convolution(size_t num_taps,
+                                            ConvolutionMethod requested = ConvolutionMethod::AUTO,
+                                            size_t crossover = FFT_CROSSOVER_TAPS) {
+    if (requested != ConvolutionMethod::AUTO) return requested;
+    return num_taps >= crossover ? ConvolutionMethod::FFT : ConvolutionMethod::DIRECT;
+}
+
+/**
+ * fft_size_for(): Transform length minimizing the modeled cost per output
+ * @param num_taps: Longest filter in the bank
+ * @param num_filters: Filters sharing each forward transform
+ * @return: Transform length, 0 if num_taps exceeds FFT_MAX_TAPS
+ */
+inline size_t fft_size_for(size_t num_taps, size_t num_filters = 1) {
+    const size_t hist = num_taps > 0 ? num_taps - 1 : 0;
+    size_t best = 0;
+    double best_cost = 0.0;
+    for (size_t n = 16; n <= FFT_MAX_SIZE; n <<= 1) {
+        if (n <= 2 * hist) continue;
+        const double log_n = std::log2(static_cast<double>(n));
+        const double cost = (n * log_n * (1.0 + num_filters) + num_filters * n) / (n - hist);
+        if (best == 0 || cost < best_cost) {
+            best = n;
+            best_cost = cost;
+        }
+    }
+    return best;
+}
+
+// ============================================================================
+// OVERLAP-SAVE FILTER BANK
+// ============================================================================
+
+/**
+ * FftFilterBank: several real-tap FIR filters applied to one input stream
+ *
+ * Same interface contract as FirFilter::filter(): the caller supplies the
+ * previous history_length() input samples, so blocks can be filtered
+ * independently (and in parallel) with the result of a continuous filter.
+ * Each segment is transformed once and reused by all filters.
+ */
+class FftFilterBank {
+public:
+    /**
+     * Constructor
+     * @param filters: Tap vectors (may differ in length; shorter ones are
+     *                 zero-padded to the longest)
+     * @param transform_size: FFT length, 0 = pick with fft_size_for()
+     */
+    explicit FftFilterBank(const std::vector<std::vector<float>>& filters, size_t transform_size = 0)
+        : hist(history_for(filters)),
+          fft(transform_size ? transform_size : fft_size_for(hist + 1, filters.size())) {
+        const size_t n = fft.size();
+        for (const auto& taps : filters) {
+            // Spectrum pre-scaled by 1/N because the inverse FFT is unscaled
+            std::vector<std::complex<float>> spectrum(n);
+            for (size_t k = 0; k < taps.size(); k++) spectrum[k] = taps[k] / static_cast<float>(n);
+            fft.forward(spectrum.data());
+            spectra.push_back(std::move(spectrum));
+        }
+    }
+
+    size_t num_filters() const { return spectra.size(); }
+    size_t history_length() const { return hist; }
+    size_t fft_size() const { return fft.size(); }
+
+    // Output samples produced per transform
+    size_t segment_step() const { return fft.size() - hist; }
+
+    /**
+     * filter(): Filter one block with every filter in the bank
+     * @param history: Last history_length() input samples before the block
+     * @param in: Block input samples
+     * @param n: Number of samples in the block
+     * @param out: One output pointer per filter (n samples each)
+     */
+    void filter(const std::complex<float>* history, const std::complex<float>* in, size_t n,
+                std::complex<float>* const* out) {
+        const size_t size = fft.size();
+        const size_t step = segment_step();
+        input.resize(hist + n);
+        std::copy(history, history + hist, input.begin());
+        std::copy(in, in + n, input.begin() + hist);
+        segment.resize(size);
+        product.resize(size);
+
+        for (size_t pos = 0; pos < n; pos += step) {
+            // Segment covers input[pos, pos + size), zero-padded past the end
+            const size_t available = std::min(size, input.size() - pos);
+            std::copy(input.begin() + pos, input.begin() + pos + available, segment.begin());
+            std::fill(segment.begin() + available, segment.end(), std::complex<float>(0.0f, 0.0f));
+            fft.forward(segment.data());
+
+            const size_t count = std::min(step, n - pos);
+            for (size_t f = 0; f < spectra.size(); f++) {
+                multiply(segment.data(), spectra[f].data(), product.data(), size);
+                fft.inverse(product.data());
+                // The first hist outputs wrap around (circular); the rest are valid
+                std::copy(product.begin() + hist, product.begin() + hist + count, out[f] + pos);
+            }
+        }
+    }
+
+private:
+    static size_t history_for(const std::vector<std::vector<float>>& filters) {
+        size_t longest = 1;
+        for (const auto& taps : filters) longest = std::max(longest, taps.size());
+        return longest - 1;
+    }
+
+    // Element-wise complex product on floats (vectorizable)
+    static void multiply(const std::complex<float>* a, const std::complex<float>* b,
+                         std::complex<float>* out, size_t n) {
+        const float* x = reinterpret_cast<const float*>(a);
+        const float* h = reinterpret_cast<const float*>(b);
+        float* y = reinterpret_cast<float*>(out);
+        for (size_t i = 0; i < n; i++) {
+            y[2 * i]     = x[2 * i] * h[2 * i] - x[2 * i + 1] * h[2 * i + 1];
+            y[2 * i + 1] = x[2 * i] * h[2 * i + 1] + x[2 * i + 1] * h[2 * i];
+        }
+    }
+
+    size_t hist;                                        // Longest filter length - 1
+    Fft fft;
+    std::vector<std::vector<std::complex<float>>> spectra;  // Per-filter H[k] / N
+    std::vector<std::complex<float>> input;             // History + block, reused
+    std::vector<std::complex<float>> segment;           // Shared forward transform
+    std::vector<std::complex<float>> product;           // Per-filter work buffer
+};
@@ -0,0 +1,237 @@
+/*
+ * EEL6528 Lab 1: Approximate magnitude and dB kernels
+ *
+ * Envelopes and log-scaled power are needed per sample or per bin in some
+ * stages, where sqrt() and log10() cost more than the rest of the work.
+ * These kernels trade a bounded error for a few multiply-adds.
+ *
+ * MAGNITUDE |x| = sqrt(I^2 + Q^2):
+ * - alpha-max-plus-beta-min: alpha * max(|I|, |Q|) + beta * min(|I|, |Q|)
+ *   with the equiripple pair alpha = 2cos(pi/8) / (1 + cos(pi/8)),
+ *   beta = 2sin(pi/8) / (1 + cos(pi/8)). No multiply of I and Q, no sqrt.
+ *   Error: within +-3.96% (+-0.34 dB) for every angle.
+ * - polynomial sqrt of I^2 + Q^2: the power is split into m * 4^k with m in
+ *   [1, 4) using its exponent bits. sqrt(m) comes from a cubic (minimax in
+ *   relative error on [1, 4)), and 2^k is added back to the exponent.
+ *   Error: within 0.11% (0.009 dB).
+ *
+ * dB:
+ *   10 log10(p) = 10 log10(2) * log2(p), log2(p) = e + log2(m)
+ * e is the exponent of p and m in [1, 2) its mantissa. log2(m) is a cubic
+ * (minimax in absolute error on [1, 2)). Error: within 6.4e-4 in log2,
+ * 0.002 dB, at any magnitude. Inputs below FLT_MIN (0, denormals,
+ * negatives, NaN) are clamped to FLT_MIN (-379.3 dB).
+ *
+ * dBFS:
+ * Full scale is |x| = 1.0 in fc32, the converter's full scale for sc16
+ * (sc8 blocks are in the same units once scaled), so a full-scale tone
+ * has power 1.0 = 0 dBFS.
+ *
+ * dsp_bench ("magnitude") measures these bounds and the costs against
+ * std::abs() and std::log10().
+ *
+ * SIMD:
+ * - SSE2 path on x86-64 (4 values per step)
+ * - Scalar fallback, with the same arithmetic, for the tail and elsewhere
+ */
+
+#pragma once
+
+#include <cfloat>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// Equiripple alpha-max-plus-beta-min coefficients
+const float AMBM_ALPHA = 0.960433870f;
+const float AMBM_BETA = 0.397824735f;
+
+// sqrt(m) on [1, 4): c0 + c1 m + c2 m^2 + c3 m^3
+const float SQRT_C0 = 0.434031194f;
+const float SQRT_C1 = 0.661288572f;
+const float SQRT_C2 = -0.103238024f;
+const float SQRT_C3 = 0.008980438f;
+
+// log2(m) on [1, 2): c0 + c1 m + c2 m^2 + c3 m^3
+const float LOG2_C0 = -2.153634136f;
+const float LOG2_C1 = 3.047906395f;
+const float LOG2_C2 = -1.051886254f;
+const float LOG2_C3 = 0.158250350f;
+
+// 10 log10(2): dB per unit of log2
+const float DB_PER_LOG2 = 3.010299957f;
+
+// Power of a full-scale fc32 sample (0 dBFS)
+const double FULL_SCALE_POWER = 1.0;
+
+// ============================================================================
+// SCALAR KERNELS
+// ============================================================================
+
+inline uint32_t float_bits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline float bits_float(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * magnitude_amax_bmin(): |x| within +-3.96%
+ */
+inline float magnitude_amax_bmin(std::complex<float> x) {
+    const float a = x.real() < 0.0f ? -x.real() : x.real();
+    const float b = x.imag() < 0.0f ? -x.imag() : x.imag();
+    const float hi = a > b ? a : b;
+    const float lo = a > b ? b : a;
+    return AMBM_ALPHA * hi + AMBM_BETA * lo;
+}
+
+/**
+ * sqrt_poly(): sqrt(p) within 0.11% (0 for p below FLT_MIN)
+ */
+inline float sqrt_poly(float p) {
+    if (!(p >= FLT_MIN)) return 0.0f;
+    const uint32_t bits = float_bits(p);
+    const int32_t k = (static_cast<int32_t>(bits >> 23) - 127) >> 1;   // p = m * 4^k
+    const float m = bits_float(bits - (static_cast<uint32_t>(k) << 24));
+    const float root = ((SQRT_C3 * m + SQRT_C2) * m + SQRT_C1) * m + SQRT_C0;
+    return bits_float(float_bits(root) + (static_cast<uint32_t>(k) << 23));
+}
+
+/**
+ * magnitude_poly(): |x| within 0.11%
+ */
+inline float magnitude_poly(std::complex<float> x) {
+    return sqrt_poly(x.real() * x.real() + x.imag() * x.imag());
+}
+
+/**
+ * fast_log2(): log2(p) within 6.4e-4 (p clamped to FLT_MIN)
+ */
+inline float fast_log2(float p) {
+    if (!(p >= FLT_MIN)) p = FLT_MIN;
+    const uint32_t bits = float_bits(p);
+    const float e = static_cast<float>(static_cast<int32_t>(bits >> 23) - 127);
+    const float m = bits_float((bits & 0x007FFFFFu) | 0x3F800000u);
+    return e + (((LOG2_C3 * m + LOG2_C2) * m + LOG2_C1) * m + LOG2_C0);
+}
+
+/**
+ * fast_db(): 10 log10(power) within 0.002 dB
+ */
+inline float fast_db(double power) {
+    return DB_PER_LOG2 * fast_log2(static_cast<float>(power));
+}
+
+/**
+ * fast_dbfs(): Power in dB relative to a full-scale fc32 sample
+ */
+inline float fast_dbfs(double power) {
+    return fast_db(power / FULL_SCALE_POWER);
+}
+
+// ============================================================================
+// BUFFER KERNELS
+// ============================================================================
+
+#if defined(__SSE2__) || defined(_M_X64)
+// Four complex samples -> their I and Q parts
+inline void split_iq_sse(const float* src, __m128& re, __m128& im) {
+    const __m128 a = _mm_loadu_ps(src);
+    const __m128 b = _mm_loadu_ps(src + 4);
+    re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+// sqrt_poly() on four lanes
+inline __m128 sqrt_poly_sse(__m128 p) {
+    const __m128i bits = _mm_castps_si128(p);
+    const __m128i k = _mm_srai_epi32(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)), 1);
+    const __m128 m = _mm_castsi128_ps(_mm_sub_epi32(bits, _mm_slli_epi32(k, 24)));
+    __m128 root = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SQRT_C3), m), _mm_set1_ps(SQRT_C2));
+    root = _mm_add_ps(_mm_mul_ps(root, m), _mm_set1_ps(SQRT_C1));
+    root = _mm_add_ps(_mm_mul_ps(root, m), _mm_set1_ps(SQRT_C0));
+    root = _mm_castsi128_ps(_mm_add_epi32(_mm_castps_si128(root), _mm_slli_epi32(k, 23)));
+    return _mm_and_ps(root, _mm_cmpge_ps(p, _mm_set1_ps(FLT_MIN)));
+}
+#endif
+
+/**
+ * magnitude_amax_bmin(): Approximate |x| of a buffer (+-3.96%)
+ * @param in: Complex samples
+ * @param count: Number of samples
+ * @param out: count magnitudes
+ */
+inline void magnitude_amax_bmin(const std::complex<float>* in, size_t count, float* out) {
+    size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+    const float* src = reinterpret_cast<const float*>(in);
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 alpha = _mm_set1_ps(AMBM_ALPHA), beta = _mm_set1_ps(AMBM_BETA);
+    for (; i < count / 4 * 4; i += 4) {
+        __m128 re, im;
+        split_iq_sse(src + 2 * i, re, im);
+        re = _mm_and_ps(re, abs_mask);
+        im = _mm_and_ps(im, abs_mask);
+        const __m128 mag = _mm_add_ps(_mm_mul_ps(alpha, _mm_max_ps(re, im)),
+                                      _mm_mul_ps(beta, _mm_min_ps(re, im)));
+        _mm_storeu_ps(out + i, mag);
+    }
+#endif
+    for (; i < count; i++) out[i] = magnitude_amax_bmin(in[i]);
+}
+
+/**
+ * magnitude_poly(): Approximate |x| of a buffer (0.11%)
+ * @param in: Complex samples
+ * @param count: Number of samples
+ * @param out: count magnitudes
+ */
+inline void magnitude_poly(const std::complex<float>* in, size_t count, float* out) {
+    size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+    const float* src = reinterpret_cast<const float*>(in);
+    for (; i < count / 4 * 4; i += 4) {
+        __m128 re, im;
+        split_iq_sse(src + 2 * i, re, im);
+        const __m128 p = _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im));
+        _mm_storeu_ps(out + i, sqrt_poly_sse(p));
+    }
+#endif
+    for (; i < count; i++) out[i] = magnitude_poly(in[i]);
+}
+
+/**
+ * power_to_db(): 10 log10() of a buffer of powers (0.002 dB)
+ * @param in: Powers (linear)
+ * @param count: Number of values
+ * @param out: count values in dB (may alias in)
+ */
+inline void power_to_db(const float* in, size_t count, float* out) {
+    size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128i mantissa = _mm_set1_epi32(0x007FFFFF), one = _mm_set1_epi32(0x3F800000);
+    for (; i < count / 4 * 4; i += 4) {
+        // _mm_max_ps returns its second operand for NaN
+        const __m128 p = _mm_max_ps(_mm_loadu_ps(in + i), _mm_set1_ps(FLT_MIN));
+        const __m128i bits = _mm_castps_si128(p);
+        const __m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+        const __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, mantissa), one));
+        __m128 poly = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(LOG2_C3), m), _mm_set1_ps(LOG2_C2));
+        poly = _mm_add_ps(_mm_mul_ps(poly, m), _mm_set1_ps(LOG2_C1));
+        poly = _mm_add_ps(_mm_mul_ps(poly, m), _mm_set1_ps(LOG2_C0));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_set1_ps(DB_PER_LOG2), _mm_add_ps(e, poly)));
+    }
+#endif
+    for (; i < count; i++) out[i] = DB_PER_LOG2 * fast_log2(in[i]);
+}
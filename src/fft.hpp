@@ -0,0 +1,100 @@
+/*
+ * EEL6528 Lab 1: In-tree radix-2 FFT
+ *
+ * Iterative decimation-in-time FFT for power-of-two sizes, enough for fast
+ * convolution without pulling in FFTW. Twiddles are computed once per size
+ * in double precision and stored stage by stage, so each butterfly pass
+ * reads them contiguously.
+ *
+ * Complex products are written out on floats: std::complex<float>
+ * multiplication goes through the C99 inf/NaN recovery path unless the
+ * whole program is built with -ffast-math.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ * Fft: plan for one transform size
+ *
+ * forward() computes X[k] = sum x[n] e^{-j2pi kn/N}; inverse() uses the
+ * conjugate kernel and is NOT scaled by 1/N (callers fold the scale into
+ * whatever they multiply in the frequency domain).
+ */
+class Fft {
+public:
+    /**
+     * Constructor
+     * @param size: Transform length, a power of two >= 2
+     */
+    explicit Fft(size_t size) : n(size) {
+        if (n < 2 || (n & (n - 1)) != 0) {
+            throw std::invalid_argument("FFT size must be a power of two >= 2");
+        }
+        // Bit-reversal swap pairs
+        size_t bits = 0;
+        while ((size_t(1) << bits) < n) bits++;
+        for (size_t i = 0; i < n; i++) {
+            size_t r = 0;
+            for (size_t b = 0; b < bits; b++) r |= ((i >> b) & 1) << (bits - 1 - b);
+            if (i < r) swaps.emplace_back(i, r);
+        }
+        // Twiddles for each stage (len = 2, 4, ..., n): e^{-j2pi j/len}, j < len/2
+        for (size_t len = 2; len <= n; len <<= 1) {
+            for (size_t j = 0; j < len / 2; j++) {
+                double angle = -2.0 * 3.14159265358979323846 * j / len;
+                twiddle_re.push_back(static_cast<float>(std::cos(angle)));
+                twiddle_im.push_back(static_cast<float>(std::sin(angle)));
+            }
+        }
+    }
+
+    size_t size() const { return n; }
+
+    // In-place forward transform
+    void forward(std::complex<float>* data) const { transform(data, false); }
+
+    // In-place inverse transform (unscaled)
+    void inverse(std::complex<float>* data) const { transform(data, true); }
+
+private:
+    void transform(std::complex<float>* data, bool inverse) const {
+        for (const auto& s : swaps) std::swap(data[s.first], data[s.second]);
+
+        float* x = reinterpret_cast<float*>(data);
+        const float sign = inverse ? -1.0f : 1.0f;   // Conjugate twiddles
+        size_t offset = 0;
+        for (size_t len = 2; len <= n; len <<= 1) {
+            const size_t half = len / 2;
+            const float* wr = twiddle_re.data() + offset;
+            const float* wi = twiddle_im.data() + offset;
+            for (size_t start = 0; start < n; start += len) {
+                float* a = x + 2 * start;
+                float* b = x + 2 * (start + half);
+                for (size_t j = 0; j < half; j++) {
+                    const float tw_im = sign * wi[j];
+                    const float br = b[2 * j] * wr[j] - b[2 * j + 1] * tw_im;
+                    const float bi = b[2 * j] * tw_im + b[2 * j + 1] * wr[j];
+                    const float ar = a[2 * j];
+                    const float ai = a[2 * j + 1];
+                    a[2 * j] = ar + br;
+                    a[2 * j + 1] = ai + bi;
+                    b[2 * j] = ar - br;
+                    b[2 * j + 1] = ai - bi;
+                }
+            }
+            offset += half;
+        }
+    }
+
+    size_t n;
+    std::vector<std::pair<size_t, size_t>> swaps;   // Bit-reversal permutation
+    std::vector<float> twiddle_re;                  // All stages, concatenated
+    std::vector<float> twiddle_im;
+};
@@ -0,0 +1,203 @@
+/*
+ * EEL6528 Lab 1: Goertzel filter bank for tone and pilot tracking
+ *
+ * When only a handful of frequencies matter (pilots, known interferers), a
+ * full FFT of every block computes thousands of bins to read a few. The
+ * Goertzel recursion computes one DFT value per frequency for about two
+ * real multiplies per complex sample:
+ *   s[n] = x[n] + 2 cos(w) s[n-1] - s[n-2]
+ *   sum_n x[n] e^{-jwn} = e^{-jw(N-1)} (s[N-1] - e^{-jw} s[N-2])
+ * The frequencies need not fall on an FFT bin.
+ *
+ * VECTORIZED ACROSS BINS:
+ * The states of all bins are kept as separate re / im arrays padded to
+ * LANES. The inner loop runs over the bins for one sample, a contiguous
+ * multiply-add that the compiler vectorizes without reordering any sum.
+ * A bank of 8 bins costs about as much as one (8 doubles: two AVX
+ * registers per state array).
+ *
+ * STATE ACROSS BLOCKS:
+ * As with the Mixer (dsp_stages.hpp), the phase of each bin value is
+ * referenced to the absolute stream index of the block's first sample.
+ * Any worker can process any block, and a steady tone gives the same
+ * phase in every block. ToneTracker carries what does depend on block
+ * order: smoothed bin power, and the frequency offset measured from the
+ * phase advance between consecutive blocks.
+ *
+ * FFT CROSSOVER:
+ * The bank costs O(bins) per sample and an FFT of the block O(log N).
+ * Up to LANES bins the cost is flat (~7-11 ns per sample); after that it
+ * grows by about 1 ns per bin against ~20-30 ns per sample for
+ * a 16384-point FFT with the power of every bin. dsp_bench ("tones")
+ * measures the crossover; GOERTZEL_CROSSOVER_BINS is its lower end.
+ *
+ * PRECISION:
+ * The recursion runs in double; only the input samples are float. Near
+ * DC (cos(w) -> 1) s[n] grows like N^2 times the tone amplitude and the
+ * output is a small difference of large states, so a float recursion lost
+ * most of its digits there (up to ~1e+01 relative error at f = 1e-4 of fs
+ * for N = 10000). In double, dsp_bench ("tones") measures relative errors
+ * against a direct DFT of ~2e-12 across the band for N = 10000, and at
+ * most ~1e-7 at f = 0 and 1e-4 of fs for N = 10000 and 262144. Double
+ * state costs about twice the float recursion per sample.
+ */
+
+#pragma once
+
+#include "dsp_stages.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+// Bins above which one FFT of the block is cheaper (dsp_bench tones:
+// 24-32 bins for 10000-sample blocks on the development machine)
+const size_t GOERTZEL_CROSSOVER_BINS = 24;
+
+/**
+ * ToneBin: one frequency's DFT value over a block
+ */
+struct ToneBin {
+    std::complex<double> value;     // sum x[n] e^{-jw(start + n)}
+    double power = 0.0;             // |value / N|^2: power of a tone at w (fc32 units)
+};
+
+/**
+ * GoertzelBank: a fixed set of frequencies evaluated over each block
+ */
+class GoertzelBank {
+public:
+    static const size_t LANES = 8;                 // Bins per vector step (2 x AVX doubles)
+
+    /**
+     * Constructor
+     * @param freqs_norm: Frequencies as fractions of the sampling rate (-0.5..0.5)
+     */
+    explicit GoertzelBank(const std::vector<double>& freqs_norm) : freqs(freqs_norm) {
+        padded = (freqs.size() + LANES - 1) / LANES * LANES;
+        coeff.assign(padded, 0.0);
+        for (size_t k = 0; k < freqs.size(); k++) {
+            coeff[k] = 2.0 * std::cos(2.0 * DSP_PI * freqs[k]);
+        }
+        s1r.resize(padded);
+        s1i.resize(padded);
+        s2r.resize(padded);
+        s2i.resize(padded);
+    }
+
+    size_t size() const { return freqs.size(); }
+    double frequency(size_t k) const { return freqs[k]; }
+
+    /**
+     * process(): Evaluate every frequency over one block
+     * @param start_index: Stream index of in[0] (phase reference)
+     * @param in: Block samples
+     * @param n: Number of samples
+     * @param out: Receives size() bins
+     */
+    void process(uint64_t start_index, const std::complex<float>* in, size_t n, std::vector<ToneBin>& out) {
+        std::fill(s1r.begin(), s1r.end(), 0.0);
+        std::fill(s1i.begin(), s1i.end(), 0.0);
+        std::fill(s2r.begin(), s2r.end(), 0.0);
+        std::fill(s2i.begin(), s2i.end(), 0.0);
+        double* __restrict a_r = s1r.data();
+        double* __restrict a_i = s1i.data();
+        double* __restrict b_r = s2r.data();
+        double* __restrict b_i = s2i.data();
+        const double* __restrict c = coeff.data();
+        const float* x = reinterpret_cast<const float*>(in);
+        for (size_t i = 0; i < n; i++) {
+            const double xr = x[2 * i];
+            const double xi = x[2 * i + 1];
+            for (size_t k = 0; k < padded; k++) {
+                const double nr = xr + c[k] * a_r[k] - b_r[k];
+                const double ni = xi + c[k] * a_i[k] - b_i[k];
+                b_r[k] = a_r[k];
+                b_i[k] = a_i[k];
+                a_r[k] = nr;
+                a_i[k] = ni;
+            }
+        }
+
+        out.resize(freqs.size());
+        for (size_t k = 0; k < freqs.size(); k++) {
+            const double w = 2.0 * DSP_PI * freqs[k];
+            const std::complex<double> s1(a_r[k], a_i[k]);
+            const std::complex<double> s2(b_r[k], b_i[k]);
+            const std::complex<double> tail = s1 - std::polar(1.0, -w) * s2;
+            // e^{-jw(start + N - 1)}, computed like Mixer::anchor_phasor()
+            double cycles = freqs[k] * static_cast<double>(start_index + (n > 0 ? n - 1 : 0));
+            cycles -= std::floor(cycles);
+            out[k].value = tail * std::polar(1.0, -2.0 * DSP_PI * cycles);
+            out[k].power = n > 0 ? std::norm(out[k].value) / (static_cast<double>(n) * n) : 0.0;
+        }
+    }
+
+private:
+    std::vector<double> freqs;
+    size_t padded = 0;
+    std::vector<double> coeff;                     // 2 cos(w), padded with 0
+    std::vector<double> s1r, s1i, s2r, s2i;        // s[n-1], s[n-2] per bin
+};
+
+/**
+ * ToneTracker: per-frequency state carried from block to block
+ *
+ * - power: exponentially smoothed bin power (SMOOTHING per block)
+ * - offset: tone frequency minus the bin frequency, from the phase advance
+ *   between consecutive blocks:
+ *     offset = arg(X_b conj(X_{b-1})) / (2 pi * distance between the
+ *     blocks' centres)
+ *   unambiguous within +-rate / (2 * block length); smoothed like the power
+ * Blocks arriving out of order still update the power; the offset only
+ * uses consecutive block numbers.
+ */
+class ToneTracker {
+public:
+    static constexpr double SMOOTHING = 0.1;
+
+    struct Track {
+        double power = 0.0;             // Smoothed bin power (fc32 units)
+        double offset = 0.0;            // Smoothed frequency offset (fraction of the rate)
+        uint64_t offset_updates = 0;    // Consecutive block pairs measured
+    };
+
+    explicit ToneTracker(size_t bins) : tracks(bins), last(bins) {}
+
+    /**
+     * update(): Fold in one block's bins
+     * @param block_number: Sequential block identifier
+     * @param start_index: Stream index of the block's first sample
+     * @param n: Block length
+     */
+    void update(uint64_t block_number, uint64_t start_index, size_t n, const std::vector<ToneBin>& bins) {
+        const bool consecutive = blocks > 0 && block_number == last_block + 1;
+        const double centre = static_cast<double>(start_index) + n / 2.0;
+        for (size_t k = 0; k < bins.size() && k < tracks.size(); k++) {
+            Track& t = tracks[k];
+            t.power = (blocks == 0) ? bins[k].power : t.power + SMOOTHING * (bins[k].power - t.power);
+            if (consecutive && std::abs(bins[k].value) > 0.0 && std::abs(last[k]) > 0.0) {
+                const double step = std::arg(bins[k].value * std::conj(last[k]));
+                const double offset = step / (2.0 * DSP_PI * (centre - last_centre));
+                t.offset = (t.offset_updates == 0) ? offset : t.offset + SMOOTHING * (offset - t.offset);
+                t.offset_updates++;
+            }
+            last[k] = bins[k].value;
+        }
+        last_block = block_number;
+        last_centre = centre;
+        blocks++;
+    }
+
+    const Track& track(size_t k) const { return tracks[k]; }
+    uint64_t updates() const { return blocks; }
+
+private:
+    std::vector<Track> tracks;
+    std::vector<std::complex<double>> last;   // Previous block's bin values
+    uint64_t last_block = 0;
+    double last_centre = 0.0;
+    uint64_t blocks = 0;
+};
@@ -0,0 +1,199 @@
+/*
+ * EEL6528 Lab 1: Streaming DC-offset and IQ-imbalance correction
+ *
+ * The N210 front end adds a DC offset (LO leakage) and a small gain/phase
+ * mismatch between the I and Q paths. Both bias avg_power and create a
+ * spike at DC and a mirror image in the spectrum.
+ *
+ * MODEL (after DC removal, a/b = ideal I/Q):
+ *   I = a
+ *   Q = g * (b*cos(phi) + a*sin(phi))        g = gain, phi = phase imbalance
+ * With a and b uncorrelated and of equal power, second-order statistics give
+ *   g       = sqrt(E[Q^2] / E[I^2])
+ *   sin(phi) = E[IQ] / sqrt(E[I^2] * E[Q^2])
+ * and the correction is
+ *   I' = I
+ *   Q' = Q / (g*cos(phi)) - I * tan(phi)
+ *
+ * ESTIMATION:
+ * DC and the three second moments are tracked with slow exponential
+ * averages of the per-block statistics (one update per block). The block
+ * statistics are gathered in the same pass that applies the current
+ * correction, so each sample is read and written exactly once.
+ */
+
+#pragma once
+
+#include "sample_format.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <mutex>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+/**
+ * IqEstimates: current corrector state, exposed as metrics
+ */
+struct IqEstimates {
+    std::complex<double> dc;        // DC offset (fc32 units)
+    double gain_db = 0.0;           // Q/I amplitude mismatch, 20*log10(g)
+    double phase_deg = 0.0;         // Quadrature phase error
+    double image_rejection_db = 0.0; // Image rejection of the uncorrected front end
+    uint64_t blocks = 0;            // Blocks folded into the estimates
+};
+
+/**
+ * IqCorrector: recursive DC / IQ-imbalance estimator and in-place corrector
+ *
+ * Used from one thread (the RX thread), so the correction applied to each
+ * block depends only on the blocks before it.
+ */
+class IqCorrector {
+public:
+    /**
+     * Constructor
+     * @param alpha: Per-block averaging weight (time constant ~1/alpha blocks)
+     */
+    explicit IqCorrector(double alpha = 0.02) : weight(alpha) {}
+
+    /**
+     * correct(): Apply the current correction in place and update estimates
+     * @param samples: fc32 samples, overwritten with corrected values
+     * @param count: Number of complex samples
+     */
+    void correct(std::complex<float>* samples, size_t count) {
+        BlockStats stats;
+        apply(reinterpret_cast<float*>(samples), count, stats);
+        update(stats, count);
+    }
+
+    /**
+     * correct(): sc8 variant; corrects through a small fc32 staging buffer
+     * and requantizes with the block's scale (saturating)
+     * @param scale: fc32 amplitude of one int8 step
+     */
+    void correct(std::complex<int8_t>* samples, size_t count, float scale) {
+        BlockStats stats;
+        std::complex<float> staging[STAGING_SAMPLES];
+        for (size_t start = 0; start < count; start += STAGING_SAMPLES) {
+            const size_t chunk = std::min(STAGING_SAMPLES, count - start);
+            unpack_sc8(samples + start, chunk, staging, scale);
+            apply(reinterpret_cast<float*>(staging), chunk, stats);
+            pack_sc8(staging, chunk, samples + start, 1.0f / scale);
+        }
+        update(stats, count);
+    }
+
+    // Snapshot of the estimates (safe from any thread)
+    IqEstimates estimates() const {
+        std::lock_guard<std::mutex> lock(metrics_mtx);
+        return published;
+    }
+
+private:
+    static const size_t STAGING_SAMPLES = 512;
+
+    // Per-block sums gathered during the correction pass
+    struct BlockStats {
+        double sum_i = 0.0, sum_q = 0.0;     // Raw samples (DC)
+        double ii = 0.0, qq = 0.0, iq = 0.0; // DC-removed second moments
+    };
+
+    /**
+     * apply(): One pass: y = correct(x), accumulate statistics of x
+     */
+    void apply(float* x, size_t count, BlockStats& stats) const {
+        const float dc_i = static_cast<float>(dc.real());
+        const float dc_q = static_cast<float>(dc.imag());
+        const float c_ii = static_cast<float>(q_from_i);
+        const float c_qq = static_cast<float>(q_from_q);
+        size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+        // Two complex samples per iteration: [I0 Q0 I1 Q1]
+        const __m128 dc_v = _mm_setr_ps(dc_i, dc_q, dc_i, dc_q);
+        const __m128 keep = _mm_setr_ps(1.0f, c_qq, 1.0f, c_qq);
+        const __m128 cross = _mm_setr_ps(0.0f, c_ii, 0.0f, c_ii);
+        __m128 sum_raw = _mm_setzero_ps(), sum_sq = _mm_setzero_ps(), sum_cross = _mm_setzero_ps();
+        for (; i + 2 <= count; i += 2) {
+            __m128 raw = _mm_loadu_ps(x + 2 * i);
+            __m128 c = _mm_sub_ps(raw, dc_v);
+            __m128 i_dup = _mm_shuffle_ps(c, c, _MM_SHUFFLE(2, 2, 0, 0));   // [I0 I0 I1 I1]
+            __m128 swapped = _mm_shuffle_ps(c, c, _MM_SHUFFLE(2, 3, 0, 1)); // [Q0 I0 Q1 I1]
+            sum_raw = _mm_add_ps(sum_raw, raw);
+            sum_sq = _mm_add_ps(sum_sq, _mm_mul_ps(c, c));
+            sum_cross = _mm_add_ps(sum_cross, _mm_mul_ps(c, swapped));
+            _mm_storeu_ps(x + 2 * i, _mm_add_ps(_mm_mul_ps(c, keep), _mm_mul_ps(i_dup, cross)));
+        }
+        alignas(16) float lanes[3][4];
+        _mm_store_ps(lanes[0], sum_raw);
+        _mm_store_ps(lanes[1], sum_sq);
+        _mm_store_ps(lanes[2], sum_cross);
+        stats.sum_i += double(lanes[0][0]) + lanes[0][2];
+        stats.sum_q += double(lanes[0][1]) + lanes[0][3];
+        stats.ii += double(lanes[1][0]) + lanes[1][2];
+        stats.qq += double(lanes[1][1]) + lanes[1][3];
+        stats.iq += double(lanes[2][0]) + lanes[2][2];
+#endif
+        // Scalar tail (or whole block without SSE)
+        for (; i < count; i++) {
+            const float re = x[2 * i], im = x[2 * i + 1];
+            const float ci = re - dc_i, cq = im - dc_q;
+            stats.sum_i += re;
+            stats.sum_q += im;
+            stats.ii += double(ci) * ci;
+            stats.qq += double(cq) * cq;
+            stats.iq += double(ci) * cq;
+            x[2 * i] = ci;
+            x[2 * i + 1] = c_qq * cq + c_ii * ci;
+        }
+    }
+
+    /**
+     * update(): Fold one block's statistics into the running estimates and
+     * recompute the correction coefficients
+     */
+    void update(const BlockStats& stats, size_t count) {
+        if (count == 0) return;
+        const double n = static_cast<double>(count);
+        const std::complex<double> block_dc(stats.sum_i / n, stats.sum_q / n);
+        const double a = (blocks == 0) ? 1.0 : weight;      // First block seeds the averages
+        dc += a * (block_dc - dc);
+        ii += a * (stats.ii / n - ii);
+        qq += a * (stats.qq / n - qq);
+        iq += a * (stats.iq / n - iq);
+        blocks++;
+        if (ii <= 0.0 || qq <= 0.0) return;
+
+        const double g = std::sqrt(qq / ii);
+        const double sin_phi = std::max(-0.5, std::min(0.5, iq / std::sqrt(ii * qq)));
+        const double cos_phi = std::sqrt(1.0 - sin_phi * sin_phi);
+        q_from_i = -sin_phi / cos_phi;
+        q_from_q = 1.0 / (g * cos_phi);
+
+        IqEstimates snapshot;
+        snapshot.dc = dc;
+        snapshot.gain_db = 20.0 * std::log10(g);
+        snapshot.phase_deg = std::asin(sin_phi) * 180.0 / 3.14159265358979323846;
+        const double image = 1.0 - 2.0 * g * cos_phi + g * g;
+        snapshot.image_rejection_db = (image > 0.0)
+            ? 10.0 * std::log10((1.0 + 2.0 * g * cos_phi + g * g) / image) : 300.0;
+        snapshot.blocks = blocks;
+        std::lock_guard<std::mutex> lock(metrics_mtx);
+        published = snapshot;
+    }
+
+    double weight;                      // EMA weight per block
+    std::complex<double> dc;            // Tracked DC offset
+    double ii = 0.0, qq = 0.0, iq = 0.0; // Tracked second moments (DC removed)
+    double q_from_i = 0.0;              // Q' = q_from_q * Q + q_from_i * I
+    double q_from_q = 1.0;
+    uint64_t blocks = 0;
+
+    mutable std::mutex metrics_mtx;     // Guards published only
+    IqEstimates published;
+};
@@ -39,12 +39,48 @@
 #include <complex>           // Complex number support for IQ samples
 #include <vector>            // Dynamic arrays for sample storage
 #include <thread>            // Multi-threading support
-#include <queue>             // FIFO queue for sample blocks
+#include <deque>             // FIFO lanes for sample blocks
 #include <mutex>             // Mutual exclusion for thread safety
 #include <condition_variable> // Thread synchronization primitives
 #include <atomic>            // Atomic operations for lock-free programming
 #include <chrono>            // Time-related functions and types
 #include <iomanip>           // I/O stream formatting
+#include <algorithm>         // Standard algorithms (find, etc.)
+#include <string>            // String manipulation
+#include <memory>            // Smart pointers
+#include <map>               // Key/value stream arguments (simulation)
+#include <cmath>             // Mathematical functions (log10, etc.)
+#include <cstdint>           // Fixed-width integer sample types
+#include <ctime>             // Per-thread CPU clock (clock_gettime)
+#include <sstream>           // Result lines formatted for the output sink
+#include <stdexcept>         // std::stod / std::stoul errors in option parsing
+#include <pthread.h>         // Thread affinity (pthread_setaffinity_np)
+#include <sched.h>           // CPU sets
+#include <sys/resource.h>    // CPU usage (getrusage)
+#ifdef __linux__
+#include <sys/prctl.h>       // Timer slack (PR_SET_TIMERSLACK)
+#endif
+
+// Project Headers
+#include "sample_format.hpp" // Wire formats and SIMD power kernels
+#include "sample_block.hpp"  // SampleBlock shared with other tools
+#include "power_estimate.hpp" // Exact / subsampled power with error bounds
+#include "dsp_stages.hpp"    // Mixer / FIR channel selector, reorder buffer
+#include "resampler.hpp"     // Polyphase rational resampler
+#include "iq_correction.hpp" // Streaming DC / IQ-imbalance correction
+#include "noise_floor.hpp"   // Minimum-statistics noise floor and SNR
+#include "squelch.hpp"       // Noise-floor squelch gate
+#include "burst_segmenter.hpp" // Burst extraction with pooled storage
+#include "capture_file.hpp"  // Capture container for recording and replay
+#include "watchdog.hpp"      // Stall detection for the RX and worker threads
+#include "block_sizer.hpp"   // Latency-targeted dynamic block sizing
+#include "output_sink.hpp"   // Asynchronous bulk output of result lines
+#include "control_socket.hpp" // Unix-domain control socket
+#include "metrics_server.hpp" // Prometheus endpoint, latency histogram
+#include "rollup_store.hpp"   // Per-second / minute / hour trend files
+#include "quantile_sketch.hpp" // Mergeable KLL sketches for power percentiles
+#include "goertzel_bank.hpp"  // Goertzel bins for tone / pilot tracking
+#include "fast_magnitude.hpp" // Approximate magnitude and fast dB / dBFS
 
 using namespace std;
 
@@ -53,44 +89,25 @@ using namespace std;
 // MOCK UHD TYPES FOR SIMULATION MODE
 // ============================================================================
 // These mock implementations allow the program to compile and run without
-// actual UHD hardware, generating synthetic data for development and testing
+// actual UHD hardware, generating synthetic data for development and testing.
+// The mock streamer paces itself at the requested sampling rate and models
+// the Gigabit Ethernet link: wire formats whose byte rate exceeds the link
+// capacity report overflows, just like the N210 does.
 namespace uhd {
-    namespace usrp {
-        struct multi_usrp {
-            typedef shared_ptr<multi_usrp> sptr;
-            static sptr make(const string& args) { return nullptr; }
-            void set_rx_rate(double rate) {}
-            double get_rx_rate() { return 1e6; }
-            void set_rx_freq(double freq) {}
-            double get_rx_freq() { return 2.437e9; }
-            void set_rx_gain(double gain) {}
-            double get_rx_gain() { return 30.0; }
-            string get_pp_string() { return "Mock USRP"; }
-            vector<string> get_rx_sensor_names() { return {}; }
-        };
-    }
     struct tune_request_t {
-        tune_request_t(double f) {}
+        tune_request_t(double f) : target_freq(f) {}
+        double target_freq;
     };
     struct time_spec_t {};
     struct sensor_value_t {
         string to_pp_string() { return "Mock Sensor"; }
         bool to_bool() { return true; }
     };
-    struct rx_streamer {
-        typedef shared_ptr<rx_streamer> sptr;
-        size_t recv(complex<float>* buff, size_t size, void* md, double timeout) {
-            // Generate mock data
-            for(size_t i = 0; i < size; i++) {
-                buff[i] = complex<float>(0.1f * sin(i * 0.01f), 0.1f * cos(i * 0.01f));
-            }
-            this_thread::sleep_for(chrono::milliseconds(10)); // Simulate data rate
-            return size;
-        }
-        void issue_stream_cmd(void* cmd) {}
-    };
     struct stream_args_t {
-        stream_args_t(const string& cpu, const string& wire) {}
+        stream_args_t(const string& cpu, const string& wire) : cpu_format(cpu), otw_format(wire) {}
+        string cpu_format;           // Host sample format ("fc32" / "sc8")
+        string otw_format;           // Over-the-wire format ("sc16" / "sc8")
+        map<string, string> args;    // Extra arguments (e.g. "peak" for sc8)
     };
     struct stream_cmd_t {
         enum stream_mode_t { STREAM_MODE_START_CONTINUOUS, STREAM_MODE_STOP_CONTINUOUS };
@@ -105,6 +122,284 @@ namespace uhd {
         error_code_t error_code = ERROR_CODE_NONE;
         string strerror() { return "Mock error"; }
     };
+    struct rx_streamer {
+        typedef shared_ptr<rx_streamer> sptr;
+
+        rx_streamer(const stream_args_t& args, double rate, shared_ptr<CaptureReader> capture)
+            : sample_rate(rate), replay(capture) {
+            host_sc8 = (args.cpu_format == "sc8");
+            wire_bytes = (args.otw_format == "sc8") ? 2.0 : 4.0;
+            auto peak = args.args.find("peak");
+            sc8_peak = (peak != args.args.end()) ? stof(peak->second) : 1.0f;
+        }
+
+        /**
+         * recv(): Generate one buffer of synthetic IQ samples
+         * Signal: complex tone with slowly varying amplitude (0.05..0.15) plus
+         * uniform noise, written as fc32 or quantized to sc8 per cpu_format.
+         * Front-end impairments like an N210's: DC offset and a small IQ
+         * gain/phase imbalance (see iq_correction.hpp).
+         * The transmitter is keyed on and off at random (bursts of 2k-30k
+         * samples, gaps of 5k-60k), so bursts start and end mid-block and
+         * many blocks hold noise only.
+         * When replaying a capture, its samples are delivered instead (same
+         * pacing and link model), converted to the requested host format.
+         * With stall_at, the radio stops delivering that many seconds into
+         * the stream (recv() blocks for the timeout, then times out) until
+         * the stream is restarted, like an N210 after a link glitch.
+         */
+        size_t recv(void* buff, size_t size, rx_metadata_t& md, double timeout) {
+            md.error_code = rx_metadata_t::ERROR_CODE_NONE;
+            if (streaming && stall_at > 0.0 &&
+                chrono::steady_clock::now() - stream_start >= chrono::duration<double>(stall_at)) {
+                stall_at = 0.0;   // One-shot
+                hung = true;
+            }
+            if (!streaming || hung) {
+                if (hung) this_thread::sleep_for(chrono::duration<double>(timeout));
+                md.error_code = rx_metadata_t::ERROR_CODE_TIMEOUT;
+                return 0;
+            }
+
+            // Pace at the sampling rate; falling far behind means the host
+            // did not drain the NIC buffers in time -> overflow
+            auto block_time = chrono::duration_cast<chrono::steady_clock::duration>(
+                chrono::duration<double>(size / sample_rate));
+            next_deadline += block_time;
+            auto now = chrono::steady_clock::now();
+            if (now > next_deadline + chrono::milliseconds(50)) {
+                next_deadline = now;
+                md.error_code = rx_metadata_t::ERROR_CODE_OVERFLOW;
+                return 0;
+            }
+            this_thread::sleep_until(next_deadline);
+
+            // Link model: the fraction of packets above the GigE capacity is lost
+            double demand = sample_rate * wire_bytes;
+            if (demand > GIGE_LINK_BYTES_PER_SEC) {
+                link_deficit += 1.0 - GIGE_LINK_BYTES_PER_SEC / demand;
+                if (link_deficit >= 1.0) {
+                    link_deficit -= 1.0;
+                    md.error_code = rx_metadata_t::ERROR_CODE_OVERFLOW;
+                    return 0;
+                }
+            }
+
+            if (replay) {
+                return replay_samples(buff, size, md);
+            }
+            
+            block_count++;
+            const float amplitude = 0.1f + 0.05f * sin(block_count * 0.1f);
+            const float inv_step = 127.0f / sc8_peak;
+            const float step = sc8_peak / 127.0f;
+            for (size_t i = 0; i < size; i++) {
+                if (key_remaining == 0) {
+                    keyed = !keyed;
+                    key_remaining = keyed ? 2000 + key_random() % 28000 : 5000 + key_random() % 55000;
+                }
+                key_remaining--;
+                complex<float> ideal = (keyed ? amplitude * phasor : complex<float>(0.0f, 0.0f))
+                                     + complex<float>(0.02f * noise(), 0.02f * noise());
+                complex<float> x(ideal.real() + dc_offset.real(),
+                                 iq_gain * (ideal.imag() * cos_phase + ideal.real() * sin_phase)
+                                 + dc_offset.imag());
+                phasor *= rotation;
+                if (host_sc8) {
+                    int8_t qi = quantize_sc8(x.real(), inv_step);
+                    int8_t qq = quantize_sc8(x.imag(), inv_step);
+                    static_cast<complex<int8_t>*>(buff)[i] = complex<int8_t>(qi, qq);
+                    complex<float> err = x - complex<float>(qi * step, qq * step);
+                    signal_energy += norm(x);
+                    error_energy += norm(err);
+                } else {
+                    static_cast<complex<float>*>(buff)[i] = x;
+                }
+            }
+            phasor /= abs(phasor);   // Keep the oscillator on the unit circle
+            return size;
+        }
+
+        void issue_stream_cmd(const stream_cmd_t& cmd) {
+            streaming = (cmd.stream_mode == stream_cmd_t::STREAM_MODE_START_CONTINUOUS);
+            next_deadline = chrono::steady_clock::now();
+            if (streaming) {
+                hung = false;
+                if (stream_start == chrono::steady_clock::time_point()) stream_start = next_deadline;
+            }
+        }
+
+        // Seconds into the stream at which the mock radio stops delivering
+        void set_stall_at(double seconds) { stall_at = seconds; }
+
+        // Mock only: a rate change on the device reaches its streamer
+        void set_sample_rate(double rate) { sample_rate = rate; }
+
+        // Measured signal-to-quantization-noise ratio of the sc8 path (dB)
+        double measured_sqnr_db() const {
+            if (error_energy <= 0.0) return 0.0;
+            return 10.0 * log10(signal_energy / error_energy);
+        }
+
+    private:
+        /**
+         * replay_samples(): Next samples of the replayed capture
+         * Every chunk's checksum is verified before use; a corrupt chunk is
+         * dropped and reported like lost packets (overflow). At the end of
+         * the capture the stream stops (the next recv() times out).
+         */
+        size_t replay_samples(void* buff, size_t size, rx_metadata_t& md) {
+            const CaptureInfo& info = replay->info();
+            const CaptureView view = replay->view();
+            const float inv_step = 127.0f / sc8_peak;
+            size_t filled = 0;
+            while (filled < size && replay_chunk < replay->num_chunks()) {
+                if (replay_offset == 0 && !verify_chunk(view, replay_chunk)) {
+                    cerr << "[Replay] Chunk " << replay_chunk << " failed its checksum - dropped" << endl;
+                    replay_chunk++;
+                    md.error_code = rx_metadata_t::ERROR_CODE_OVERFLOW;
+                    return 0;
+                }
+                const size_t take = min(size - filled, info.block_samples - replay_offset);
+                const uint8_t* payload = replay->payload(replay_chunk);
+                if (info.format == SampleFormat::SC8) {
+                    const complex<int8_t>* in = reinterpret_cast<const complex<int8_t>*>(payload) + replay_offset;
+                    if (host_sc8 && fabs(info.int_scale * inv_step - 1.0f) < 1e-6f) {   // Same scale: copy as is
+                        copy(in, in + take, static_cast<complex<int8_t>*>(buff) + filled);
+                    } else {
+                        staging.resize(take);
+                        unpack_sc8(in, take, staging.data(), info.int_scale);
+                        store_fc32(staging.data(), take, buff, filled, inv_step);
+                    }
+                } else {
+                    const complex<float>* in = reinterpret_cast<const complex<float>*>(payload) + replay_offset;
+                    store_fc32(in, take, buff, filled, inv_step);
+                }
+                filled += take;
+                replay_offset += take;
+                if (replay_offset == info.block_samples) {
+                    replay_offset = 0;
+                    replay_chunk++;
+                }
+            }
+            if (replay_chunk >= replay->num_chunks()) {
+                cout << "[Replay] End of capture (" << replay->num_chunks() << " chunks)" << endl;
+                streaming = false;
+            }
+            return filled;
+        }
+        
+        // Write fc32 samples into the host buffer at `at`, quantizing for sc8
+        void store_fc32(const complex<float>* in, size_t count, void* buff, size_t at, float inv_step) {
+            if (host_sc8) {
+                pack_sc8(in, count, static_cast<complex<int8_t>*>(buff) + at, inv_step);
+            } else {
+                copy(in, in + count, static_cast<complex<float>*>(buff) + at);
+            }
+        }
+        
+        // Uniform noise in [-0.5, 0.5) from a cheap xorshift generator
+        float noise() {
+            rng_state ^= rng_state << 13;
+            rng_state ^= rng_state >> 17;
+            rng_state ^= rng_state << 5;
+            return rng_state * (1.0f / 4294967296.0f) - 0.5f;
+        }
+        
+        // Separate generator for burst timing (keeps the noise sequence intact)
+        uint32_t key_random() {
+            key_state ^= key_state << 13;
+            key_state ^= key_state >> 17;
+            key_state ^= key_state << 5;
+            return key_state;
+        }
+
+        double sample_rate;
+        bool host_sc8 = false;
+        double wire_bytes = 4.0;
+        float sc8_peak = 1.0f;
+        bool streaming = false;
+        chrono::steady_clock::time_point next_deadline;
+        chrono::steady_clock::time_point stream_start;   // First stream start
+        double stall_at = 0.0;                            // Injected stall (0 = none)
+        bool hung = false;                                // Stalled until restarted
+        double link_deficit = 0.0;
+        size_t block_count = 0;
+        complex<float> phasor{1.0f, 0.0f};
+        const complex<float> rotation = polar(1.0f, 0.01f);
+        const complex<float> dc_offset{0.01f, -0.006f};   // LO leakage
+        const float iq_gain = 1.03f;                      // Q/I amplitude mismatch (0.26 dB)
+        const float sin_phase = 0.0523f;                  // 3 degree quadrature error
+        const float cos_phase = 0.9986f;
+        uint32_t rng_state = 2463534242u;
+        uint32_t key_state = 88675123u;
+        bool keyed = false;                               // Transmitter on
+        size_t key_remaining = 0;                         // Samples until the next key change
+        double signal_energy = 0.0;
+        double error_energy = 0.0;
+        shared_ptr<CaptureReader> replay;                 // Capture being replayed (or null)
+        uint64_t replay_chunk = 0;                        // Next chunk to deliver
+        size_t replay_offset = 0;                         // Samples of it already delivered
+        vector<complex<float>> staging;                   // sc8 -> fc32 conversion
+    };
+    namespace usrp {
+        struct multi_usrp {
+            typedef shared_ptr<multi_usrp> sptr;
+            // Comma-separated device arguments:
+            // "replay=<file>" plays back a capture container (throws if unreadable)
+            // "stall_at=<s>" makes the radio stop streaming after <s> seconds
+            static sptr make(const string& args) {
+                sptr device = make_shared<multi_usrp>();
+                size_t start = 0;
+                while (start < args.size()) {
+                    size_t end = args.find(',', start);
+                    if (end == string::npos) end = args.size();
+                    const string arg = args.substr(start, end - start);
+                    start = end + 1;
+                    if (arg.rfind("replay=", 0) == 0) {
+                        string error;
+                        device->replay = make_shared<CaptureReader>();
+                        if (!device->replay->open(arg.substr(7), error)) throw runtime_error(error);
+                        device->replay_path = arg.substr(7);
+                    } else if (arg.rfind("stall_at=", 0) == 0) {
+                        device->stall_at = stod(arg.substr(9));
+                    }
+                }
+                return device;
+            }
+            // While replaying, the "hardware" reports the recorded settings
+            void set_rx_rate(double rate) {
+                current_rate = replay ? replay->info().rx_rate : rate;
+                if (auto active = stream.lock()) active->set_sample_rate(current_rate);
+            }
+            double get_rx_rate() { return current_rate; }
+            void set_rx_freq(const tune_request_t& tune_req) {
+                current_freq = replay ? replay->info().rx_freq : tune_req.target_freq;
+            }
+            double get_rx_freq() { return current_freq; }
+            void set_rx_gain(double gain) { current_gain = replay ? replay->info().rx_gain : gain; }
+            double get_rx_gain() { return current_gain; }
+            string get_pp_string() {
+                return replay ? "Mock USRP (replaying " + replay_path + ")" : "Mock USRP (Simulation)";
+            }
+            vector<string> get_rx_sensor_names() { return {}; }
+            sensor_value_t get_rx_sensor(const string& /*name*/) { return sensor_value_t(); }
+            rx_streamer::sptr get_rx_stream(const stream_args_t& args) {
+                rx_streamer::sptr streamer = make_shared<rx_streamer>(args, current_rate, replay);
+                streamer->set_stall_at(stall_at);
+                stream = streamer;
+                return streamer;
+            }
+        private:
+            shared_ptr<CaptureReader> replay;
+            string replay_path;
+            double stall_at = 0.0;
+            weak_ptr<rx_streamer> stream;   // Latest streamer (follows rate changes)
+            double current_rate = 1e6;
+            double current_freq = 2.437e9;
+            double current_gain = 30.0;
+        };
+    }
 }
 #endif
 
@@ -125,34 +420,567 @@ const size_t SAMPLES_PER_BLOCK = 10000; // Number of samples per processing bloc
 // Atomic flag to signal all threads to stop execution
 atomic<bool> stop_signal(false);
 
+// Set once the RX thread has exited: no block will be pushed any more, so
+// consumers may leave as soon as the queue is empty
+atomic<bool> producer_done(false);
+
 // Counter for overflow events when samples are dropped
 atomic<size_t> overflow_count(0);
 
+// Counter for blocks whose power was estimated from a subset (overload mode)
+atomic<size_t> approximate_count(0);
+
+// CPU spent in the heavy (squelch-gated) stages and how many blocks ran them
+atomic<uint64_t> heavy_cpu_ns(0);
+atomic<size_t> heavy_blocks(0);
+
+// Stall detection: heartbeats of the RX and processing threads (--watchdog)
+Watchdog watchdog;
+
+// End-to-end block latency (fill + queue wait + work) and samples processed,
+// for the profile report
+atomic<uint64_t> latency_sum_ns(0);
+atomic<uint64_t> latency_max_ns(0);
+atomic<uint64_t> latency_blocks(0);
+atomic<uint64_t> samples_processed(0);
+atomic<uint64_t> latency_over_bound(0);   // Blocks over --latency-bound-ms
+
+// Blocks queued by the RX thread, and the rate it streams at now (the
+// control socket can retune it)
+atomic<uint64_t> blocks_produced(0);
+atomic<double> stream_rate(RX_RATE);
+
+// Published for the metrics endpoint (--metrics-port): latency
+// distribution, power of the latest block and per-thread CPU clocks
+LatencyHistogram latency_histogram;
+atomic<double> last_block_power(0.0);
+ThreadCpuClocks thread_clocks;
+
 /**
- * Sample management block
- * 
- * This structure encapsulates a fixed-size block of complex samples along with
- * metadata for tracking and processing.
- * 
- * MEMORY LAYOUT:
- * - block_number: Sequential identifier for ordering and debugging
- * - samples: Vector of complex<float> representing IQ sample pairs
- *   * Real component (I): In-phase signal component
- *   * Imaginary component (Q): Quadrature signal component
- */
-struct SampleBlock {
-    size_t block_number;                     // Sequential block identifier
-    vector<complex<float>> samples;          // IQ sample data (I + jQ format)
-    
-    // Default constructor: Creates empty block with ID 0
-    SampleBlock() : block_number(0) {}
-    
-    // Parameterized constructor: Pre-allocates sample vector
-    // @param num: Block sequence number for tracking
-    // @param size: Number of samples to pre-allocate
-    SampleBlock(size_t num, size_t size) : block_number(num), samples(size) {}
+ * thread_cpu_seconds(): CPU time consumed by the calling thread
+ */
+double thread_cpu_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * pin_current_thread(): Restrict the calling thread to one core (--pin)
+ * @param core: Core index, taken modulo the number of cores
+ * @return: false if the affinity could not be set
+ */
+bool pin_current_thread(unsigned core) {
+#ifdef __linux__
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core % cores, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)core;
+    return false;
+#endif
+}
+
+/**
+ * set_timer_slack(): Let the kernel defer the calling thread's timer
+ * expiries (sleeps, timed waits) by up to this long, so they can be
+ * batched with other wakeups. Threads created afterwards inherit it.
+ * @return: false if the slack could not be set
+ */
+bool set_timer_slack(double seconds) {
+#ifdef __linux__
+    return prctl(PR_SET_TIMERSLACK, static_cast<unsigned long>(seconds * 1e9), 0, 0, 0) == 0;
+#else
+    (void)seconds;
+    return false;
+#endif
+}
+
+/**
+ * cpu_relax(): Spin-loop hint (lets the sibling hyperthread run)
+ */
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// SampleBlock (block number + fc32 or sc8 samples) lives in sample_block.hpp
+
+// ============================================================================
+// RUNTIME OPTIONS
+// ============================================================================
+
+/**
+ * RuntimeProfile: named sets of coordinated runtime choices (--profile)
+ *
+ * - LOW_LATENCY: small blocks, consumers busy-poll the queue before
+ *   sleeping, one block per pop, every line written at once, threads
+ *   pinned to cores (no migrations, warm caches)
+ * - HIGH_THROUGHPUT: large blocks, several blocks per pop (one lock and
+ *   one wakeup for the batch), result lines written in bulk by an output
+ *   thread
+ * - LOW_CPU: large blocks, blocking waits only, consumers woken once per
+ *   batch of blocks (within a latency bound) and taking the whole batch,
+ *   generous timer slack, bulk output with a long flush interval, power
+ *   estimated from every STATS_STRIDE-th sample
+ * NONE keeps the individual defaults. A profile only sets defaults:
+ * explicit flags override its choices, whatever their position.
+ */
+enum class RuntimeProfile { NONE, LOW_LATENCY, HIGH_THROUGHPUT, LOW_CPU };
+
+/**
+ * OutputVerbosity: which per-block lines are printed (--verbosity, or
+ * "verbosity" on the control socket)
+ * - QUIET: none; statistics only
+ * - EVENTS: flagged blocks, blocks that open the squelch, and bursts
+ * - ALL: every block
+ */
+enum class OutputVerbosity : int { QUIET, EVENTS, ALL };
+
+const char* verbosity_name(OutputVerbosity level) {
+    switch (level) {
+        case OutputVerbosity::QUIET:  return "quiet";
+        case OutputVerbosity::EVENTS: return "events";
+        case OutputVerbosity::ALL:    return "all";
+    }
+    return "?";
+}
+
+bool parse_verbosity(const std::string& name, OutputVerbosity& level) {
+    for (OutputVerbosity v : {OutputVerbosity::QUIET, OutputVerbosity::EVENTS, OutputVerbosity::ALL}) {
+        if (name == verbosity_name(v)) {
+            level = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* profile_name(RuntimeProfile profile) {
+    switch (profile) {
+        case RuntimeProfile::NONE:            return "default";
+        case RuntimeProfile::LOW_LATENCY:     return "low-latency";
+        case RuntimeProfile::HIGH_THROUGHPUT: return "high-throughput";
+        case RuntimeProfile::LOW_CPU:         return "low-cpu";
+    }
+    return "?";
+}
+
+bool parse_profile(const std::string& name, RuntimeProfile& profile) {
+    for (RuntimeProfile p : {RuntimeProfile::NONE, RuntimeProfile::LOW_LATENCY,
+                             RuntimeProfile::HIGH_THROUGHPUT, RuntimeProfile::LOW_CPU}) {
+        if (name == profile_name(p)) {
+            profile = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * RuntimeOptions: settings selected with --name=value command line flags
+ *
+ * - wire_format: sc16 (default) or sc8. sc8 halves the Ethernet load, so the
+ *   N210 can stream up to ~50 MS/s instead of ~25 MS/s, at the cost of
+ *   8-bit quantization (~48 dB SQNR at full scale vs ~98 dB for sc16).
+ * - sc8_peak: fc32 amplitude mapped to int8 full scale. Lower it for weak
+ *   signals to spend the 8 bits on the actual signal range.
+ * - queue_budget_mb: byte budget of the sample queue. Queued blocks are
+ *   packed to sc16/sc8 as the budget fills, and dropped only when full.
+ * - shed_age_ms: queue age at which processing threads switch to
+ *   subsampled power estimates (see power_estimate.hpp). Results are then
+ *   marked with '~' and a 95% error bound.
+ * - flag_db: the RX thread's front-end energy check flags blocks whose
+ *   quick power estimate exceeds the running average by this many dB;
+ *   flagged blocks use the high-priority queue lane.
+ * - lane_max_wait_ms: starvation guard for the routine lane.
+ * - ordered: run the stateful channel selector (mixer + lowpass FIR) on
+ *   every block. Each block carries the previous block's tail (overlap-save)
+ *   so workers still run in parallel; results are printed in block order
+ *   and match a sequential run exactly. Requires a lossless queue.
+ * - taps / cutoff / mix_hz: channel selector filter length (1..FFT_MAX_TAPS),
+ *   normalized cutoff (fraction of the sampling rate) and frequency shift
+ *   in Hz.
+ * - conv: lowpass implementation. auto uses FFT overlap-save from
+ *   FFT_CROSSOVER_TAPS taps up (see fast_convolution.hpp), direct below.
+ * - out_rate: resample the channel selector output from the actual RX rate
+ *   to this rate (polyphase L/M, see resampler.hpp). The resampler carries
+ *   state from block to block, so it runs on the in-order output path;
+ *   implies ordered mode.
+ * - iq_correct: remove DC offset and IQ gain/phase imbalance in the RX
+ *   thread, before blocks are queued (see iq_correction.hpp).
+ * - squelch_db: gate the heavy per-block stages (channel selection and
+ *   later analysis) on blocks whose power is less than this many dB above
+ *   the noise floor (see squelch.hpp). With --out-rate the channel is
+ *   still selected and resampled for every block, so the output stream
+ *   stays continuous.
+ * - noise_window_s: stream time the noise floor is the (bias-corrected)
+ *   minimum of sub-block powers over (see noise_floor.hpp); longer than
+ *   the longest expected transmission. Every result carries the floor
+ *   and the block's SNR, which the squelch and burst extraction use.
+ * - burst_db: extract bursts whose smoothed power exceeds the noise floor
+ *   by this many dB (ends 3 dB lower) as variable-length records (see
+ *   burst_segmenter.hpp). Runs on the in-order output path; implies
+ *   ordered mode.
+ * - record: write every queued block (after IQ correction, in its host
+ *   format) to a capture container (see capture_file.hpp) holding the
+ *   actual frequency / rate / gain, per-block checksums and power, and a
+ *   trailing index, for capture_tool and --replay.
+ * - append: with record, continue an existing container after its last
+ *   good chunk instead of overwriting it (settings must match).
+ * - replay: (simulation) stream the samples of a capture container
+ *   through the mock radio instead of synthetic ones, at the recorded rate.
+ * - watchdog_s: report threads that make no progress for this long (hung
+ *   worker, RX thread starved of samples or exited) and a queue whose
+ *   oldest block is this old, with a state report of every thread (see
+ *   watchdog.hpp). 0 disables it.
+ * - watchdog_restart: on an RX stall, restart the stream instead of
+ *   giving up on the first recv() timeout.
+ * - stall_at: (simulation) the mock radio stops streaming this many
+ *   seconds in, until the stream is restarted (exercises the watchdog).
+ * - target_latency_ms: resize blocks at run time to the largest size whose
+ *   first sample is processed within this latency (fill + queue wait +
+ *   work, measured by the workers; see block_sizer.hpp).
+ * - max_overhead: resize blocks at run time to the smallest size whose
+ *   fixed per-block cost is at most this fraction of its work.
+ *   Dynamic sizing starts from --block and changes the size
+ *   only between blocks; it cannot be combined with --record (chunks of
+ *   a capture container all have the same size).
+ * - profile: named group of the settings below (see RuntimeProfile).
+ * - block_samples: samples per block (fill time = block / rate).
+ * - spin_us: consumers busy-poll an empty queue this long before blocking
+ *   on the condition variable (trades a core for wakeup latency).
+ * - pop_batch: blocks a consumer takes from the queue per lock / wakeup.
+ * - output_flush_ms: write result lines in bulk from an output thread at
+ *   this interval instead of one flushed line per block (see
+ *   output_sink.hpp).
+ * - pin: pin the RX thread to core 0 and worker i to core i.
+ * - stats_stride: estimate block power from every N-th sample (reported
+ *   like overload estimates, with '~' and a 95% error bound).
+ * - wake_blocks: the RX thread wakes a consumer once per N queued blocks
+ *   instead of once per block; a woken consumer passes the wakeup on while
+ *   blocks remain. Pair with pop_batch >= N so one wakeup drains a batch.
+ * - latency_bound_ms: end-to-end latency (fill + queue + work) a block
+ *   may reach. Coalesced wakeups are issued early enough that a block's
+ *   fill time plus its coalescing delay stay within the bound minus a
+ *   LATENCY_WORK_RESERVE share left for the work; blocks over the bound
+ *   are counted in the report.
+ * - timer_slack_us: timer slack of every thread (Linux), so the kernel
+ *   can batch their timed wakeups (RX pacing, output flushes, watchdog).
+ * - verbosity: per-block output level at startup (see OutputVerbosity).
+ * - control: listen on this Unix-domain socket for runtime commands
+ *   (see handle_control_command() and control_socket.hpp).
+ * - metrics_port: serve Prometheus metrics on 127.0.0.1:<port>/metrics
+ *   (see collect_metrics() and metrics_server.hpp).
+ * - history: keep min / mean / max per second, minute and hour of block
+ *   power, latency and queue depth in memory-mapped files in this
+ *   directory (see rollup_store.hpp); continued by later runs. Query them
+ *   live with the "history" control command or afterwards with
+ *   `capture_tool trend`.
+ * - quantiles_s: report p1 / p50 / p90 / p99 of block power over every
+ *   interval of this many seconds, and over the whole run, from
+ *   per-worker KLL sketches merged at report time (see
+ *   quantile_sketch.hpp and report_power_quantiles()).
+ * - tones: measure the power at these frequencies (Hz from the centre
+ *   frequency) in every block with a Goertzel bank (see
+ *   goertzel_bank.hpp), and track each tone's smoothed power and
+ *   frequency offset from block to block. Part of the heavy stages.
+ * - dbfs: print block powers on the result, [Burst] and percentile lines
+ *   in dB relative to full scale instead of linear or plain dB, converted
+ *   with fast_dbfs() (within 0.002 dB of 10 log10; see fast_magnitude.hpp).
+ */
+struct RuntimeOptions {
+    WireFormat wire_format = WireFormat::SC16;   // --wire=sc16|sc8
+    double sc8_peak = 1.0;                       // --sc8-peak=<0..1>
+    double queue_budget_mb = 0.0;                // --queue-budget-mb=<MB> (0 = unbounded)
+    double shed_age_ms = 0.0;                    // --shed-age-ms=<ms> (0 = never subsample)
+    double flag_db = 0.0;                        // --flag-db=<dB> (0 = no priority flagging)
+    double lane_max_wait_ms = 100.0;             // --lane-max-wait-ms=<ms>
+    bool ordered = false;                        // --ordered
+    size_t taps = 129;                           // --taps=<N>
+    double cutoff = 0.2;                         // --cutoff=<0..0.5>
+    double mix_hz = 0.0;                         // --mix-hz=<Hz>
+    ConvolutionMethod conv = ConvolutionMethod::AUTO; // --conv=auto|direct|fft
+    double out_rate = 0.0;                       // --out-rate=<Hz> (0 = no resampling)
+    bool iq_correct = false;                     // --iq-correct
+    double squelch_db = 0.0;                     // --squelch-db=<dB> (0 = always run)
+    double noise_window_s = 2.0;                 // --noise-window-s=<s>
+    double burst_db = 0.0;                       // --burst-db=<dB> (0 = no burst extraction)
+    std::string record;                          // --record=<file> (empty = no capture)
+    bool append = false;                         // --append
+    std::string replay;                          // --replay=<file> (simulation only)
+    double watchdog_s = 2.0;                     // --watchdog=<s> (0 = off)
+    bool watchdog_restart = false;               // --watchdog-restart
+    double stall_at = 0.0;                       // --stall-at=<s> (simulation only)
+    double target_latency_ms = 0.0;              // --target-latency-ms=<ms> (0 = fixed blocks)
+    double max_overhead = 0.0;                   // --max-overhead=<0..1> (0 = fixed blocks)
+    RuntimeProfile profile = RuntimeProfile::NONE; // --profile=low-latency|high-throughput|low-cpu
+    size_t block_samples = SAMPLES_PER_BLOCK;    // --block=<samples>
+    double spin_us = 0.0;                        // --spin-us=<us> (0 = block at once)
+    size_t pop_batch = 1;                        // --pop-batch=<blocks>
+    double output_flush_ms = 0.0;                // --output-flush-ms=<ms> (0 = line by line)
+    bool pin = false;                            // --pin
+    size_t stats_stride = 1;                     // --stats-stride=<N> (1 = exact power)
+    size_t wake_blocks = 1;                      // --wake-blocks=<N> (1 = wake per block)
+    double latency_bound_ms = 0.0;               // --latency-bound-ms=<ms> (0 = no bound)
+    double timer_slack_us = 0.0;                 // --timer-slack-us=<us> (0 = kernel default)
+    OutputVerbosity verbosity = OutputVerbosity::ALL; // --verbosity=quiet|events|all
+    std::string control;                         // --control=<socket path> (empty = none)
+    int metrics_port = 0;                        // --metrics-port=<port> (0 = no endpoint)
+    std::string history;                         // --history=<dir> (empty = no trend files)
+    double quantiles_s = 0.0;                    // --quantiles-s=<s> (0 = no percentile reports)
+    std::vector<double> tones;                   // --tones=<Hz>[,<Hz>...] (empty = no tone bins)
+    bool dbfs = false;                           // --dbfs
 };
 
+RuntimeOptions options;
+
+// Power estimates of the low-CPU profile read every STATS_STRIDE-th sample
+const size_t STATS_STRIDE = 8;
+
+// Share of --latency-bound-ms kept for the work (and scheduling) when
+// wakeups are coalesced
+const double LATENCY_WORK_RESERVE = 0.2;
+
+/**
+ * apply_profile(): Set the defaults of a profile (before the other flags)
+ */
+void apply_profile(RuntimeProfile profile) {
+    switch (profile) {
+        case RuntimeProfile::NONE:
+            break;
+        case RuntimeProfile::LOW_LATENCY:
+            options.block_samples = 2048;
+            options.spin_us = 500.0;
+            options.pop_batch = 1;
+            options.output_flush_ms = 0.0;
+            options.pin = true;
+            break;
+        case RuntimeProfile::HIGH_THROUGHPUT:
+            options.block_samples = 65536;
+            options.pop_batch = 8;
+            options.output_flush_ms = 50.0;
+            break;
+        case RuntimeProfile::LOW_CPU:
+            options.block_samples = 65536;
+            options.spin_us = 0.0;
+            options.wake_blocks = 8;
+            options.pop_batch = 8;
+            options.latency_bound_ms = 250.0;
+            options.timer_slack_us = 5000.0;
+            options.output_flush_ms = 250.0;
+            options.stats_stride = STATS_STRIDE;
+            break;
+    }
+}
+
+/**
+ * apply_option(): Apply one --name=value flag to the runtime options
+ * @param arg: Command line argument starting with "--"
+ * @return: false if the flag or its value is not recognized (numeric values
+ *          are converted with std::stod / std::stoul, which may throw)
+ */
+bool apply_option(const std::string& arg) {
+    size_t eq = arg.find('=');
+    std::string name = arg.substr(2, eq == std::string::npos ? std::string::npos : eq - 2);
+    std::string value = (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+
+    if (name == "wire") {
+        return parse_wire_format(value, options.wire_format);
+    }
+    if (name == "sc8-peak") {
+        options.sc8_peak = std::stod(value);
+        return options.sc8_peak > 0.0 && options.sc8_peak <= 1.0;
+    }
+    if (name == "shed-age-ms") {
+        options.shed_age_ms = std::stod(value);
+        return options.shed_age_ms >= 0.0;
+    }
+    if (name == "flag-db") {
+        options.flag_db = std::stod(value);
+        return options.flag_db >= 0.0;
+    }
+    if (name == "lane-max-wait-ms") {
+        options.lane_max_wait_ms = std::stod(value);
+        return options.lane_max_wait_ms > 0.0;
+    }
+    if (name == "queue-budget-mb") {
+        options.queue_budget_mb = std::stod(value);
+        return options.queue_budget_mb >= 0.0;
+    }
+    if (name == "ordered") {
+        options.ordered = true;
+        return value.empty();
+    }
+    if (name == "taps") {
+        options.taps = std::stoul(value);
+        return options.taps > 0 && options.taps <= FFT_MAX_TAPS;   // Longest filter overlap-save can run
+    }
+    if (name == "cutoff") {
+        options.cutoff = std::stod(value);
+        return options.cutoff > 0.0 && options.cutoff < 0.5;
+    }
+    if (name == "conv") {
+        return parse_convolution_method(value, options.conv);
+    }
+    if (name == "burst-db") {
+        options.burst_db = std::stod(value);
+        options.ordered = true;
+        return options.burst_db > 0.0;
+    }
+    if (name == "squelch-db") {
+        options.squelch_db = std::stod(value);
+        return options.squelch_db >= 0.0;
+    }
+    if (name == "iq-correct") {
+        options.iq_correct = true;
+        return value.empty();
+    }
+    if (name == "out-rate") {
+        options.out_rate = std::stod(value);
+        options.ordered = true;
+        return options.out_rate > 0.0;
+    }
+    if (name == "record") {
+        options.record = value;
+        return !value.empty();
+    }
+    if (name == "append") {
+        options.append = true;
+        return value.empty();
+    }
+    if (name == "replay") {
+        options.replay = value;
+        return !value.empty();
+    }
+    if (name == "watchdog") {
+        options.watchdog_s = std::stod(value);
+        return options.watchdog_s >= 0.0;
+    }
+    if (name == "watchdog-restart") {
+        options.watchdog_restart = true;
+        return value.empty();
+    }
+    if (name == "stall-at") {
+        options.stall_at = std::stod(value);
+        return options.stall_at > 0.0;
+    }
+    if (name == "target-latency-ms") {
+        options.target_latency_ms = std::stod(value);
+        return options.target_latency_ms > 0.0;
+    }
+    if (name == "max-overhead") {
+        options.max_overhead = std::stod(value);
+        return options.max_overhead > 0.0 && options.max_overhead < 1.0;
+    }
+    if (name == "profile") {
+        return parse_profile(value, options.profile);
+    }
+    if (name == "block") {
+        options.block_samples = std::stoul(value);
+        return options.block_samples >= BlockSizeController::MIN_BLOCK &&
+               options.block_samples <= BlockSizeController::MAX_BLOCK;
+    }
+    if (name == "spin-us") {
+        options.spin_us = std::stod(value);
+        return options.spin_us >= 0.0;
+    }
+    if (name == "pop-batch") {
+        options.pop_batch = std::stoul(value);
+        return options.pop_batch > 0;
+    }
+    if (name == "output-flush-ms") {
+        options.output_flush_ms = std::stod(value);
+        return options.output_flush_ms >= 0.0;
+    }
+    if (name == "pin") {
+        options.pin = true;
+        return value.empty();
+    }
+    if (name == "stats-stride") {
+        options.stats_stride = std::stoul(value);
+        return options.stats_stride > 0;
+    }
+    if (name == "wake-blocks") {
+        options.wake_blocks = std::stoul(value);
+        return options.wake_blocks > 0;
+    }
+    if (name == "latency-bound-ms") {
+        options.latency_bound_ms = std::stod(value);
+        return options.latency_bound_ms >= 0.0;
+    }
+    if (name == "timer-slack-us") {
+        options.timer_slack_us = std::stod(value);
+        return options.timer_slack_us >= 0.0;
+    }
+    if (name == "verbosity") {
+        return parse_verbosity(value, options.verbosity);
+    }
+    if (name == "control") {
+        options.control = value;
+        return !value.empty();
+    }
+    if (name == "metrics-port") {
+        options.metrics_port = std::stoi(value);
+        return options.metrics_port > 0 && options.metrics_port < 65536;
+    }
+    if (name == "noise-window-s") {
+        options.noise_window_s = std::stod(value);
+        return options.noise_window_s > 0.0;
+    }
+    if (name == "history") {
+        options.history = value;
+        return !value.empty();
+    }
+    if (name == "quantiles-s") {
+        options.quantiles_s = std::stod(value);
+        return options.quantiles_s >= 0.0;
+    }
+    if (name == "dbfs") {
+        options.dbfs = true;
+        return value.empty();
+    }
+    if (name == "tones") {
+        options.tones.clear();
+        size_t begin = 0;
+        while (begin <= value.size()) {
+            size_t end = value.find(',', begin);
+            if (end == std::string::npos) end = value.size();
+            options.tones.push_back(std::stod(value.substr(begin, end - begin)));
+            begin = end + 1;
+        }
+        return !options.tones.empty();
+    }
+    if (name == "mix-hz") {
+        options.mix_hz = std::stod(value);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * parse_option(): apply_option() with malformed numbers (--flag-db=abc,
+ * out-of-range values) reported as an unrecognized value
+ * @param arg: Command line argument starting with "--"
+ * @return: false if the flag or its value is not recognized
+ */
+bool parse_option(const std::string& arg) {
+    try {
+        return apply_option(arg);
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+const char* lane_name(size_t lane) {
+    return lane == LANE_FLAGGED ? "flagged" : "routine";
+}
+
 /**
  * SampleQueue: Thread-safe FIFO queue for producer-consumer pattern
  * 
@@ -160,106 +988,894 @@ struct SampleBlock {
  * The RX thread pushes sample blocks, while processing threads
  * pop blocks for analysis.
  * 
+ * PRIORITY LANES:
+ * - One FIFO per PriorityLane; pop() serves the highest non-empty lane
+ * - Starvation protection: a lower lane is served anyway once its oldest
+ *   block waited max_lane_wait, or after STARVATION_LIMIT pops skipped it
+ * - Per-lane depth, push/pop counts and queueing latency are tracked
+ * 
+ * BYTE BUDGET (optional, set_byte_budget()):
+ * - The queue holds at most byte_budget bytes of sample payload; a block
+ *   that does not fit is dropped and counted. A flagged block first evicts
+ *   the newest routine blocks to make room.
+ * - Above SC16_WATERMARK of the budget, new fc32 blocks are packed to sc16
+ *   on the producer side (2x smaller); above SC8_WATERMARK to sc8 (4x).
+ *   The compaction level is producer state kept outside the lock: push()
+ *   must only be called by one thread at a time (the RX thread).
+ * - Consumers expand compacted blocks back to fc32 outside the lock
+ * - Each level is left at half its entry watermark (hysteresis), so full
+ *   precision returns automatically once the backlog drains
+ * 
  * PERFORMANCE:
  * - unique_lock used for condition variable compatibility
  * - lock_guard used for simple critical sections
  * - notify_one() vs notify_all() optimizes wake-up efficiency
+ * - Blocks are moved, not copied, in and out of the queue
+ * - Packing/unpacking runs outside the lock
+ * - pop_batch() hands out several blocks per lock and wakeup; set_spin()
+ *   lets consumers busy-poll briefly before sleeping
+ * - set_wakeup_coalescing() makes push() notify once per batch of blocks,
+ *   early enough for a latency budget; consumers pass the wakeup on while
+ *   blocks remain, and one sleeping consumer (the timekeeper) wakes on its
+ *   own every coalescing interval, so blocks pushed without a wakeup are
+ *   not stranded when the producer pauses
  */
 class SampleQueue {
 private:
-    queue<SampleBlock> queue;    // Underlying STL queue container
+    // Per-lane FIFO and statistics
+    struct Lane {
+        std::deque<SampleBlock> blocks;      // Blocks waiting in this lane
+        size_t pushed = 0;                   // Blocks accepted
+        size_t popped = 0;                   // Blocks handed to consumers
+        size_t evicted = 0;                  // Blocks dropped to make room
+        size_t skipped = 0;                  // Consecutive pops that bypassed it
+        size_t peak_depth = 0;               // High-water mark of blocks
+        double total_wait = 0.0;             // Sum of queueing latency (s)
+        double max_wait = 0.0;               // Worst queueing latency (s)
+    };
+    
+    Lane lanes[NUM_LANES];       // Underlying FIFOs, highest priority first
+    size_t total_blocks = 0;     // Blocks queued across all lanes
     mutex mtx;                   // Mutex for thread-safe access
     condition_variable cv;       // Condition variable for blocking operations
     
+    // Starvation protection
+    double max_lane_wait = 0.1;  // Serve a lower lane once its head waited this long (s)
+    atomic<double> spin_seconds{0.0};   // Busy-poll before blocking in pop
+    
+    // Wakeup coalescing (under mtx)
+    size_t wake_blocks = 1;      // Notify a consumer once per this many pushes
+    double wake_budget = 0.0;    // Fill + coalescing delay allowed per block (s, 0 = unlimited)
+    double sample_rate = 0.0;    // Converts block sizes to fill times
+    size_t unnotified = 0;       // Blocks pushed since the last notify
+    chrono::steady_clock::time_point first_unnotified;   // Push time of the first of them
+    size_t notifications = 0;    // Producer wakeups issued
+    double last_fill = 0.0;      // Fill time of the latest block (s)
+    bool timekeeper = false;     // A consumer sleeps with the coalescing timeout
+    size_t sleepers = 0;         // Consumers sleeping without a timeout
+    
+    // Byte budget state (budget 0 = unbounded, no compaction)
+    atomic<size_t> byte_budget{0};           // Maximum queued payload bytes (changeable while streaming)
+    atomic<size_t> queued_bytes{0};          // Current queued payload bytes (also polled by spinners)
+    SampleFormat compaction = SampleFormat::FC32; // Format for new fc32 blocks
+    
+    // Statistics
+    size_t peak_bytes = 0;                   // High-water mark of queued bytes
+    size_t peak_blocks = 0;                  // High-water mark of queued blocks
+    atomic<size_t> dropped{0};               // Blocks rejected by the budget
+    atomic<size_t> packed_sc16{0};           // Blocks compacted to sc16
+    atomic<size_t> packed_sc8{0};            // Blocks compacted to sc8
+    atomic<size_t> depth_now{0};             // total_blocks, readable without the lock
+    
 public:
+    // Occupancy fractions of the byte budget that trigger compaction
+    static constexpr double SC16_WATERMARK = 0.25;
+    static constexpr double SC8_WATERMARK = 0.50;
+    
+    // Consecutive pops a non-empty lower lane may be bypassed
+    static const size_t STARVATION_LIMIT = 8;
+    
+    // Shortest timekeeper sleep with coalesced wakeups (s)
+    static constexpr double MIN_WAKE_INTERVAL = 1e-4;
+    
+    /**
+     * set_byte_budget(): Limit queued sample payload (0 = unbounded)
+     * @param bytes: Maximum bytes of sample payload held by the queue
+     */
+    void set_byte_budget(size_t bytes) {
+        lock_guard<mutex> lock(mtx);
+        byte_budget = bytes;
+    }
+    
+    /**
+     * set_max_lane_wait(): Queueing latency after which a lower lane is
+     * served ahead of higher ones
+     * @param seconds: Maximum wait before the starvation guard kicks in
+     */
+    void set_max_lane_wait(double seconds) {
+        lock_guard<mutex> lock(mtx);
+        max_lane_wait = seconds;
+    }
+    
     /**
-     * push(): Add a sample block to the queue
-     * @param block: Sample block to add to queue
+     * push(): Add a sample block to the queue (single producer: see
+     * update_compaction())
+     * @param block: Sample block to add to queue (moved in); its priority
+     *               field selects the lane
+     * @return: false if the block was dropped by the byte budget
      */
-    void push(const SampleBlock& block) {
+    bool push(SampleBlock block) {
+        // Producer-side compaction, decided from the current occupancy
+        const size_t budget = byte_budget.load(memory_order_relaxed);   // Changeable at run time
+        if (budget > 0) {
+            SampleFormat target = update_compaction(queued_bytes.load(memory_order_relaxed), budget);
+            if (target != SampleFormat::FC32 && block.format == SampleFormat::FC32) {
+                compact_block(block, target);
+                (target == SampleFormat::SC16 ? packed_sc16 : packed_sc8)++;
+            }
+        }
+        
+        const size_t lane = min<size_t>(block.priority, NUM_LANES - 1);
+        const size_t bytes = block.payload_bytes();
         unique_lock<mutex> lock(mtx);  // Acquire exclusive access
-        queue.push(block);             // Add block to queue
-        cv.notify_one();               // Wake up one waiting consumer
+        if (byte_budget > 0) {
+            // Make room for a higher-priority block by evicting the newest
+            // blocks of lower lanes
+            for (size_t victim = NUM_LANES - 1; victim > lane; victim--) {
+                while (queued_bytes.load(memory_order_relaxed) + bytes > byte_budget &&
+                       !lanes[victim].blocks.empty()) {
+                    queued_bytes.fetch_sub(lanes[victim].blocks.back().payload_bytes(),
+                                           memory_order_relaxed);
+                    lanes[victim].blocks.pop_back();
+                    lanes[victim].evicted++;
+                    total_blocks--;
+                    dropped++;
+                }
+            }
+            if (queued_bytes.load(memory_order_relaxed) + bytes > byte_budget) {
+                dropped++;                 // Budget exhausted even after compaction
+                depth_now.store(total_blocks, memory_order_relaxed);
+                return false;
+            }
+        }
+        Lane& target_lane = lanes[lane];
+        target_lane.blocks.push_back(std::move(block));  // Add block to its lane
+        target_lane.pushed++;
+        target_lane.peak_depth = max(target_lane.peak_depth, target_lane.blocks.size());
+        total_blocks++;
+        depth_now.store(total_blocks, memory_order_relaxed);
+        size_t total = queued_bytes.fetch_add(bytes, memory_order_relaxed) + bytes;
+        peak_bytes = max(peak_bytes, total);
+        peak_blocks = max(peak_blocks, total_blocks);
+        if (should_notify(target_lane.blocks.back().size())) {
+            notifications++;
+            cv.notify_one();           // Wake up one waiting consumer
+        }
+        return true;
     }
     
     /**
-     * pop(): Remove and return a sample block
-     * @param block: Reference to store the retrieved block
-     * @return: true if block retrieved, false if shutting down
+     * pop(): Remove and return the next sample block by priority
+     * @param block: Reference to store the retrieved block (fc32 unless
+     *               streamed natively as sc8)
+     * @return: true if block retrieved, false once the producer is done
+     *          and the queue is empty
      */
     bool pop(SampleBlock& block) {
-        unique_lock<mutex> lock(mtx);  // Acquire exclusive access
-        
-        // Block until queue has data OR stop signal is set
-        cv.wait(lock, [this] { 
-            return !queue.empty() || stop_signal.load(); 
-        });
-        
-        // Check for shutdown condition (stop signal + empty queue)
-        if (stop_signal.load() && queue.empty()) {
-            return false;  // Signal consumer to exit
+        spin_for_work();
+        {
+            unique_lock<mutex> lock(mtx);  // Acquire exclusive access
+            
+            // Block until queue has data OR the producer has exited
+            wait_for_blocks(lock);
+            
+            // Shutdown condition: nothing queued and nothing more coming
+            if (total_blocks == 0) {
+                return false;  // Signal consumer to exit
+            }
+            take_next(chrono::steady_clock::now(), block);
+            pass_wakeup_on();
         }
         
-        // Retrieve block if available
-        if (!queue.empty()) {
-            block = queue.front();  // Copy front block
-            queue.pop();            // Remove from queue
-            return true;            // Success
+        // Unpack outside the lock so other consumers are not held up
+        expand_block(block);
+        return true;
+    }
+    
+    /**
+     * pop_batch(): Remove up to max_blocks blocks under one lock (one wakeup)
+     * @param blocks: Receives the blocks, in the order pop() would return them
+     * @param max_blocks: Batch limit; fewer are taken if fewer are queued
+     * @return: true if at least one block retrieved, false once the
+     *          producer is done and the queue is empty
+     */
+    bool pop_batch(std::vector<SampleBlock>& blocks, size_t max_blocks) {
+        spin_for_work();
+        const size_t first = blocks.size();
+        {
+            unique_lock<mutex> lock(mtx);
+            wait_for_blocks(lock);
+            if (total_blocks == 0) {
+                return false;  // Producer done and the queue drained
+            }
+            auto now = chrono::steady_clock::now();
+            while (total_blocks > 0 && blocks.size() - first < max_blocks) {
+                blocks.emplace_back();
+                take_next(now, blocks.back());
+            }
+            pass_wakeup_on();
         }
-        return false;  // Fallback case
+        for (size_t i = first; i < blocks.size(); i++) {
+            expand_block(blocks[i]);
+        }
+        return true;
+    }
+    
+    /**
+     * set_wakeup_coalescing(): Notify consumers once per wake_every pushes
+     * instead of every push, but early enough that no block's fill time plus
+     * the delay of its notification exceeds budget_s. The next push is one
+     * fill time away, so a push notifies once the oldest unnotified block
+     * would otherwise run over: age + 2 * fill > budget.
+     * @param wake_every: Pushes per notification (1 = every push)
+     * @param budget_s: Fill + coalescing delay allowed per block (0 = no limit)
+     * @param rate: Stream sampling rate (fill time = block size / rate)
+     */
+    void set_wakeup_coalescing(size_t wake_every, double budget_s, double rate) {
+        lock_guard<mutex> lock(mtx);
+        wake_blocks = max<size_t>(wake_every, 1);
+        wake_budget = budget_s;
+        sample_rate = rate;
+    }
+    
+    // Change the coalescing count or the stream rate while streaming
+    void set_wake_blocks(size_t wake_every) {
+        lock_guard<mutex> lock(mtx);
+        wake_blocks = max<size_t>(wake_every, 1);
+    }
+    void set_sample_rate(double rate) {
+        lock_guard<mutex> lock(mtx);
+        sample_rate = rate;
+    }
+    
+    /**
+     * set_spin(): Busy-poll an empty queue before blocking (0 = never)
+     * @param seconds: Longest spin per pop
+     */
+    void set_spin(double seconds) {
+        spin_seconds.store(seconds, memory_order_relaxed);
     }
     
     /**
      * size(): Get current queue size
-     * @return: Number of blocks currently in queue
+     * @return: Number of blocks currently in queue (all lanes)
      */
     size_t size() {
         lock_guard<mutex> lock(mtx);  // Lock for read operation
-        return queue.size();
+        return total_blocks;
     }
     
     /**
      * notify_all(): Wake up all waiting threads
-     * Used during shutdown to wake up blocked consumers
+     * Used during shutdown to wake up blocked consumers; taking the lock
+     * first means a consumer between its producer_done check and its
+     * wait cannot miss the wakeup
      */
     void notify_all() {
+        { lock_guard<mutex> lock(mtx); }
         cv.notify_all();  // Wake up ALL waiting threads
     }
+    
+    /**
+     * print_stats(): Report lane metrics, byte budget usage and compaction counts
+     */
+    void print_stats() {
+        lock_guard<mutex> lock(mtx);
+        std::cout << "Queue Peak: " << peak_blocks << " blocks, "
+                  << peak_bytes / 1024 << " KB" << std::endl;
+        for (size_t i = 0; i < NUM_LANES; i++) {
+            const Lane& lane = lanes[i];
+            if (lane.pushed == 0) continue;
+            std::cout << "Lane " << std::left << std::setw(8) << lane_name(i) << std::right
+                      << "| Pushed: " << lane.pushed
+                      << " | Popped: " << lane.popped
+                      << " | Evicted: " << lane.evicted
+                      << " | Depth: " << lane.blocks.size() << " (peak " << lane.peak_depth << ")"
+                      << " | Latency avg/max: " << std::fixed << std::setprecision(2)
+                      << (lane.popped ? 1e3 * lane.total_wait / lane.popped : 0.0) << "/"
+                      << 1e3 * lane.max_wait << " ms" << std::endl;
+        }
+        if (wake_blocks > 1) {
+            size_t pushed = 0;
+            for (const Lane& lane : lanes) pushed += lane.pushed;
+            std::cout << "Wakeups: " << notifications << " producer notifications for " << pushed
+                      << " blocks (" << std::setprecision(1)
+                      << (notifications ? static_cast<double>(pushed) / notifications : 0.0)
+                      << " blocks per wakeup, at most " << wake_blocks << ")" << std::endl;
+        }
+        if (byte_budget > 0) {
+            std::cout << "Queue Budget: " << byte_budget / 1024 << " KB"
+                      << " | Packed sc16: " << packed_sc16.load()
+                      << " | Packed sc8: " << packed_sc8.load()
+                      << " | Dropped: " << dropped.load() << std::endl;
+        }
+    }
+    
+    // Blocks rejected because the byte budget was exhausted
+    size_t dropped_blocks() const { return dropped.load(); }
+    
+    // Lock-free snapshots for the metrics endpoint
+    size_t depth() const { return depth_now.load(memory_order_relaxed); }
+    size_t bytes() const { return queued_bytes.load(memory_order_relaxed); }
+    
+    /**
+     * backlog(): Queued blocks and the age of the oldest one (watchdog probe)
+     */
+    void backlog(size_t& depth, double& oldest_age) {
+        lock_guard<mutex> lock(mtx);
+        auto now = chrono::steady_clock::now();
+        depth = total_blocks;
+        oldest_age = 0.0;
+        for (const Lane& lane : lanes) {
+            if (lane.blocks.empty()) continue;
+            oldest_age = max(oldest_age, chrono::duration<double>(now - lane.blocks.front().timestamp).count());
+        }
+    }
+    
+private:
+    /**
+     * take_next(): Move the next block out by priority and account for its
+     * wait (caller holds mtx, queue non-empty)
+     */
+    void take_next(chrono::steady_clock::time_point now, SampleBlock& block) {
+        Lane& lane = lanes[next_lane(now)];
+        block = std::move(lane.blocks.front());  // Move front block out
+        lane.blocks.pop_front();                 // Remove from lane
+        total_blocks--;
+        depth_now.store(total_blocks, memory_order_relaxed);
+        queued_bytes.fetch_sub(block.payload_bytes(), memory_order_relaxed);
+        
+        double wait = chrono::duration<double>(now - block.timestamp).count();
+        lane.popped++;
+        lane.total_wait += wait;
+        lane.max_wait = max(lane.max_wait, wait);
+    }
+    
+    /**
+     * should_notify(): Coalescing decision for a push (caller holds mtx)
+     * @param samples: Size of the block just queued
+     */
+    bool should_notify(size_t samples) {
+        const auto now = chrono::steady_clock::now();
+        const double fill = samples / sample_rate;
+        last_fill = fill;
+        if (unnotified++ == 0) first_unnotified = now;
+        bool notify = unnotified >= wake_blocks || !timekeeper;   // No timer armed: nobody else would
+        if (!notify && wake_budget > 0.0) {
+            notify = chrono::duration<double>(now - first_unnotified).count() + 2.0 * fill > wake_budget;
+        }
+        if (notify) unnotified = 0;
+        return notify;
+    }
+    
+    /**
+     * coalescing_interval(): Longest a block may wait for a wakeup once
+     * pushed (caller holds mtx; 0 = every push notifies)
+     * A batch's worth of fill time, shortened to stay within the budget.
+     */
+    double coalescing_interval() const {
+        if (wake_blocks <= 1 || last_fill <= 0.0) return 0.0;
+        double interval = wake_blocks * last_fill;
+        if (wake_budget > 0.0) interval = min(interval, wake_budget - last_fill);
+        return max(interval, MIN_WAKE_INTERVAL);
+    }
+    
+    /**
+     * wait_for_blocks(): Sleep until a block is queued or the producer is
+     * done (caller holds mtx)
+     * A coalesced push may not notify, and if the producer then pauses
+     * (retune, stall, slow stream) no later push will. One consumer, the
+     * timekeeper, sleeps for the coalescing interval only and takes what
+     * was pushed meanwhile; the others sleep until notified. A timekeeper
+     * leaving with blocks queued wakes one of them to take over the timer.
+     */
+    void wait_for_blocks(unique_lock<mutex>& lock) {
+        while (total_blocks == 0 && !producer_done.load()) {
+            const double interval = coalescing_interval();
+            if (interval > 0.0 && !timekeeper) {
+                timekeeper = true;
+                cv.wait_for(lock, chrono::duration<double>(interval));
+                timekeeper = false;
+                if (total_blocks > 0 && sleepers > 0) cv.notify_one();
+            } else {
+                sleepers++;
+                cv.wait(lock);
+                sleepers--;
+            }
+        }
+    }
+    
+    /**
+     * pass_wakeup_on(): A coalesced wakeup covers several blocks; if some
+     * are left after a pop, wake the next consumer (caller holds mtx)
+     */
+    void pass_wakeup_on() {
+        if (wake_blocks > 1 && total_blocks > 0) cv.notify_one();
+    }
+    
+    /**
+     * spin_for_work(): Poll the (atomic) byte count without the lock until a
+     * block arrives or spin_seconds pass; a block found this way skips the
+     * condition variable sleep and its wakeup latency
+     */
+    void spin_for_work() {
+        const double spin = spin_seconds.load(memory_order_relaxed);
+        if (spin <= 0.0 || queued_bytes.load(memory_order_relaxed) > 0) return;
+        const auto deadline = chrono::steady_clock::now() +
+            chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(spin));
+        for (unsigned n = 1; queued_bytes.load(memory_order_relaxed) == 0 && !producer_done.load(memory_order_relaxed); n++) {
+            cpu_relax();
+            if ((n & 63) == 0 && chrono::steady_clock::now() > deadline) break;
+        }
+    }
+    
+    /**
+     * next_lane(): Pick the lane to serve (caller holds mtx, queue non-empty)
+     * Highest non-empty lane, unless a lower lane is starving.
+     */
+    size_t next_lane(chrono::steady_clock::time_point now) {
+        size_t first = 0;
+        while (lanes[first].blocks.empty()) first++;
+        
+        size_t chosen = first;
+        for (size_t lane = NUM_LANES - 1; lane > first; lane--) {
+            if (lanes[lane].blocks.empty()) continue;
+            double head_wait = chrono::duration<double>(
+                now - lanes[lane].blocks.front().timestamp).count();
+            if (head_wait > max_lane_wait || lanes[lane].skipped >= STARVATION_LIMIT) {
+                chosen = lane;
+                break;
+            }
+        }
+        
+        // Count the pop against every non-empty lane it bypassed
+        for (size_t lane = 0; lane < NUM_LANES; lane++) {
+            if (lane == chosen) lanes[lane].skipped = 0;
+            else if (lane > chosen && !lanes[lane].blocks.empty()) lanes[lane].skipped++;
+        }
+        return chosen;
+    }
+    
+    /**
+     * update_compaction(): Pick the pack format for new blocks with hysteresis
+     * Runs in push() before the lock is taken and updates `compaction`
+     * unsynchronized. This is only correct with a single producer thread,
+     * which lab1 has: the RX thread, one at a time across restarts.
+     * @param bytes: Queued payload bytes
+     * @param budget: Byte budget read once by the caller (> 0)
+     */
+    SampleFormat update_compaction(size_t bytes, size_t budget) {
+        double occupancy = static_cast<double>(bytes) / budget;
+        switch (compaction) {
+            case SampleFormat::FC32:
+                if (occupancy > SC8_WATERMARK) compaction = SampleFormat::SC8;
+                else if (occupancy > SC16_WATERMARK) compaction = SampleFormat::SC16;
+                break;
+            case SampleFormat::SC16:
+                if (occupancy > SC8_WATERMARK) compaction = SampleFormat::SC8;
+                else if (occupancy < SC16_WATERMARK / 2) compaction = SampleFormat::FC32;
+                break;
+            case SampleFormat::SC8:
+                if (occupancy < SC16_WATERMARK / 2) compaction = SampleFormat::FC32;
+                else if (occupancy < SC8_WATERMARK / 2) compaction = SampleFormat::SC16;
+                break;
+        }
+        return compaction;
+    }
 };
 
 // Global queue instance for sample block communication
 // Shared between RX streamer thread and processing threads
 SampleQueue sample_queue;
 
+// ============================================================================
+//          RESULT REPORTING
+// ============================================================================
+
+// Sub-blocks per block for the noise floor
+const size_t NOISE_SEGMENTS = 8;
+
+/**
+ * NoiseObservation: one block's input to a NoiseFloorEstimator
+ */
+struct NoiseObservation {
+    double power[NOISE_SEGMENTS];   // Sub-block powers (or the subsampled block power)
+    size_t count = 0;               // Entries of power[] used
+    size_t averaged = 0;            // Samples averaged per entry
+    size_t span = 0;                // Stream samples each entry covers
+    double block_power = 0.0;
+    double rate = 0.0;              // Stream rate when the block was processed
+
+    NoiseEstimate apply(NoiseFloorEstimator& estimator) const {
+        return estimator.update(power, count, averaged, span, block_power, rate);
+    }
+};
+
+/**
+ * BlockResult: everything a processing thread reports for one block
+ */
+struct BlockResult {
+    int thread_id = 0;              // Worker that processed the block
+    size_t block_number = 0;        // Sequential block identifier
+    PowerEstimate power;            // Exact or subsampled average power
+    double noise_floor = 0.0;       // Noise floor estimated with this block (fc32 power)
+    double snr_db = 0.0;            // Block SNR relative to noise_floor
+    uint8_t priority = LANE_ROUTINE; // Queue lane the block travelled in
+    size_t queue_size = 0;          // Backlog when the block was processed
+    bool filtered = false;          // Channel selector ran (ordered mode)
+    double filtered_power = 0.0;    // Average power after the channel selector
+    std::vector<std::complex<float>> channel;   // Selector output for in-order stages
+    bool resampled = false;         // Resampler ran on the channel
+    double resampled_power = 0.0;   // Average power at the output rate
+    bool gated = false;             // Squelch closed: heavy stages skipped
+    std::vector<ToneBin> tones;     // Goertzel bins at --tones (heavy stages)
+    uint64_t sample_offset = 0;     // Stream index of the block's first sample
+    size_t block_size = 0;          // Samples in the block
+    SampleBuffer samples;           // Block samples (fc32) for in-order stages
+    NoiseObservation noise;         // Noise floor input, replayed in order (bursts)
+};
+
+// Noise floor shared by the processing threads
+std::unique_ptr<NoiseFloorEstimator> noise_floor;
+
+// Squelch gate shared by the processing threads (--squelch-db)
+std::unique_ptr<Squelch> squelch;
+
+// Bulk output of result lines (--output-flush-ms); null = line by line
+std::unique_ptr<OutputSink> output_sink;
+
+// Per-block output level (--verbosity, changeable over the control socket)
+std::atomic<OutputVerbosity> verbosity(OutputVerbosity::ALL);
+
+/**
+ * write_block_result(): Format one result line (with its newline)
+ */
+void write_block_result(std::ostream& out, const BlockResult& result) {
+    const PowerEstimate& power = result.power;
+    
+    // Configure floating-point output format for consistent display
+    out << std::fixed << std::setprecision(8);
+    
+    // Display comprehensive processing results
+    out << "[Thread " << result.thread_id << "] "               // Thread identification
+        << "Block #" << std::setw(6) << result.block_number    // Block sequence number
+        << " | Avg Power: " << (power.approximate ? '~' : ' ');
+    if (options.dbfs) {
+        out << std::setprecision(2) << std::setw(7) << fast_dbfs(power.avg_power) << " dBFS";
+    } else {
+        out << std::setw(13) << power.avg_power;               // Signal power level
+    }
+    if (power.approximate) {
+        // Subsampled estimate: 95% bound and fraction of samples read
+        if (options.dbfs) {
+            out << " ±" << fast_db((power.avg_power + power.error_bound) / std::max(power.avg_power, 1e-30))
+                << " dB";
+        } else {
+            out << " ±" << std::setprecision(8) << power.error_bound;
+        }
+        out << " (1/" << power.stride << ")";
+    }
+    if (result.filtered) {
+        out << " | Filtered: ";
+        if (options.dbfs) {
+            out << std::setw(7) << fast_dbfs(result.filtered_power) << " dBFS";
+        } else {
+            out << std::setw(13) << result.filtered_power;
+        }
+    }
+    if (result.resampled) {
+        out << " | Resampled: ";
+        if (options.dbfs) {
+            out << std::setw(7) << fast_dbfs(result.resampled_power) << " dBFS";
+        } else {
+            out << std::setw(13) << result.resampled_power;
+        }
+    }
+    if (!result.tones.empty()) {
+        out << " | Tones:" << std::setprecision(1);
+        for (size_t k = 0; k < result.tones.size(); k++) {
+            out << (k ? "/" : " ") << fast_dbfs(result.tones[k].power);
+        }
+        out << " dBFS";
+    }
+    out << " | SNR: " << std::setprecision(1) << std::setw(5) << result.snr_db << " dB"
+        << " | Queue Size: " << result.queue_size              // Queue backlog status
+        << (result.priority == LANE_FLAGGED ? " [FLAGGED]" : "")
+        << (result.gated ? " [SQUELCHED]" : "")
+        << '\n';
+}
+
+/**
+ * print_block_result(): One result line per block, flushed at once or
+ * handed to the output sink
+ */
+void print_block_result(const BlockResult& result) {
+    const OutputVerbosity level = verbosity.load(std::memory_order_relaxed);
+    if (level == OutputVerbosity::QUIET) return;
+    if (level == OutputVerbosity::EVENTS && result.priority != LANE_FLAGGED && (!squelch || result.gated)) return;
+    if (output_sink) {
+        std::ostringstream line;
+        write_block_result(line, result);
+        output_sink->write(line.str());
+    } else {
+        write_block_result(std::cout, result);
+        std::cout.flush();
+    }
+}
+
+// Ordered mode: results re-sequenced into block order before printing
+std::unique_ptr<ReorderBuffer<BlockResult>> ordered_results;
+
+// DC / IQ-imbalance corrector (--iq-correct), run by the RX thread; its
+// estimates can be read from any thread
+std::unique_ptr<IqCorrector> iq_corrector;
+
+// Rational resampler (--out-rate), created by configure_receiver() once the
+// actual rate is known, before any thread starts
+std::unique_ptr<RationalResampler> resampler;
+std::vector<std::complex<float>> resampled_buffer;   // Only used by emit_ordered_result()
+
+// Burst extraction (--burst-db): segmenter, the records completed by the
+// current block, and a noise floor fed in block order (the shared one
+// follows completion order, which varies from run to run); only used by
+// emit_ordered_result()
+std::unique_ptr<BurstSegmenter> burst_segmenter;
+std::vector<BurstRecord> completed_bursts;
+std::unique_ptr<NoiseFloorEstimator> burst_floor;
+
+// Tone tracking (--tones): bins of consecutive blocks give the frequency
+// offset, so in ordered mode it is fed from the in-order path; otherwise
+// by the workers as blocks finish (offsets from the consecutive pairs)
+std::unique_ptr<ToneTracker> tone_tracker;
+std::mutex tone_tracker_mutex;
+
+/**
+ * track_tones(): Fold a result's tone bins into the tracker
+ */
+void track_tones(const BlockResult& result) {
+    if (!tone_tracker || result.tones.empty()) return;
+    std::lock_guard<std::mutex> lock(tone_tracker_mutex);
+    tone_tracker->update(result.block_number, result.sample_offset, result.block_size, result.tones);
+}
+
+// Capture container (--record), written by the RX thread only
+std::unique_ptr<CaptureWriter> capture_writer;
+
+// Dynamic block sizing (--target-latency-ms / --max-overhead): measured by
+// the workers, applied by the RX thread between blocks
+std::unique_ptr<BlockSizeController> block_sizer;
+size_t worker_count();   // Current pool size, for the sizer's utilization limit
+
+// Trend files (--history): fed by the workers, rolled up by their own thread
+std::unique_ptr<RollupStore> history;
+enum HistorySeries : size_t { HISTORY_POWER, HISTORY_LATENCY, HISTORY_QUEUE };
+const std::vector<std::string> HISTORY_NAMES = {"power", "latency_ms", "queue_depth"};
+
+// Block power percentiles (--quantiles-s): one sketch per worker id,
+// merged per interval by report_power_quantiles() into the run total
+const double POWER_QUANTILES[] = {0.01, 0.5, 0.9, 0.99};
+std::unique_ptr<SketchSlots> power_sketches;
+KllSketch run_power_sketch;                              // Reporter only
+atomic<double> interval_power_quantile[4];               // Latest interval, for the metrics
+
+/**
+ * write_burst(): Format one burst record line (with its newline)
+ */
+void write_burst(std::ostream& out, const BurstRecord& burst) {
+    out << "[Burst] Offset " << std::setw(10) << burst.sample_offset;
+    if (!block_sizer) {
+        out << " (block " << burst.sample_offset / options.block_samples << ")";
+    }
+    out << " | Length: " << std::setw(7) << burst.length
+        << " | Peak: " << std::fixed << std::setprecision(1);
+    if (options.dbfs) {
+        out << fast_dbfs(burst.peak_power) << " dBFS"
+            << " | Avg Power: " << std::setprecision(2) << fast_dbfs(burst.avg_power) << " dBFS";
+    } else {
+        out << fast_db(burst.peak_power) << " dB"
+            << " | Avg Power: " << std::setprecision(8) << burst.avg_power;
+    }
+    out << (burst.truncated ? " [SPLIT]" : "") << '\n';
+}
+
+/**
+ * print_burst(): One line per extracted burst record
+ */
+void print_burst(const BurstRecord& burst) {
+    if (verbosity.load(std::memory_order_relaxed) == OutputVerbosity::QUIET) return;
+    if (output_sink) {
+        std::ostringstream line;
+        write_burst(line, burst);
+        output_sink->write(line.str());
+    } else {
+        write_burst(std::cout, burst);
+        std::cout.flush();
+    }
+}
+
+/**
+ * emit_ordered_result(): In-order output path (one worker at a time, outside
+ * the reorder lock)
+ *
+ * Stages that carry state from one block to the next run here, where blocks
+ * arrive strictly in sequence.
+ */
+void emit_ordered_result(uint64_t, BlockResult& result) {
+    if (resampler && result.filtered) {
+        resampler->process(result.channel.data(), result.channel.size(), resampled_buffer);
+        double sum_power = 0.0;
+        for (const auto& sample : resampled_buffer) {
+            sum_power += std::norm(sample);
+        }
+        result.resampled = true;
+        result.resampled_power = resampled_buffer.empty() ? 0.0 : sum_power / resampled_buffer.size();
+    }
+    print_block_result(result);
+    track_tones(result);
+    
+    if (burst_segmenter) {
+        // Thresholds follow the floor of the blocks up to this one, in order
+        burst_segmenter->set_noise_floor(result.noise.apply(*burst_floor).noise_floor);
+        burst_segmenter->process(result.sample_offset, result.samples.data(), result.samples.size(),
+                                 completed_bursts);
+        for (const auto& burst : completed_bursts) {
+            print_burst(burst);
+        }
+        completed_bursts.clear();   // Buffers go back to the pool
+    }
+}
+
 // ============================================================================
 //          RX STREAMER THREAD
 // ============================================================================
 
 /**
- * rx_streamer_thread(): Main SDR receiver thread function
- * 
- * This function implements the producer thread in the producer-consumer pattern.
- * It configures the USRP hardware, establishes an RF streaming connection,
- * and continuously receives IQ samples from the RF frontend.
- * 
+ * update_stream_tail(): Slide the window of the most recent raw samples
+ *
+ * The window is the overlap the next block needs in ordered mode. sc8
+ * samples are widened with the block's own scale, exactly as the workers
+ * will widen the block itself.
+ *
+ * @param tail: Last tail.size() samples of the stream, updated in place
+ * @param block: Block just received (fc32 or sc8)
+ */
+void update_stream_tail(std::vector<std::complex<float>>& tail, const SampleBlock& block) {
+    const size_t hist = tail.size();
+    const size_t n = block.size();
+    const size_t keep = (n >= hist) ? 0 : hist - n;   // Older samples still in the window
+    std::copy(tail.end() - keep, tail.end(), tail.begin());
+    const size_t take = hist - keep;
+    const size_t first = n - take;
+    if (block.format == SampleFormat::SC8) {
+        unpack_sc8(block.samples_sc8.data() + first, take, tail.data() + keep, block.int_scale);
+    } else {
+        std::copy(block.samples.begin() + first, block.samples.end(), tail.begin() + keep);
+    }
+}
+
+/**
+ * open_capture_writer(): Create (or with --append, continue) the capture
+ * container, described by the settings the hardware actually applied
+ * @return: false if recording cannot start
+ */
+bool open_capture_writer(uhd::usrp::multi_usrp::sptr usrp, bool sc8, float scale) {
+    CaptureInfo info;
+    info.format = sc8 ? SampleFormat::SC8 : SampleFormat::FC32;
+    info.int_scale = scale;
+    info.block_samples = options.block_samples;
+    info.rx_freq = usrp->get_rx_freq();
+    info.rx_rate = usrp->get_rx_rate();
+    info.rx_gain = usrp->get_rx_gain();
+    
+    std::string error;
+    capture_writer.reset(new CaptureWriter());
+    if (!options.append) {
+        if (capture_writer->create(options.record, info, error)) return true;
+    } else {
+        CaptureInfo existing;
+        if (capture_writer->append(options.record, existing, error)) {
+            if (existing.format == info.format && existing.block_samples == info.block_samples &&
+                existing.rx_rate == info.rx_rate && existing.int_scale == info.int_scale) {
+                std::cout << "Appending to " << options.record << " after chunk "
+                          << capture_writer->chunks() << std::endl;
+                return true;
+            }
+            error = "format, block size, rate or sc8 scale differ from the existing capture";
+        }
+    }
+    std::cerr << "Cannot record to " << options.record << ": " << error << std::endl;
+    capture_writer.reset();
+    return false;
+}
+
+/**
+ * RetuneRequest: a retune handed from the control socket to the RX thread,
+ * which owns the device; the requester waits for the result
+ */
+struct RetuneRequest {
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::atomic<bool> pending{false};   // Checked by the RX thread once per block
+    bool done = false;
+    double freq = 0.0;                  // Carrier frequency (Hz)
+    double rate = 0.0;                  // New sampling rate (Hz, 0 = unchanged)
+    std::string result;                 // Answer for the requester
+};
+
+RetuneRequest retune_request;
+
+// Longest wait for the LO to lock after a retune
+const double RETUNE_LOCK_TIMEOUT = 0.1;
+
+/**
+ * retune_stream(): Stop the stream, apply the requested frequency (and
+ * rate), wait for LO lock and restart. The only runtime change that
+ * interrupts the data; the gap is reported to the requester.
+ */
+void retune_stream(uhd::usrp::multi_usrp::sptr usrp, uhd::rx_streamer::sptr rx_stream,
+                   uhd::stream_cmd_t& stream_cmd) {
+    std::lock_guard<std::mutex> lock(retune_request.mtx);
+    const auto start = std::chrono::steady_clock::now();
+    stream_cmd.stream_mode = uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS;
+    rx_stream->issue_stream_cmd(stream_cmd);
+    
+    if (retune_request.rate > 0.0) {
+        usrp->set_rx_rate(retune_request.rate);
+        stream_rate.store(usrp->get_rx_rate());
+        sample_queue.set_sample_rate(usrp->get_rx_rate());
+    }
+    usrp->set_rx_freq(uhd::tune_request_t(retune_request.freq));
+    
+    std::vector<std::string> sensor_names = usrp->get_rx_sensor_names();
+    bool locked = true;
+    if (std::find(sensor_names.begin(), sensor_names.end(), "lo_locked") != sensor_names.end()) {
+        const auto deadline = start + std::chrono::duration<double>(RETUNE_LOCK_TIMEOUT);
+        while (!(locked = usrp->get_rx_sensor("lo_locked").to_bool()) &&
+               std::chrono::steady_clock::now() < deadline) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+    }
+    
+    stream_cmd.stream_mode = uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS;
+    rx_stream->issue_stream_cmd(stream_cmd);
+    const double gap = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    std::ostringstream answer;
+    answer << std::fixed << std::setprecision(6) << "ok tuned to " << usrp->get_rx_freq() / 1e9 << " GHz, rate "
+           << std::setprecision(3) << usrp->get_rx_rate() / 1e6 << " MHz, stream interrupted for "
+           << gap * 1e3 << " ms" << (locked ? "" : " (LO not locked!)");
+    std::cout << "[Control] Retune: " << answer.str().substr(3) << std::endl;
+    retune_request.result = answer.str();
+    retune_request.done = true;
+    retune_request.pending.store(false);
+    retune_request.cv.notify_all();
+}
+
+/**
+ * configure_receiver(): Apply the rate, carrier and gain and wait for the
+ * LO to lock, before any thread starts
+ *
  * HARDWARE CONFIGURATION SEQUENCE:
  * 1. Set sampling rate and verify actual rate achieved
- * 2. Tune RF frontend to desired carrier frequency  
+ * 2. Tune RF frontend to desired carrier frequency
  * 3. Configure receive gain for optimal signal levels
  * 4. Check LO (Local Oscillator) lock status
- * 5. Create and configure RX data stream
- * 
- * STREAMING OPERATION:
- * - Continuously receives blocks of IQ samples from USRP
- * - Handles error conditions (timeouts, overflows, etc.)
- * - Pushes complete sample blocks to processing queue
- * - Monitors for stop signal to terminate gracefully
- * 
+ *
  * @param usrp: Shared pointer to USRP device interface
  * @param sampling_rate: Desired sampling rate in samples/second
+ * @return: false if the LO did not lock
  */
-void rx_streamer_thread(uhd::usrp::multi_usrp::sptr usrp, double sampling_rate) {
-    
+bool configure_receiver(uhd::usrp::multi_usrp::sptr usrp, double sampling_rate) {
     // ========================================================================
     //           CONFIGURE SAMPLING RATE
     // ========================================================================
@@ -269,6 +1885,17 @@ void rx_streamer_thread(uhd::usrp::multi_usrp::sptr usrp, double sampling_rate)
     
     // Verify the actual sampling rate achieved by hardware
     cout << "Actual RX rate: " << usrp->get_rx_rate()/1e6 << " MHz" << endl;
+    stream_rate.store(usrp->get_rx_rate());
+    
+    // Resample from the rate the hardware actually delivers (100 MHz / N)
+    if (options.out_rate > 0.0) {
+        uint32_t interp = 1, decim = 1;
+        rational_ratio(options.out_rate, usrp->get_rx_rate(), interp, decim);
+        resampler.reset(new RationalResampler(interp, decim));
+        cout << "Resampling " << usrp->get_rx_rate()/1e6 << " MHz -> " << options.out_rate/1e6
+             << " MHz (L/M = " << interp << "/" << decim << ", "
+             << interp * resampler->taps_per_phase() << "-tap polyphase)" << endl;
+    }
     
     // ========================================================================
     //          CONFIGURE RF CARRIER FREQUENCY
@@ -313,22 +1940,78 @@ void rx_streamer_thread(uhd::usrp::multi_usrp::sptr usrp, double sampling_rate)
         // Abort if LO failed to lock (unstable frequency reference)
         if (!lo_locked.to_bool()) {
             std::cerr << "Failed to lock LO - RF frontend unstable!" << std::endl;
-            return;
+            return false;
         }
     }
+    return true;
+}
+
+/**
+ * rx_streamer_thread(): Main SDR receiver thread function
+ * 
+ * This function implements the producer thread in the producer-consumer pattern.
+ * On hardware already set up by configure_receiver(), it establishes an RF
+ * streaming connection and continuously receives IQ samples from the RF
+ * frontend.
+ * 
+ * STREAMING OPERATION:
+ * - Continuously receives blocks of IQ samples from USRP
+ * - Handles error conditions (timeouts, overflows, etc.)
+ * - Pushes complete sample blocks to processing queue
+ * - Monitors for stop signal to terminate gracefully
+ * 
+ * @param usrp: Shared pointer to USRP device interface
+ * @param sampling_rate: Desired sampling rate in samples/second
+ */
+void rx_streamer_thread(uhd::usrp::multi_usrp::sptr usrp, double sampling_rate) {
+    
+    // Progress reported to the watchdog (one relaxed store per block)
+    Heartbeat& heartbeat = watchdog.attach("rx", 0, true);
+    ThreadCpuScope cpu_clock(thread_clocks, "rx", 0);
+    if (options.pin && !pin_current_thread(0)) {
+        std::cerr << "Cannot pin the RX thread to core 0" << std::endl;
+    }
     
     // ========================================================================
     //          CREATE AND CONFIGURE DATA STREAM
     // ========================================================================
     // Set up the data streaming interface between USRP and host computer
-    // fc32: 32-bit floating point complex on CPU (I+jQ)
-    // sc16: 16-bit signed complex over Ethernet/USB
-    uhd::stream_args_t stream_args("fc32", "sc16");  // CPU format, Wire format
+    // sc16 wire: 16-bit signed complex over Ethernet, fc32 (float I+jQ) on CPU
+    // sc8 wire:  8-bit signed complex over Ethernet, kept as sc8 on CPU
+    const WireFormat wire = options.wire_format;
+    const bool use_sc8 = (wire == WireFormat::SC8);
+    uhd::stream_args_t stream_args(host_format_for(wire), wire_format_name(wire));
+    if (use_sc8) {
+        // "peak" selects which part of the 16-bit range the FPGA maps to int8
+        stream_args.args["peak"] = std::to_string(options.sc8_peak);
+    }
     uhd::rx_streamer::sptr rx_stream = usrp->get_rx_stream(stream_args);
     
+    std::cout << "Wire format: " << wire_format_name(wire)
+              << " (" << wire_bytes_per_sample(wire) << " bytes/sample, link limit "
+              << max_link_rate(wire)/1e6 << " MS/s)" << std::endl;
+    if (sampling_rate > max_link_rate(wire)) {
+        std::cout << "WARNING: " << sampling_rate/1e6 << " MHz exceeds the "
+                  << wire_format_name(wire) << " link limit - expect overflows" << std::endl;
+    }
+    
     // Allocate receive buffer for one block of IQ samples
-    // Buffer size determines the granularity of processing
-    std::vector<std::complex<float>> buff(SAMPLES_PER_BLOCK);
+    // Buffer size determines the granularity of processing; with dynamic
+    // sizing it is reserved for the largest block so resizing never reallocates
+    size_t block_samples = options.block_samples;
+    std::vector<std::complex<float>> buff;
+    std::vector<std::complex<int8_t>> buff_sc8;
+    const size_t capacity = block_sizer ? BlockSizeController::MAX_BLOCK : block_samples;
+    if (use_sc8) {
+        buff_sc8.reserve(capacity);
+        buff_sc8.resize(block_samples);
+    } else {
+        buff.reserve(capacity);
+        buff.resize(block_samples);
+    }
+    void* recv_buff = use_sc8 ? static_cast<void*>(buff_sc8.data())
+                              : static_cast<void*>(buff.data());
+    const float sc8_scale = static_cast<float>(options.sc8_peak / SC8_FULL_SCALE);
     
     // ========================================================================
     //      CONFIGURE STREAMING PARAMETERS
@@ -350,6 +2033,18 @@ void rx_streamer_thread(uhd::usrp::multi_usrp::sptr usrp, double sampling_rate)
     uhd::rx_metadata_t md;        // Metadata for each receive operation
     size_t block_counter = 0;     // Sequential block numbering
     
+    // Front-end energy check: quick power from every FLAG_STRIDE-th sample
+    // compared against a slow running average of the same estimate
+    const size_t FLAG_STRIDE = 64;
+    const double flag_ratio = std::pow(10.0, options.flag_db / 10.0);
+    double running_power = 0.0;
+    
+    // Ordered mode: each block carries the raw samples preceding it so the
+    // stateful channel selector can run on any worker (overlap-save)
+    const size_t history_length = options.ordered ? options.taps - 1 : 0;
+    std::vector<std::complex<float>> stream_tail(history_length);   // Zeros before the stream starts
+    uint64_t samples_received = 0;  // Absolute index of the next queued sample
+    
     // ========================================================================
     //          MAIN STREAMING LOOP
     // ========================================================================
@@ -357,22 +2052,40 @@ void rx_streamer_thread(uhd::usrp::multi_usrp::sptr usrp, double sampling_rate)
     // Each iteration receives one block of IQ samples from the RF frontend
     while (!stop_signal.load()) {
         
+        // Retune requested over the control socket
+        if (retune_request.pending.load(std::memory_order_relaxed)) {
+            retune_stream(usrp, rx_stream, stream_cmd);
+        }
+        
+        // The watchdog saw no blocks for a while: restart the stream
+        if (watchdog.take_restart_request()) {
+            stream_cmd.stream_mode = uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS;
+            rx_stream->issue_stream_cmd(stream_cmd);
+            stream_cmd.stream_mode = uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS;
+            rx_stream->issue_stream_cmd(stream_cmd);
+            std::cerr << "[Watchdog] RX stream restarted" << std::endl;
+        }
+        
         // Receive one block of samples from USRP hardware
         // This is a blocking call that waits for data from the RF frontend
+        heartbeat.set_state(ThreadState::RECEIVING);
         size_t num_rx_samps = rx_stream->recv(
-            &buff.front(),    // Destination buffer pointer
-            buff.size(),      // Maximum number of samples to receive
+            recv_buff,        // Destination buffer pointer (fc32 or sc8)
+            block_samples,    // Maximum number of samples to receive
             md,               // Metadata (timestamps, error flags, etc.)
             3.0               // Timeout in seconds
         );
+        heartbeat.set_state(ThreadState::WORKING);
         
         // ====================================================================
         //      ERROR HANDLING AND STATUS MONITORING
         // ====================================================================
         
-        // Handle timeout condition (no data received within timeout period)
+        // Handle timeout condition (no data received within timeout period):
+        // give up, unless the watchdog may still restart the stream
         if (md.error_code == uhd::rx_metadata_t::ERROR_CODE_TIMEOUT) {
             std::cerr << "Timeout: No data received from USRP" << std::endl;
+            if (watchdog.restart_possible()) continue;
             break;  // Exit streaming loop
         }
         
@@ -396,17 +2109,87 @@ void rx_streamer_thread(uhd::usrp::multi_usrp::sptr usrp, double sampling_rate)
         // ====================================================================
         
         // Only process complete blocks
-        if (num_rx_samps == SAMPLES_PER_BLOCK) {
+        if (num_rx_samps == block_samples) {
             // Create new sample block with sequential numbering
-            SampleBlock block(block_counter++, SAMPLES_PER_BLOCK);
+            SampleBlock block(block_counter++, 0);
+            
+            // Remove DC / IQ imbalance in place, in stream order
+            if (iq_corrector) {
+                if (use_sc8) {
+                    iq_corrector->correct(buff_sc8.data(), num_rx_samps, sc8_scale);
+                } else {
+                    iq_corrector->correct(buff.data(), num_rx_samps);
+                }
+            }
+            
+            // Copy received samples to block in their host format
+            if (use_sc8) {
+                block.format = SampleFormat::SC8;
+                block.samples_sc8 = buff_sc8;
+                block.int_scale = sc8_scale;
+            } else {
+                block.samples = buff;
+            }
             
-            // Copy received samples to block
-            block.samples = buff;
+            // Position in the stream and overlap for stateful stages
+            block.sample_offset = samples_received;
+            samples_received += num_rx_samps;
+            if (history_length > 0) {
+                block.history = stream_tail;
+                update_stream_tail(stream_tail, block);
+            }
+            
+            // Flag blocks well above the running average for the high-priority lane
+            block.priority = LANE_ROUTINE;
+            if (options.flag_db > 0.0) {
+                double quick_power = subsampled_power(block, FLAG_STRIDE, 0).avg_power;
+                if (running_power > 0.0 && quick_power > running_power * flag_ratio) {
+                    block.priority = LANE_FLAGGED;
+                }
+                running_power = (running_power == 0.0) ? quick_power
+                              : running_power + 0.01 * (quick_power - running_power);
+            }
+            
+            // Record the block exactly as the workers will see it
+            if (capture_writer && !capture_writer->write(block)) {
+                std::cerr << "Capture write failed - recording stopped" << std::endl;
+                capture_writer->close();    // Index of the chunks written so far
+                capture_writer.reset();
+            }
+            
+            // Push block to processing queue (may be packed or dropped
+            // when a byte budget is configured)
+            const uint64_t number = block.block_number;
+            sample_queue.push(std::move(block));
+            blocks_produced.fetch_add(1, std::memory_order_relaxed);
+            heartbeat.block.store(number, std::memory_order_relaxed);
+            heartbeat.beat();
             
-            // Push block to processing queue
-            sample_queue.push(block);
+            // Dynamic sizing: the next recv() simply asks for the new size
+            if (block_sizer) {
+                // Workers that have a core of their own, as the pool is sized now
+                const size_t workers = std::min<size_t>(worker_count(),
+                                                        std::max(1u, std::thread::hardware_concurrency()));
+                const size_t next = block_sizer->next_size(block_samples, workers);
+                if (next != block_samples) {
+                    const BlockSizeDecision& d = block_sizer->last_decision();
+                    const double fill = block_samples / sampling_rate;
+                    std::cout << "[BlockSize] " << block_samples << " -> " << next << " samples (latency "
+                              << std::fixed << std::setprecision(2) << d.latency_s * 1e3 << " ms = fill "
+                              << fill * 1e3 << " + queue " << d.wait_s * 1e3 << " + work "
+                              << (d.latency_s - fill - d.wait_s) * 1e3 << "; overhead "
+                              << std::setprecision(1) << d.overhead * 100.0 << "%"
+                              << (d.overloaded ? ", overloaded" : "") << ")" << std::endl;
+                    block_samples = next;
+                    if (use_sc8) buff_sc8.resize(block_samples);
+                    else buff.resize(block_samples);
+                    recv_buff = use_sc8 ? static_cast<void*>(buff_sc8.data())
+                                        : static_cast<void*>(buff.data());
+                }
+            }
         }
     }
+    heartbeat.set_state(ThreadState::STOPPED);
     
     // ========================================================================
     //      CLEANUP AND SHUTDOWN SEQUENCE
@@ -419,6 +2202,13 @@ void rx_streamer_thread(uhd::usrp::multi_usrp::sptr usrp, double sampling_rate)
     std::cout << "\n=== RX Streaming Stopped ===" << std::endl;
     std::cout << "Total blocks transmitted: " << block_counter << std::endl;
     std::cout << "Total overflows: " << overflow_count.load() << std::endl;
+#ifdef SIMULATE_MODE
+    if (use_sc8) {
+        std::cout << "Measured sc8 SQNR: " << std::fixed << std::setprecision(1)
+                  << rx_stream->measured_sqnr_db() << " dB (ideal full-scale "
+                  << quantization_snr_db(wire) << " dB)" << std::endl;
+    }
+#endif
     
     // Performance assessment
     if (overflow_count.load() > 0) {
@@ -432,6 +2222,82 @@ void rx_streamer_thread(uhd::usrp::multi_usrp::sptr usrp, double sampling_rate)
 //          SIGNAL PROCESSING THREAD
 // ============================================================================
 
+void processing_thread(int thread_id, double sampling_rate);
+
+/**
+ * WorkerPool: the processing threads, resizable while streaming
+ *
+ * Worker i (ids start at 1) runs while i <= size(). Growing starts the
+ * missing workers; shrinking lets each surplus worker finish the block (or
+ * batch) it holds and retire before taking the next one. A retired
+ * worker's slot is reused by a later grow.
+ */
+class WorkerPool {
+public:
+    static const size_t MAX_WORKERS = 64;
+    
+    /**
+     * resize(): Set the number of workers
+     * @param workers: New pool size (1..MAX_WORKERS)
+     * @param sampling_rate: Passed to new workers (normalizes --mix-hz)
+     */
+    void resize(size_t workers, double sampling_rate) {
+        std::lock_guard<std::mutex> lock(mtx);
+        target.store(workers);
+        while (slots.size() < workers) slots.emplace_back(new Slot());
+        for (size_t i = 0; i < workers; i++) {
+            Slot& slot = *slots[i];
+            if (slot.thread.joinable() && slot.retired) {
+                slot.thread.join();          // Retired (or retiring) worker: start afresh
+            }
+            if (!slot.thread.joinable()) {
+                slot.retired = false;
+                slot.thread = std::thread(processing_thread, static_cast<int>(i + 1), sampling_rate);
+            }
+        }
+    }
+    
+    /**
+     * try_retire(): Called by worker `id` between blocks; true if it must
+     * leave (decided under the lock, so a concurrent grow sees it)
+     */
+    bool try_retire(int id) {
+        if (static_cast<size_t>(id) <= target.load(std::memory_order_relaxed)) return false;
+        std::lock_guard<std::mutex> lock(mtx);
+        if (static_cast<size_t>(id) <= target.load()) return false;
+        slots[id - 1]->retired = true;
+        return true;
+    }
+    
+    size_t size() const { return target.load(); }
+    
+    // Join every worker (after the stop signal)
+    void join_all() {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (auto& slot : slots) {
+            if (slot->thread.joinable()) slot->thread.join();
+        }
+    }
+    
+private:
+    struct Slot {
+        std::thread thread;
+        bool retired = false;                // Under mtx
+    };
+    std::mutex mtx;
+    std::vector<std::unique_ptr<Slot>> slots;
+    std::atomic<size_t> target{0};
+};
+
+WorkerPool worker_pool;
+
+/**
+ * worker_count(): Processing threads the pool runs now (follows resizes)
+ */
+size_t worker_count() {
+    return worker_pool.size();
+}
+
 /**
  * processing_thread(): Consumer thread for signal analysis
  * 
@@ -450,29 +2316,110 @@ void rx_streamer_thread(uhd::usrp::multi_usrp::sptr usrp, double sampling_rate)
  * - x[n] = complex sample (I + jQ)
  * - |x[n]|² = I² + Q² (magnitude squared)
  * 
+ * Overload mode (--shed-age-ms):
+ * When a block has waited in the queue longer than the threshold, the power
+ * is estimated from every stride-th sample (random start) and reported with
+ * '~' and a 95% error bound. Exact processing resumes below half the
+ * threshold.
+ * 
+ * Noise floor and SNR (--noise-window-s):
+ * The power pass also yields NOISE_SEGMENTS sub-block powers, which feed
+ * the shared minimum-statistics floor; each result carries the floor and
+ * the block's SNR for the squelch, the burst extractor and the output.
+ * 
+ * Squelch (--squelch-db):
+ * Blocks whose power stays near the noise floor skip the heavy stages and
+ * are reported as [SQUELCHED]; only the power line is printed for them
+ * (plus the channel, which the resampler needs for every block).
+ * 
+ * Ordered mode (--ordered):
+ * Every block also runs through the channel selector (mixer + lowpass FIR).
+ * Its state comes with the block (sample_offset and history), so any worker
+ * can take any block; results go through ordered_results and are printed
+ * in block order, identical to a single-threaded run.
+ * 
+ * Pool resizing (control socket "workers N"):
+ * Workers above the new pool size retire between blocks (see WorkerPool).
+ * 
+ * Batched pops (--pop-batch):
+ * Up to N blocks are taken per queue lock and worked off one by one; their
+ * queue wait keeps counting until each is processed.
+ * 
  * @param thread_id: Unique identifier for this processing thread
+ * @param sampling_rate: Stream sampling rate (normalizes --mix-hz)
  */
-void processing_thread(int thread_id) {
+void processing_thread(int thread_id, double sampling_rate) {
     
     // Thread startup notification
     std::cout << "Processing thread " << thread_id << " started" << std::endl;
     
     // Local statistics tracking
     size_t blocks_processed = 0;  // Count of blocks processed by this thread
+    bool retired = false;         // Left because the pool shrank
+    
+    // Per-thread overload controller (no shared state between workers)
+    LoadShedder shedder(options.shed_age_ms / 1000.0, thread_id);
+    
+    // Ordered mode: per-thread channel selector and work buffers
+    std::unique_ptr<ChannelSelector> selector;
+    if (options.ordered) {
+        selector.reset(new ChannelSelector(options.mix_hz / sampling_rate, options.taps, options.cutoff,
+                                         options.conv));
+    }
+    std::vector<std::complex<float>> widened;    // sc8 block converted to fc32
+    std::vector<std::complex<float>> filtered;   // Channel selector output
+    
+    // Tone bins (--tones): per-thread Goertzel state
+    std::unique_ptr<GoertzelBank> tone_bank;
+    if (!options.tones.empty()) {
+        std::vector<double> freqs;
+        for (double hz : options.tones) freqs.push_back(hz / sampling_rate);
+        tone_bank.reset(new GoertzelBank(freqs));
+    }
+    Heartbeat& heartbeat = watchdog.attach("worker", thread_id);
+    ThreadCpuScope cpu_clock(thread_clocks, "worker", thread_id);
+    if (options.pin && !pin_current_thread(thread_id)) {
+        std::cerr << "Cannot pin processing thread " << thread_id << std::endl;
+    }
+    
+    // Blocks taken from the queue in one batch (--pop-batch) and not yet processed
+    std::vector<SampleBlock> batch;
+    size_t batch_next = 0;
     
     // ========================================================================
     // MAIN PROCESSING LOOP: CONSUME AND ANALYZE SAMPLE BLOCKS
     // ========================================================================
-    while (!stop_signal.load()) {
+    // After the stop signal the queue and the current batch are drained:
+    // the loop ends when pop() finds the queue empty after the RX thread
+    // has exited, so every block it pushed is processed
+    for (;;) {
+        // Surplus after a pool resize: leave with no block in hand
+        if (batch_next == batch.size() && worker_pool.try_retire(thread_id)) {
+            retired = true;
+            break;
+        }
         SampleBlock block;  // Local storage for retrieved sample block
         
         // ====================================================================
         //      RETRIEVE SAMPLE BLOCK FROM QUEUE
         // ====================================================================
         // Blocking operation - thread sleeps until data available
-        if (!sample_queue.pop(block)) {
-            break;  // Stop signal received or queue empty during shutdown
+        heartbeat.set_state(ThreadState::WAITING);
+        if (options.pop_batch <= 1) {
+            if (!sample_queue.pop(block)) {
+                break;  // Producer done and queue drained
+            }
+        } else {
+            if (batch_next == batch.size()) {
+                batch.clear();
+                batch_next = 0;
+                if (!sample_queue.pop_batch(batch, options.pop_batch)) {
+                    break;
+                }
+            }
+            block = std::move(batch[batch_next++]);
         }
+        heartbeat.begin(block.block_number);
         
         // ====================================================================
         //      SIGNAL POWER ANALYSIS
@@ -480,44 +2427,434 @@ void processing_thread(int thread_id) {
         // Calculate the average power of the received RF signal block
         // Power = energy per unit time, indicating signal strength
         
-        double sum_power = 0.0;  // Accumulator for total power
+        // Average power (1/N) * Σ|x[n]|² over the block, normalized for block
+        // size. fc32 blocks use std::norm() per sample; sc8 blocks use the
+        // SIMD int8 kernel and are scaled back to fc32 units.
+        // In overload, estimate from a strided subset instead.
+        const auto work_start = std::chrono::steady_clock::now();
+        const double cpu_start = block_sizer ? thread_cpu_seconds() : 0.0;
+        const size_t block_size = block.size();
+        double queue_age = std::chrono::duration<double>(work_start - block.timestamp).count();
+        size_t stride = std::max(shedder.stride_for(queue_age), options.stats_stride);
+        NoiseObservation observation;
+        const size_t segments = std::min(NOISE_SEGMENTS, block_size);
+        PowerEstimate power = (stride > 1)
+            ? subsampled_power(block, stride, shedder.random_offset(stride))
+            : exact_power_segments(block, segments, observation.power);
+        if (power.approximate) {
+            approximate_count++;
+        }
         
-        // Iterate through all IQ samples in the block
-        for (const auto& sample : block.samples) {
-            // Calculate magnitude squared: |x|² = I² + Q²
-            // std::norm() efficiently computes real²+imag² for complex numbers
-            sum_power += std::norm(sample);
+        // Noise floor from the sub-blocks (a subsampled block counts as one)
+        observation.block_power = power.avg_power;
+        observation.rate = stream_rate.load(std::memory_order_relaxed);
+        if (power.approximate) {
+            observation.power[0] = power.avg_power;
+            observation.count = 1;
+            observation.averaged = power.samples_used;
+            observation.span = block_size;
+        } else {
+            observation.count = segments;
+            observation.averaged = observation.span = block_size / std::max<size_t>(segments, 1);
+        }
+        const NoiseEstimate noise = observation.apply(*noise_floor);
+        
+        BlockResult result;
+        result.thread_id = thread_id;
+        result.block_number = block.block_number;
+        result.power = power;
+        result.noise_floor = noise.noise_floor;
+        if (burst_floor) result.noise = observation;
+        result.snr_db = noise.snr_db;
+        result.priority = block.priority;
+        const size_t queue_depth = sample_queue.size();
+        result.queue_size = queue_depth;
+        result.sample_offset = block.sample_offset;
+        result.block_size = block_size;
+        
+        // ====================================================================
+        //      SQUELCH GATE
+        // ====================================================================
+        // Everything below this point is heavy analysis: skip it on blocks
+        // the squelch classifies as noise only
+        const bool run_heavy = !squelch || squelch->update(power.avg_power, noise.noise_floor);
+        result.gated = !run_heavy;
+        double heavy_start = run_heavy ? thread_cpu_seconds() : 0.0;
+        
+        // ====================================================================
+        //      STATEFUL CHANNEL SELECTION (ORDERED MODE)
+        // ====================================================================
+        if (selector && (run_heavy || resampler)) {   // The resampler needs every block
+            const size_t n = block.size();
+            const std::complex<float>* in = block.samples.data();
+            if (block.format == SampleFormat::SC8) {
+                widened.resize(n);
+                unpack_sc8(block.samples_sc8.data(), n, widened.data(), block.int_scale);
+                in = widened.data();
+            }
+            filtered.resize(n);
+            selector->process(block.sample_offset, block.history.data(), in, n, filtered.data());
+            double sum_power = 0.0;
+            for (const auto& sample : filtered) {
+                sum_power += std::norm(sample);
+            }
+            result.filtered = true;
+            result.filtered_power = n > 0 ? sum_power / n : 0.0;
+            if (options.out_rate > 0.0) {
+                result.channel.assign(filtered.begin(), filtered.end());
+            }
+            if (resampler && run_heavy) heavy_start = thread_cpu_seconds();   // Not gated: not saved
+        }
+        
+        // ====================================================================
+        //      TONE BINS
+        // ====================================================================
+        // Phases are referenced to sample_offset, so bins of any block line
+        // up with its neighbours whichever worker computed them
+        if (tone_bank && run_heavy) {
+            const std::complex<float>* in = block.samples.data();
+            if (block.format == SampleFormat::SC8) {
+                if (!selector) {
+                    widened.resize(block_size);
+                    unpack_sc8(block.samples_sc8.data(), block_size, widened.data(), block.int_scale);
+                }
+                in = widened.data();
+            }
+            tone_bank->process(block.sample_offset, in, block_size, result.tones);
+        }
+        
+        // Burst extraction needs every sample in stream order (it is its own
+        // gate), so the block's samples travel with the result
+        if (burst_segmenter) {
+            if (block.format == SampleFormat::SC8) {
+                result.samples.resize(block.size());
+                unpack_sc8(block.samples_sc8.data(), block.size(), result.samples.data(), block.int_scale);
+            } else {
+                result.samples = std::move(block.samples);
+            }
+        }
+        
+        if (run_heavy) {
+            heavy_cpu_ns += static_cast<uint64_t>((thread_cpu_seconds() - heavy_start) * 1e9);
+            heavy_blocks++;
         }
         
-        // Compute average power across all samples in block
-        // Normalizes for block size and gives power per sample
-        double avg_power = sum_power / block.samples.size();
+        const double cpu_samples_done = block_sizer ? thread_cpu_seconds() : 0.0;
         
         // ====================================================================
         //      THREAD-SAFE RESULTS REPORTING
         // ====================================================================
-        // Display analysis results with proper formatting and thread identification
-        {
-            // Configure floating-point output format for consistent display
-            std::cout << std::fixed << std::setprecision(8);
-            
-            // Display comprehensive processing results
-            std::cout << "[Thread " << thread_id << "] "                    // Thread identification
-                      << "Block #" << std::setw(6) << block.block_number  // Block sequence number
-                      << " | Avg Power: " << std::setw(14) << avg_power   // Signal power level
-                      << " | Queue Size: " << sample_queue.size()         // Queue backlog status
-                      << std::endl;
+        // Ordered mode prints from the reorder buffer in block order;
+        // otherwise results are printed as soon as they are ready
+        if (ordered_results) {
+            ordered_results->push(result.block_number, std::move(result));
+        } else {
+            print_block_result(result);
+            track_tones(result);
+        }
+        
+        // End-to-end latency of the block's first sample: fill + queue + work
+        const auto done = std::chrono::steady_clock::now();
+        const uint64_t latency_ns = static_cast<uint64_t>(
+            (block_size / stream_rate.load(std::memory_order_relaxed) +
+             std::chrono::duration<double>(done - block.timestamp).count()) * 1e9);
+        latency_sum_ns.fetch_add(latency_ns, std::memory_order_relaxed);
+        latency_blocks.fetch_add(1, std::memory_order_relaxed);
+        latency_histogram.record(latency_ns / 1e9);
+        last_block_power.store(power.avg_power, std::memory_order_relaxed);
+        if (options.latency_bound_ms > 0.0 && latency_ns > options.latency_bound_ms * 1e6) {
+            latency_over_bound.fetch_add(1, std::memory_order_relaxed);
+        }
+        samples_processed.fetch_add(block_size, std::memory_order_relaxed);
+        if (power_sketches) {
+            power_sketches->record(thread_id, power.avg_power);
+        }
+        if (history) {
+            // Filed under the second the block completed in: a block that
+            // waited in a backlog longer than GRACE_S is still accepted, and
+            // the episode shows up when the latency was paid
+            const double completed = unix_seconds();
+            history->record(HISTORY_POWER, completed, power.avg_power);
+            history->record(HISTORY_LATENCY, completed, latency_ns / 1e6);
+            history->record(HISTORY_QUEUE, completed, static_cast<double>(queue_depth));
+        }
+        uint64_t seen_max = latency_max_ns.load(std::memory_order_relaxed);
+        while (latency_ns > seen_max &&
+               !latency_max_ns.compare_exchange_weak(seen_max, latency_ns, std::memory_order_relaxed)) {}
+        
+        // Per-sample vs fixed cost of the block, for dynamic sizing
+        if (block_sizer) {
+            const double cpu_done = thread_cpu_seconds();
+            block_sizer->record(block_size, queue_age,
+                                std::chrono::duration<double>(done - work_start).count(),
+                                cpu_samples_done - cpu_start, cpu_done - cpu_samples_done);
         }
         
         // Update local processing statistics
         blocks_processed++;
+        heartbeat.beat();
     }
+    heartbeat.set_state(retired ? ThreadState::RETIRED : ThreadState::STOPPED);
     
     // ========================================================================
     //  THREAD SHUTDOWN REPORTING
     // ========================================================================
-    std::cout << "Processing thread " << thread_id 
-              << " stopped. Processed " << blocks_processed << " blocks" << std::endl;
+    std::cout << "Processing thread " << thread_id << (retired ? " retired" : " stopped")
+              << ". Processed " << blocks_processed << " blocks" << std::endl;
+}
+
+// ============================================================================
+//          CONTROL SOCKET COMMANDS
+// ============================================================================
+
+// Start of the program, for rates in the live statistics
+const std::chrono::steady_clock::time_point program_start = std::chrono::steady_clock::now();
+
+/**
+ * live_stats(): Answer of the "stats" command, one "name value" per line
+ */
+std::string live_stats() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    const double cpu = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6
+                     + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+    const double uptime = std::chrono::duration<double>(std::chrono::steady_clock::now() - program_start).count();
+    const uint64_t measured = latency_blocks.load();
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2) << "ok\n"
+        << "uptime_s " << uptime << "\n"
+        << "rate_hz " << std::setprecision(0) << stream_rate.load() << "\n"
+        << "workers " << worker_pool.size() << "\n"
+        << "verbosity " << verbosity_name(verbosity.load()) << "\n"
+        << "blocks_produced " << blocks_produced.load() << "\n"
+        << "blocks_processed " << measured << "\n"
+        << "queue_depth " << sample_queue.size() << "\n"
+        << "blocks_dropped " << sample_queue.dropped_blocks() << "\n"
+        << "overflows " << overflow_count.load() << "\n"
+        << std::setprecision(3)
+        << "latency_avg_ms " << (measured ? latency_sum_ns.load() / 1e6 / measured : 0.0) << "\n"
+        << "latency_max_ms " << latency_max_ns.load() / 1e6 << "\n"
+        << std::setprecision(1) << "cpu_percent " << (uptime > 0.0 ? 100.0 * cpu / uptime : 0.0);
+    return out.str();
+}
+
+/**
+ * handle_control_command(): Execute one control socket command
+ *
+ *   stats                          live counters (see live_stats())
+ *   workers <N>                    resize the worker pool
+ *   verbosity quiet|events|all     per-block output level
+ *   queue budget <MB>              byte budget (0 = unbounded; not in ordered mode)
+ *   queue lane-wait <ms>           starvation guard of the routine lane
+ *   queue wake <N>                 wake consumers every N blocks
+ *   queue spin <us>                busy-poll before blocking
+ *   retune <freq Hz> [<rate Hz>]   stop, retune, restart (interrupts the data)
+ *   history <series> <s> [tier]    trend of the last <s> seconds (--history;
+ *                                  tier second|minute|hour, default the
+ *                                  finest one that retains the range)
+ *
+ * Everything but retune takes effect between blocks without touching
+ * the stream.
+ * @param words: Command and its arguments
+ * @return: "ok ..." or "error: ..."
+ */
+std::string handle_control_command(const std::vector<std::string>& words) {
+    const std::string& cmd = words[0];
+    const size_t args = words.size() - 1;
+    try {
+        if (cmd == "help") {
+            return "ok commands: stats | workers <N> | verbosity quiet|events|all | queue budget <MB> | "
+                   "queue lane-wait <ms> | queue wake <N> | queue spin <us> | retune <freq Hz> [<rate Hz>] | "
+                   "history power|latency_ms|queue_depth <seconds> [second|minute|hour]";
+        }
+        if (cmd == "stats" && args == 0) {
+            return live_stats();
+        }
+        if (cmd == "workers" && args == 1) {
+            const size_t workers = std::stoul(words[1]);
+            if (workers < 1 || workers > WorkerPool::MAX_WORKERS) return "error: 1 to 64 workers";
+            const size_t before = worker_pool.size();
+            worker_pool.resize(workers, stream_rate.load());
+            std::cout << "[Control] Workers: " << before << " -> " << workers << std::endl;
+            return "ok workers " + std::to_string(workers);
+        }
+        if (cmd == "verbosity" && args == 1) {
+            OutputVerbosity level;
+            if (!parse_verbosity(words[1], level)) return "error: verbosity is quiet, events or all";
+            verbosity.store(level);
+            return std::string("ok verbosity ") + verbosity_name(level);
+        }
+        if (cmd == "queue" && args == 2) {
+            const double value = std::stod(words[2]);
+            if (value < 0.0) return "error: negative value";
+            if (words[1] == "budget") {
+                if (options.ordered) return "error: ordered mode needs a lossless queue";
+                sample_queue.set_byte_budget(static_cast<size_t>(value * 1024 * 1024));
+            } else if (words[1] == "lane-wait" && value > 0.0) {
+                sample_queue.set_max_lane_wait(value / 1000.0);
+            } else if (words[1] == "wake" && value >= 1.0) {
+                sample_queue.set_wake_blocks(static_cast<size_t>(value));
+            } else if (words[1] == "spin") {
+                sample_queue.set_spin(value / 1e6);
+            } else {
+                return "error: queue budget|lane-wait|wake|spin <value>";
+            }
+            std::cout << "[Control] Queue " << words[1] << " = " << words[2] << std::endl;
+            return "ok queue " + words[1] + " " + words[2];
+        }
+        if (cmd == "retune" && (args == 1 || args == 2)) {
+            const double freq = std::stod(words[1]);
+            const double rate = args == 2 ? std::stod(words[2]) : 0.0;
+            if (freq <= 0.0 || rate < 0.0) return "error: frequency and rate must be positive";
+            if (!options.record.empty()) {
+                return "error: the capture header records the start frequency and rate; "
+                       "no retunes while recording";
+            }
+            if (rate > 0.0 && (options.ordered || block_sizer || options.latency_bound_ms > 0.0 ||
+                               !options.tones.empty())) {
+                return "error: ordered mode, dynamic block sizing, the latency bound and tone tracking "
+                       "are set up for the start rate; restart to change it";
+            }
+            std::unique_lock<std::mutex> lock(retune_request.mtx);
+            if (retune_request.pending.load()) return "error: a retune is already in progress";
+            retune_request.freq = freq;
+            retune_request.rate = rate;
+            retune_request.done = false;
+            retune_request.pending.store(true);
+            if (!retune_request.cv.wait_for(lock, std::chrono::seconds(5), [] { return retune_request.done; })) {
+                retune_request.pending.store(false);
+                return "error: the RX thread did not pick up the retune (stream stopped?)";
+            }
+            return retune_request.result;
+        }
+        if (cmd == "history" && (args == 2 || args == 3)) {
+            if (!history) return "error: no trend files (start with --history=<dir>)";
+            const double seconds = std::stod(words[2]);
+            if (seconds <= 0.0) return "error: range must be positive";
+            RollupTier tier = RollupTier::SECOND;
+            if (args == 3 && !parse_rollup_tier(words[3], tier)) return "error: tier is second, minute or hour";
+            while (args == 2 && tier != RollupTier::HOUR &&
+                   seconds > ROLLUP_RESOLUTION[static_cast<size_t>(tier)] * ROLLUP_CAPACITY[static_cast<size_t>(tier)]) {
+                tier = static_cast<RollupTier>(static_cast<uint32_t>(tier) + 1);
+            }
+            const int64_t to = static_cast<int64_t>(std::floor(unix_seconds())) + 1;
+            std::vector<RollupPoint> points;
+            if (!history->query(words[1], tier, to - static_cast<int64_t>(std::ceil(seconds)), to, points)) {
+                return "error: unknown series '" + words[1] + "'";
+            }
+            std::ostringstream out;
+            out << "ok " << points.size() << " " << rollup_tier_name(tier) << " points (start count min mean max)";
+            out << std::setprecision(6);
+            for (const RollupPoint& p : points) {
+                out << "\n" << p.start << " " << p.count << " " << p.min << " " << p.mean << " " << p.max;
+            }
+            return out.str();
+        }
+    } catch (const std::exception&) {
+        return "error: bad number in '" + cmd + "' command";
+    }
+    return "error: unknown command '" + cmd + "' (try help)";
+}
+
+// ============================================================================
+//          BLOCK POWER PERCENTILES
+// ============================================================================
+
+/**
+ * write_power_quantiles(): One percentile line (with its newline)
+ * @param label: What the line covers ("60.0 s", "run")
+ */
+void write_power_quantiles(std::ostream& out, const std::string& label, const KllSketch& sketch) {
+    if (sketch.count() == 0) {
+        out << "[Power Quantiles] " << label << ", no blocks\n";
+        return;
+    }
+    out << "[Power Quantiles] " << label << ", " << sketch.count() << " blocks" << std::fixed << std::setprecision(1);
+    for (double q : POWER_QUANTILES) {
+        const double power = sketch.quantile(q);
+        out << " | p" << static_cast<int>(q * 100 + 0.5) << " ";
+        if (options.dbfs) {
+            out << fast_dbfs(power) << " dBFS";
+        } else {
+            out << fast_db(power) << " dB";
+        }
+    }
+    out << "\n";
+}
+
+/**
+ * report_power_quantiles(): Body of the percentile reporter thread
+ * (--quantiles-s). Every interval, the workers' sketches are swapped for
+ * empty ones and merged; the interval's percentiles are printed (at any
+ * verbosity: they are statistics) and published for the metrics, and the
+ * interval is merged into the run total. The last partial interval is
+ * merged by the final report.
+ */
+void report_power_quantiles() {
+    const auto period = std::chrono::duration<double>(options.quantiles_s);
+    auto interval_start = std::chrono::steady_clock::now();
+    KllSketch interval;
+    while (!stop_signal.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        const auto now = std::chrono::steady_clock::now();
+        if (now - interval_start < period) continue;
+        interval.clear();
+        power_sketches->collect(interval);
+        for (size_t i = 0; i < 4; i++) {
+            interval_power_quantile[i].store(interval.quantile(POWER_QUANTILES[i]), std::memory_order_relaxed);
+        }
+        run_power_sketch.merge(interval);
+        std::ostringstream line, label;
+        label << std::fixed << std::setprecision(1) << std::chrono::duration<double>(now - interval_start).count() << " s";
+        write_power_quantiles(line, label.str(), interval);
+        if (output_sink) output_sink->write(line.str());
+        else std::cout << line.str() << std::flush;
+        interval_start = now;
+    }
+}
+
+// ============================================================================
+//          METRICS ENDPOINT
+// ============================================================================
+
+/**
+ * collect_metrics(): One Prometheus scrape (--metrics-port)
+ * Reads only atomics and kernel clocks; never the queue or worker locks.
+ */
+void collect_metrics(MetricsWriter& out) {
+    out.counter("lab1_blocks_produced_total", "Blocks queued by the RX thread", blocks_produced.load());
+    out.counter("lab1_blocks_processed_total", "Blocks processed by the workers", latency_blocks.load());
+    out.counter("lab1_blocks_dropped_total", "Blocks rejected by the queue byte budget",
+                sample_queue.dropped_blocks());
+    out.counter("lab1_overflows_total", "RX overflow events (samples lost before the host)",
+                overflow_count.load());
+    out.gauge("lab1_queue_depth_blocks", "Blocks waiting in the sample queue", sample_queue.depth());
+    out.gauge("lab1_queue_bytes", "Sample payload bytes waiting in the sample queue", sample_queue.bytes());
+    out.gauge("lab1_workers", "Processing threads in the pool", worker_pool.size());
+    out.gauge("lab1_sample_rate_hz", "Current RX sampling rate", stream_rate.load());
+    out.gauge("lab1_block_power", "Average power of the latest processed block (fc32 units)",
+              last_block_power.load(std::memory_order_relaxed));
+    if (power_sketches) {
+        out.family("lab1_block_power_quantile", "gauge", "Block power percentiles of the latest --quantiles-s interval");
+        for (size_t i = 0; i < 4; i++) {
+            std::ostringstream label;
+            label << "quantile=\"" << POWER_QUANTILES[i] << "\"";
+            out.sample("lab1_block_power_quantile", interval_power_quantile[i].load(std::memory_order_relaxed),
+                       label.str());
+        }
+    }
+    out.summary("lab1_block_latency_seconds", "End-to-end block latency (fill + queue wait + work)",
+                latency_histogram);
+    
+    out.family("lab1_thread_cpu_seconds_total", "counter", "CPU time per thread");
+    thread_clocks.for_each([&out](const std::string& role, int id, double seconds) {
+        out.sample("lab1_thread_cpu_seconds_total", seconds,
+                   "role=\"" + role + "\",id=\"" + std::to_string(id) + "\"");
+    });
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    out.counter("lab1_process_cpu_seconds_total", "CPU time of the whole process (user + system)",
+                usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6);
 }
 
 // Main Function
@@ -528,40 +2865,241 @@ int main(int argc, char* argv[]) {
     int num_threads = 2;  // Default 2 processing threads
     double run_time = 10.0;  // Default run for 10 seconds
     
-    // Parse optional command line arguments for runtime configuration
-    if (argc > 1) {
-        sampling_rate = std::stod(argv[1]);  // Convert string to double
+    // A profile only sets defaults, so apply it before the other flags
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--profile=", 0) == 0 && parse_option(arg)) {
+            apply_profile(options.profile);
+        }
+    }
+    
+    // Split arguments into positional values and --name=value options
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) == 0) {
+            if (!parse_option(arg)) {
+                std::cerr << "Invalid option: " << arg << std::endl;
+                std::cerr << "Options: --wire=sc16|sc8 --sc8-peak=<0..1> --queue-budget-mb=<MB> --shed-age-ms=<ms>"
+                          << " --flag-db=<dB> --lane-max-wait-ms=<ms> --ordered --taps=<N>"
+                          << " --cutoff=<0..0.5> --mix-hz=<Hz> --conv=auto|direct|fft"
+                          << " --out-rate=<Hz> --iq-correct --squelch-db=<dB> --noise-window-s=<s> --burst-db=<dB>"
+                          << " --record=<file> --append --replay=<file> --watchdog=<s>"
+                          << " --watchdog-restart --stall-at=<s> --target-latency-ms=<ms>"
+                          << " --max-overhead=<0..1> --profile=low-latency|high-throughput|low-cpu"
+                          << " --block=<samples> --spin-us=<us> --pop-batch=<N> --output-flush-ms=<ms>"
+                          << " --pin --stats-stride=<N> --wake-blocks=<N> --latency-bound-ms=<ms>"
+                          << " --timer-slack-us=<us> --verbosity=quiet|events|all --control=<socket>"
+                          << " --metrics-port=<port> --history=<dir> --quantiles-s=<s>"
+                          << " --tones=<Hz>[,<Hz>...] --dbfs" << std::endl;
+                return 1;
+            }
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    
+    // Parse optional positional arguments for runtime configuration
+    try {
+        if (positional.size() > 0) sampling_rate = std::stod(positional[0]);
+        if (positional.size() > 1) num_threads = std::stoi(positional[1]);
+        if (positional.size() > 2) run_time = std::stod(positional[2]);
+    } catch (const std::exception&) {
+        std::cerr << "Invalid arguments: expected [sampling_rate] [num_threads] [run_time_seconds]" << std::endl;
+        return 1;
+    }
+    if (!(sampling_rate > 0.0) || !(run_time > 0.0)) {
+        std::cerr << "Sampling rate and run time must be positive" << std::endl;
+        return 1;
+    }
+    if (num_threads < 1 || static_cast<size_t>(num_threads) > WorkerPool::MAX_WORKERS) {
+        std::cerr << "Number of processing threads must be 1.." << WorkerPool::MAX_WORKERS << std::endl;
+        return 1;
+    }
+    if (positional.size() > 0) {
         std::cout << "Using sampling rate: " << sampling_rate/1e6 << " MHz" << std::endl;
     }
-    if (argc > 2) {
-        num_threads = std::stoi(argv[2]);    // Convert string to integer
+    if (positional.size() > 1) {
         std::cout << "Using " << num_threads << " processing threads" << std::endl;
     }
-    if (argc > 3) {
-        run_time = std::stod(argv[3]);       // Convert string to double
+    if (positional.size() > 2) {
         std::cout << "Running for " << run_time << " seconds" << std::endl;
     }
     
     // Display usage information and current configuration
-    if (argc == 1) {
+    if (positional.empty()) {
         std::cout << "\n=== SDR Multi-threaded Receiver ===" << std::endl;
-        std::cout << "Usage: " << argv[0] << " [sampling_rate] [num_threads] [run_time_seconds]" << std::endl;
+        std::cout << "Usage: " << argv[0] << " [sampling_rate] [num_threads] [run_time_seconds] [--options]" << std::endl;
         std::cout << "Example: " << argv[0] << " 5e6 4 30  (5MHz, 4 threads, 30 seconds)" << std::endl;
+        std::cout << "Example: " << argv[0] << " 40e6 4 30 --wire=sc8  (8-bit wire format)" << std::endl;
         std::cout << "Using defaults: rate=" << sampling_rate/1e6 << "MHz, threads=" << num_threads 
                   << ", time=" << run_time << "s" << std::endl;
     }
     
+    // Ordered mode needs every block: a dropped block would stall the
+    // reorder buffer and break the overlap chain
+    if (options.ordered) {
+        if (options.queue_budget_mb > 0.0) {
+            std::cerr << "--ordered cannot be combined with --queue-budget-mb (blocks may be dropped)" << std::endl;
+            return 1;
+        }
+        ordered_results.reset(new ReorderBuffer<BlockResult>(emit_ordered_result));
+        std::cout << "Ordered mode: " << options.taps << "-tap lowpass (cutoff "
+                  << options.cutoff << " x rate, "
+                  << convolution_method_name(choose_convolution(options.taps, options.conv))
+                  << " convolution, FFT from " << FFT_CROSSOVER_TAPS << " taps), mixer "
+                  << options.mix_hz / 1e3 << " kHz" << std::endl;
+    }
+    
+    if (options.iq_correct) {
+        iq_corrector.reset(new IqCorrector());
+    }
+    noise_floor.reset(new NoiseFloorEstimator(options.noise_window_s));
+    if (options.squelch_db > 0.0) {
+        squelch.reset(new Squelch(options.squelch_db));
+    }
+    if (options.burst_db > 0.0) {
+        burst_segmenter.reset(new BurstSegmenter(options.burst_db, options.burst_db - 3.0));
+        burst_floor.reset(new NoiseFloorEstimator(options.noise_window_s));
+    }
+    if (!options.tones.empty()) {
+        for (double hz : options.tones) {
+            if (std::abs(hz) >= sampling_rate / 2.0) {
+                std::cerr << "--tones: " << hz << " Hz is outside +-" << sampling_rate / 2.0 << " Hz" << std::endl;
+                return 1;
+            }
+        }
+        tone_tracker.reset(new ToneTracker(options.tones.size()));
+        std::cout << "Tone bins: " << options.tones.size() << " Goertzel bins per block";
+        if (options.tones.size() > GOERTZEL_CROSSOVER_BINS) {
+            std::cout << " (above " << GOERTZEL_CROSSOVER_BINS << " bins one FFT of the block would be cheaper)";
+        }
+        std::cout << std::endl;
+    }
+#ifndef SIMULATE_MODE
+    if (!options.replay.empty() || options.stall_at > 0.0) {
+        std::cerr << "--replay and --stall-at are only available in the simulation build" << std::endl;
+        return 1;
+    }
+#endif
+    if (options.watchdog_restart && options.watchdog_s <= 0.0) {
+        std::cerr << "--watchdog-restart needs the watchdog (--watchdog=<s> > 0)" << std::endl;
+        return 1;
+    }
+    watchdog.configure(options.watchdog_s, options.watchdog_restart);
+    
+    // Dynamic block sizing: one target at a time, fixed-size capture chunks
+    if (options.target_latency_ms > 0.0 || options.max_overhead > 0.0) {
+        if (options.target_latency_ms > 0.0 && options.max_overhead > 0.0) {
+            std::cerr << "--target-latency-ms and --max-overhead are alternative targets" << std::endl;
+            return 1;
+        }
+        if (!options.record.empty()) {
+            std::cerr << "--record needs fixed-size blocks (no --target-latency-ms / --max-overhead)" << std::endl;
+            return 1;
+        }
+        block_sizer.reset(options.target_latency_ms > 0.0
+            ? new BlockSizeController(BlockTarget::LATENCY, options.target_latency_ms / 1000.0, sampling_rate)
+            : new BlockSizeController(BlockTarget::OVERHEAD, options.max_overhead, sampling_rate));
+    }
+    
+    // Starvation guard for the routine lane
+    sample_queue.set_max_lane_wait(options.lane_max_wait_ms / 1000.0);
+    sample_queue.set_spin(options.spin_us / 1e6);
+    
+    // Coalesced wakeups: a block's fill plus its notification delay must
+    // leave LATENCY_WORK_RESERVE of the bound for the work
+    const double wake_budget = options.latency_bound_ms / 1000.0 * (1.0 - LATENCY_WORK_RESERVE);
+    if (options.latency_bound_ms > 0.0 && !block_sizer && options.block_samples / sampling_rate >= wake_budget) {
+        std::cerr << "--latency-bound-ms=" << options.latency_bound_ms << " is below the block fill time ("
+                  << 1e3 * options.block_samples / sampling_rate << " ms) plus "
+                  << 100.0 * LATENCY_WORK_RESERVE << "% for the work; use smaller blocks (--block)" << std::endl;
+        return 1;
+    }
+    sample_queue.set_wakeup_coalescing(options.wake_blocks, wake_budget, sampling_rate);
+    
+    // Inherited by every thread created from here on
+    if (options.timer_slack_us > 0.0 && !set_timer_slack(options.timer_slack_us / 1e6)) {
+        std::cerr << "Cannot set timer slack (continuing with the default)" << std::endl;
+    }
+    
+    verbosity.store(options.verbosity);
+    stream_rate.store(sampling_rate);
+    
+    // One sketch per worker id (ids start at 1)
+    if (options.quantiles_s > 0.0) {
+        power_sketches.reset(new SketchSlots(WorkerPool::MAX_WORKERS + 1));
+    }
+    
+    // Trend files, continued from earlier runs in the same directory
+    if (!options.history.empty()) {
+        history.reset(new RollupStore());
+        std::string error;
+        if (!history->open(options.history, HISTORY_NAMES, error)) {
+            std::cerr << "Cannot open trend files: " << error << std::endl;
+            return 1;
+        }
+    }
+    
+    // Result lines written in bulk by the output thread
+    if (options.output_flush_ms > 0.0) {
+        output_sink.reset(new OutputSink(std::cout, options.output_flush_ms / 1000.0));
+    }
+    
+    // Optional byte budget for the sample queue
+    if (options.queue_budget_mb > 0.0) {
+        size_t budget = static_cast<size_t>(options.queue_budget_mb * 1024 * 1024);
+        sample_queue.set_byte_budget(budget);
+        
+        // Backlog the budget can absorb: fc32 (8 B/sample) up to the sc16
+        // watermark, then sc16 (4 B) up to the sc8 watermark, then sc8 (2 B)
+        double fc32_seconds = budget / (sampling_rate * 8.0);
+        double compacted_seconds = budget * (SampleQueue::SC16_WATERMARK / 8.0
+            + (SampleQueue::SC8_WATERMARK - SampleQueue::SC16_WATERMARK) / 4.0
+            + (1.0 - SampleQueue::SC8_WATERMARK) / 2.0) / sampling_rate;
+        std::cout << "Queue budget: " << options.queue_budget_mb << " MB (backlog "
+                  << std::setprecision(2) << fc32_seconds << " s at fc32, "
+                  << compacted_seconds << " s with compaction)" << std::endl;
+    }
+    
     // ========================================================================
     //       USRP HARDWARE INITIALIZATION
     // ========================================================================
     // Initialize connection to USRP hardware (or simulation mode)
     std::cout << "\n=== Creating USRP device ===" << std::endl;
     std::string device_args = "";  // Empty for default device discovery
-    uhd::usrp::multi_usrp::sptr usrp = uhd::usrp::multi_usrp::make(device_args);
+#ifdef SIMULATE_MODE
+    if (!options.replay.empty()) {
+        device_args = "replay=" + options.replay;   // Mock radio plays back a capture
+    }
+    if (options.stall_at > 0.0) {
+        device_args += (device_args.empty() ? "" : ",") + std::string("stall_at=") + std::to_string(options.stall_at);
+    }
+#endif
+    uhd::usrp::multi_usrp::sptr usrp;
+    try {
+        usrp = uhd::usrp::multi_usrp::make(device_args);
+    } catch (const std::exception& e) {
+        std::cerr << "Cannot create USRP device: " << e.what() << std::endl;
+        return 1;
+    }
     
     // Display detailed device information for verification
     std::cout << "Using device: " << usrp->get_pp_string() << std::endl;
     
+    // Rate, carrier and gain are applied before any thread starts, so a
+    // setup failure ends the run with an error instead of an idle stream
+    if (!configure_receiver(usrp, sampling_rate)) {
+        return 1;
+    }
+    
+    // Capture container header records what the hardware actually applied
+    if (!options.record.empty() &&
+        !open_capture_writer(usrp, options.wire_format == WireFormat::SC8,
+                             static_cast<float>(options.sc8_peak / SC8_FULL_SCALE))) {
+        return 1;
+    }
+    
     // ====================================================================
     //      THREAD CREATION AND LAUNCH
     // ====================================================================
@@ -575,10 +3113,47 @@ int main(int argc, char* argv[]) {
     
     // Launch multiple signal processing threads (consumers)
     // Each thread processes sample blocks independently for parallel analysis
-    for (int i = 0; i < num_threads; i++) {
-        threads.emplace_back(processing_thread, i + 1);  // Thread IDs start at 1
+    worker_pool.resize(num_threads, sampling_rate);   // Thread IDs start at 1
+    
+    // Runtime commands (--control)
+    ControlServer control;
+    if (!options.control.empty()) {
+        std::string error;
+        if (control.open(options.control, error)) {
+            threads.emplace_back([&control] { control.run(stop_signal, handle_control_command); });
+        } else {
+            std::cerr << "Cannot open control socket " << options.control << ": " << error << std::endl;
+        }
     }
     
+    // Prometheus scrapes (--metrics-port)
+    MetricsServer metrics;
+    if (options.metrics_port > 0) {
+        std::string error;
+        if (metrics.open(options.metrics_port, error)) {
+            threads.emplace_back([&metrics] { metrics.run(stop_signal, collect_metrics); });
+        } else {
+            std::cerr << "Cannot serve metrics on port " << options.metrics_port << ": " << error << std::endl;
+        }
+    }
+    
+    // Block power percentiles per interval (--quantiles-s)
+    if (power_sketches) {
+        threads.emplace_back(report_power_quantiles);
+    }
+    
+    // Sealed seconds rolled into the trend files (--history)
+    if (history) {
+        threads.emplace_back([] { history->run(stop_signal); });
+    }
+    
+    // Low-frequency stall checks over the threads' heartbeats
+    threads.emplace_back([] {
+        watchdog.run(stop_signal, [](size_t& depth, double& oldest_age) {
+            sample_queue.backlog(depth, oldest_age);
+        });
+    });
+    
     // ====================================================================
     //       SYSTEM MONITORING AND RUNTIME CONTROL
     // ====================================================================
@@ -587,10 +3162,51 @@ int main(int argc, char* argv[]) {
     std::cout << "\n=== Multi-threaded SDR System Active ===" << std::endl;
     std::cout << "Carrier Frequency: " << RX_FREQ/1e9 << " GHz" << std::endl;
     std::cout << "Sampling Rate: " << sampling_rate/1e6 << " MHz" << std::endl;
-    std::cout << "Samples per Block: " << SAMPLES_PER_BLOCK << std::endl;
+    std::cout << "Wire Format: " << wire_format_name(options.wire_format) << std::endl;
+    std::cout << "Samples per Block: " << options.block_samples;
+    if (block_sizer) {
+        std::cout << " (dynamic, " << BlockSizeController::MIN_BLOCK << ".." << BlockSizeController::MAX_BLOCK
+                  << ", target ";
+        if (block_sizer->target_kind() == BlockTarget::LATENCY) {
+            std::cout << options.target_latency_ms << " ms latency)";
+        } else {
+            std::cout << options.max_overhead * 100.0 << "% overhead)";
+        }
+    }
+    std::cout << std::endl;
     std::cout << "Processing Threads: " << num_threads << std::endl;
     std::cout << "Runtime Duration: " << run_time << " seconds" << std::endl;
     std::cout << "Thread Architecture: 1 Producer + " << num_threads << " Consumers" << std::endl;
+    std::cout << "Profile: " << profile_name(options.profile) << " (" << options.block_samples
+              << "-sample blocks, ";
+    if (options.spin_us > 0.0) std::cout << "busy-poll " << options.spin_us << " us";
+    else std::cout << "blocking waits";
+    std::cout << ", " << options.pop_batch << (options.pop_batch > 1 ? " blocks" : " block") << " per pop, ";
+    if (output_sink) std::cout << "bulk output every " << options.output_flush_ms << " ms";
+    else std::cout << "line-by-line output";
+    if (options.wake_blocks > 1) std::cout << ", wake every " << options.wake_blocks << " blocks";
+    if (options.latency_bound_ms > 0.0) std::cout << ", latency bound " << options.latency_bound_ms << " ms";
+    if (options.timer_slack_us > 0.0) std::cout << ", timer slack " << options.timer_slack_us << " us";
+    std::cout << (options.pin ? ", pinned threads" : "") << ", ";
+    if (options.stats_stride > 1) std::cout << "power from 1/" << options.stats_stride << " of the samples)";
+    else std::cout << "exact power)";
+    std::cout << std::endl;
+    if (watchdog.enabled()) {
+        std::cout << "Watchdog: " << options.watchdog_s << " s stall timeout"
+                  << (options.watchdog_restart ? ", stream restart on RX stalls" : "") << std::endl;
+    }
+    if (options.metrics_port > 0) {
+        std::cout << "Metrics: http://127.0.0.1:" << options.metrics_port << "/metrics" << std::endl;
+    }
+    if (history) {
+        std::cout << "History: " << options.history << " (per second " << ROLLUP_CAPACITY[0] / 3600
+                  << " h, per minute " << ROLLUP_CAPACITY[1] / 1440 << " days, per hour "
+                  << ROLLUP_CAPACITY[2] / 24 << " days; " << RollupFile::file_size() / 1024
+                  << " KB per series)" << std::endl;
+    }
+    if (control.listening()) {
+        std::cout << "Control socket: " << options.control << " (send \"help\")" << std::endl;
+    }
     std::cout << "=========================================\n" << std::endl;
     
     // Allow system to run for specified duration
@@ -605,17 +3221,46 @@ int main(int argc, char* argv[]) {
     
     // Set atomic stop signal to notify all threads to terminate
     stop_signal.store(true);
+    watchdog.stop();
     
-    // Wake up any threads blocked on queue operations
-    sample_queue.notify_all();
-    
-    // Wait for all threads to complete their current operations and exit
+    // The RX thread may still be inside recv() and push one more block:
+    // only once it has exited may the workers leave on an empty queue
     std::cout << "Waiting for all threads to complete..." << std::endl;
-    for (auto& t : threads) {
-        t.join();  // Block until thread terminates
+    threads.front().join();     // RX streamer, launched first
+    producer_done.store(true);
+    sample_queue.notify_all();  // Wake consumers blocked on the empty queue
+    
+    // Workers drain what is queued; the service threads leave on stop_signal
+    for (size_t i = 1; i < threads.size(); i++) {
+        threads[i].join();  // Block until thread terminates
     }
+    worker_pool.join_all();
     std::cout << "All threads terminated successfully." << std::endl;
     
+    // The writers are gone: seal the last seconds into the trend files
+    if (history) {
+        history->close();
+    }
+    
+    // A burst still open at shutdown is emitted as is
+    if (burst_segmenter) {
+        burst_segmenter->flush(completed_bursts);
+        for (const auto& burst : completed_bursts) {
+            print_burst(burst);
+        }
+        completed_bursts.clear();
+    }
+    
+    // Blocks of the last partial interval count toward the run percentiles
+    if (power_sketches) {
+        power_sketches->collect(run_power_sketch);
+    }
+    
+    // Everything still buffered goes out before the statistics
+    if (output_sink) {
+        output_sink->stop();
+    }
+    
     // ====================================================================
     //      PERFORMANCE ANALYSIS AND FINAL REPORTING
     // ====================================================================
@@ -623,20 +3268,171 @@ int main(int argc, char* argv[]) {
     std::cout << "\n=== Final Performance Statistics ===" << std::endl;
     std::cout << "Total Overflow Events: " << overflow_count.load() << std::endl;
     
+    // CPU cost of the run (user + system time over wall time, all threads)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    double cpu_seconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6
+                       + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+    std::cout << "Wire Format: " << wire_format_name(options.wire_format)
+              << " (link load " << std::fixed << std::setprecision(1)
+              << sampling_rate * wire_bytes_per_sample(options.wire_format) / 1e6 << " MB/s)" << std::endl;
+    std::cout << "CPU Time: " << std::setprecision(2) << cpu_seconds << " s ("
+              << std::setprecision(1) << 100.0 * cpu_seconds / run_time << "% of one core)" << std::endl;
+    std::cout << "Peak Memory: " << usage.ru_maxrss << " KB" << std::endl;
+    
+    // Measured numbers of the profile in effect
+    const uint64_t measured = latency_blocks.load();
+    std::cout << "Profile " << profile_name(options.profile) << ": latency avg "
+              << std::setprecision(2) << (measured ? latency_sum_ns.load() / 1e6 / measured : 0.0)
+              << " ms, max " << latency_max_ns.load() / 1e6 << " ms (fill + queue + work";
+    if (options.latency_bound_ms > 0.0) {
+        std::cout << "; bound " << options.latency_bound_ms << " ms, " << latency_over_bound.load() << " blocks over";
+    }
+    std::cout << ") | throughput "
+              << samples_processed.load() / run_time / 1e6 << " MS/s | CPU " << std::setprecision(1)
+              << 100.0 * cpu_seconds / run_time << "% | context switches "
+              << usage.ru_nvcsw + usage.ru_nivcsw << " (" << usage.ru_nvcsw << " voluntary), "
+              << std::setprecision(0) << (usage.ru_nvcsw + usage.ru_nivcsw) / run_time << "/s";
+    if (output_sink) {
+        std::cout << " | output " << output_sink->lines_written() << " lines in "
+                  << output_sink->flushes() << " writes";
+    }
+    std::cout << std::endl;
+    sample_queue.print_stats();
+    if (options.shed_age_ms > 0.0 || options.stats_stride > 1) {
+        std::cout << "Approximate (subsampled) blocks: " << approximate_count.load() << std::endl;
+    }
+    if (ordered_results) {
+        std::cout << "Ordered output: " << ordered_results->next_sequence() << " blocks in order, peak "
+                  << ordered_results->peak_pending() << " held for reordering, "
+                  << ordered_results->pending() << " unreleased at shutdown" << std::endl;
+    }
+    if (iq_corrector) {
+        IqEstimates iq = iq_corrector->estimates();
+        std::cout << "IQ correction: DC " << std::setprecision(4) << iq.dc.real()
+                  << (iq.dc.imag() < 0 ? " - j" : " + j") << std::abs(iq.dc.imag())
+                  << ", gain " << std::setprecision(2) << iq.gain_db << " dB, phase "
+                  << iq.phase_deg << " deg (front-end image rejection "
+                  << std::setprecision(1) << iq.image_rejection_db << " dB, "
+                  << iq.blocks << " blocks)" << std::endl;
+    }
+    std::cout << "Noise Floor: " << std::setprecision(1)
+              << 10.0 * std::log10(std::max(noise_floor->noise_floor(), 1e-30)) << " dB (minimum statistics over "
+              << options.noise_window_s << " s of " << NOISE_SEGMENTS << " sub-blocks per block)" << std::endl;
+    if (squelch) {
+        // CPU saved: gated blocks times the measured heavy-stage cost per block
+        SquelchStats sq = squelch->snapshot();
+        double heavy_seconds = heavy_cpu_ns.load() / 1e9;
+        double per_block = heavy_blocks.load() ? heavy_seconds / heavy_blocks.load() : 0.0;
+        double saved = per_block * sq.gated;
+        std::cout << "Squelch: " << sq.gated << "/" << sq.blocks << " blocks gated ("
+                  << std::setprecision(1) << (sq.blocks ? 100.0 * sq.gated / sq.blocks : 0.0)
+                  << "%), noise floor " << 10.0 * std::log10(std::max(sq.noise_floor, 1e-30))
+                  << " dB, threshold +" << options.squelch_db << " dB" << std::endl;
+        std::cout << "Heavy stages: " << std::setprecision(3) << heavy_seconds << " s CPU on "
+                  << heavy_blocks.load() << " blocks (" << std::setprecision(1) << per_block * 1e6
+                  << " us/block), est. " << std::setprecision(3) << saved << " s CPU saved ("
+                  << std::setprecision(1) << (heavy_seconds + saved > 0.0 ? 100.0 * saved / (heavy_seconds + saved) : 0.0)
+                  << "% of heavy-stage work)" << std::endl;
+    }
+    if (burst_segmenter) {
+        uint64_t total = burst_segmenter->total_samples();
+        uint64_t kept = burst_segmenter->burst_samples();
+        std::cout << "Bursts: " << burst_segmenter->bursts() << " records, " << kept << " of "
+                  << total << " samples kept (" << std::setprecision(1)
+                  << (kept ? static_cast<double>(total) / kept : 0.0) << "x reduction), pool "
+                  << burst_segmenter->pool().buffers_allocated() << " buffers allocated / "
+                  << burst_segmenter->pool().buffers_reused() << " reused" << std::endl;
+    }
+    if (tone_tracker) {
+        // Offsets are only measured across consecutive blocks
+        const double rate = stream_rate.load();
+        std::lock_guard<std::mutex> lock(tone_tracker_mutex);
+        for (size_t k = 0; k < options.tones.size(); k++) {
+            const ToneTracker::Track& track = tone_tracker->track(k);
+            std::cout << "Tone " << std::setprecision(1) << options.tones[k] << " Hz: "
+                      << 10.0 * std::log10(std::max(track.power, 1e-30)) << " dB smoothed, offset ";
+            if (track.offset_updates > 0) {
+                std::cout << std::showpos << track.offset * rate << std::noshowpos << " Hz";
+            } else {
+                std::cout << "n/a";
+            }
+            std::cout << " (" << tone_tracker->updates() << " blocks, " << track.offset_updates
+                      << " consecutive pairs)" << std::endl;
+        }
+    }
+    if (capture_writer) {
+        bool closed = capture_writer->close();
+        std::cout << "Capture: " << capture_writer->chunks() << " chunks ("
+                  << std::setprecision(1) << capture_writer->bytes() / 1e6 << " MB) in "
+                  << options.record << (closed ? "" : " [WRITE ERROR - index may be missing]")
+                  << "; inspect with ./capture_tool info " << options.record << std::endl;
+    }
+    if (block_sizer) {
+        const BlockSizeDecision& d = block_sizer->last_decision();
+        std::cout << "Block size: " << block_sizer->size_changes() << " changes, range "
+                  << block_sizer->smallest_size() << ".." << block_sizer->largest_size() << " samples, last "
+                  << d.size << " (latency " << std::setprecision(2) << d.latency_s * 1e3 << " ms, queue wait "
+                  << d.wait_s * 1e3 << " ms, CPU " << d.fixed_s * 1e6 << " us/block + "
+                  << d.per_sample_s * 1e9 << " ns/sample, overhead " << std::setprecision(1)
+                  << d.overhead * 100.0 << "%)" << std::endl;
+    }
+    if (watchdog.enabled()) {
+        std::cout << "Watchdog: " << watchdog.stalls() << " stalls detected, "
+                  << watchdog.restarts_requested() << " stream restarts" << std::endl;
+    }
+    if (power_sketches) {
+        write_power_quantiles(std::cout, "run", run_power_sketch);
+        std::cout << "  (KLL sketches: " << run_power_sketch.items() << " items kept, rank error ~"
+                  << std::setprecision(1) << 170.0 / KllSketch::K << "%)" << std::endl;
+    }
+    if (history) {
+        std::cout << "History: " << history->sealed_seconds() << " seconds rolled up into "
+                  << options.history << " (" << history->rejected() << " values too late or early); "
+                  << "inspect with ./capture_tool trend " << options.history << "/power.rollup" << std::endl;
+    }
+    if (resampler) {
+        std::cout << "Resampler: " << resampler->interpolation() << "/" << resampler->decimation()
+                  << ", " << resampler->total_in() << " samples in, "
+                  << resampler->total_out() << " out" << std::endl;
+    }
+    
+    // Every block the RX thread queued must have been processed or dropped
+    // by the byte budget; any other difference was lost at shutdown
+    const uint64_t produced = blocks_produced.load();
+    const uint64_t budget_dropped = sample_queue.dropped_blocks();
+    
+    // A control socket retune may have changed the rate since the start
+    const double final_rate = stream_rate.load();
+    std::ostringstream rate_text;
+    rate_text << std::fixed << std::setprecision(1) << final_rate / 1e6 << " MHz sampling rate";
+    if (final_rate != sampling_rate) {
+        rate_text << " (retuned from " << sampling_rate / 1e6 << " MHz during the run)";
+    }
+    
     // Analyze system performance and provide feedback
     if (overflow_count.load() > 0) {
         std::cout << "\n⚠ PERFORMANCE WARNING:" << std::endl;
         std::cout << "  - " << overflow_count.load() << " overflow events detected" << std::endl;
-        std::cout << "  - Data loss occurred at " << sampling_rate/1e6 << " MHz sampling rate" << std::endl;
+        std::cout << "  - Data loss occurred at " << rate_text.str() << std::endl;
         std::cout << "  - System cannot keep up with current data rate" << std::endl;
         std::cout << "\n🛠 OPTIMIZATION RECOMMENDATIONS:" << std::endl;
-        std::cout << "  - Reduce sampling rate (try " << sampling_rate/2e6 << " MHz)" << std::endl;
+        std::cout << "  - Reduce sampling rate (try " << final_rate/2e6 << " MHz)" << std::endl;
         std::cout << "  - Increase number of processing threads" << std::endl;
         std::cout << "  - Optimize signal processing algorithms" << std::endl;
+    } else if (produced != measured + budget_dropped) {
+        std::cout << "\n⚠ SHUTDOWN WARNING:" << std::endl;
+        std::cout << "  - " << produced << " blocks received, " << measured << " processed, "
+                  << budget_dropped << " dropped by the queue budget" << std::endl;
+        std::cout << "  - Blocks were lost between the queue and the workers" << std::endl;
     } else {
         std::cout << "\n✅ PERFORMANCE SUCCESS:" << std::endl;
-        std::cout << "  - No data loss at " << sampling_rate/1e6 << " MHz sampling rate" << std::endl;
-        std::cout << "  - System successfully processed all RF data" << std::endl;
+        std::cout << "  - No data loss at " << rate_text.str() << std::endl;
+        std::cout << "  - System processed all " << produced << " received blocks";
+        if (budget_dropped > 0) {
+            std::cout << " (" << budget_dropped << " dropped by the queue budget)";
+        }
+        std::cout << std::endl;
         std::cout << "  - Multi-threading architecture performed optimally" << std::endl;
         std::cout << "  - Ready for higher sampling rates or more complex processing" << std::endl;
     }
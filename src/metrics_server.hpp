@@ -0,0 +1,316 @@
+/*
+ * EEL6528 Lab 1: Prometheus metrics endpoint on localhost
+ *
+ * GET http://127.0.0.1:<port>/metrics returns the program's counters in
+ * the Prometheus text exposition format (version 0.0.4), so the receivers
+ * can be scraped like every other service.
+ *
+ * NO HOT-PATH COST:
+ * A scrape only reads values the threads already publish with relaxed
+ * atomics (counters, gauges, histogram buckets) plus each registered
+ * thread's CPU clock, which the kernel keeps (pthread_getcpuclockid). It
+ * never takes the locks of the sample queue or the workers; the scraped
+ * values are a snapshot that may be a few blocks apart from each other.
+ *
+ * PIECES:
+ * - LatencyHistogram: log-spaced buckets with atomic counters; record()
+ *   is one fetch_add. Exported as a Prometheus summary (quantiles
+ *   interpolated within a bucket, +-19% relative resolution).
+ * - ThreadCpuClocks / ThreadCpuScope: named threads whose CPU time is
+ *   exported per thread; registration is the only locked operation.
+ * - MetricsWriter: builds the exposition text (HELP / TYPE per family).
+ * - MetricsServer: minimal HTTP/1.0 listener bound to 127.0.0.1, one
+ *   request per connection, served by its own thread.
+ */
+
+#pragma once
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * LatencyHistogram: lock-free histogram of durations (seconds)
+ *
+ * Bucket i holds values up to MIN_BOUND * 2^(i/2): 10 us to ~2 min in
+ * steps of sqrt(2).
+ */
+class LatencyHistogram {
+public:
+    static const size_t BUCKETS = 48;
+    static constexpr double MIN_BOUND = 1e-5;
+
+    static double upper_bound(size_t bucket) {
+        return MIN_BOUND * std::pow(2.0, bucket / 2.0);
+    }
+
+    void record(double seconds) {
+        size_t bucket = 0;
+        if (seconds > MIN_BOUND) {
+            bucket = static_cast<size_t>(std::ceil(2.0 * std::log2(seconds / MIN_BOUND)));
+            if (bucket >= BUCKETS) bucket = BUCKETS - 1;   // Last bucket also takes the overflow
+        }
+        counts[bucket].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sum_ns.fetch_add(static_cast<uint64_t>(seconds * 1e9), std::memory_order_relaxed);
+    }
+
+    /**
+     * quantile(): Value below which a fraction q of the recorded values
+     * lie, interpolated linearly within its bucket (0 if empty)
+     */
+    double quantile(double q) const {
+        uint64_t snapshot[BUCKETS];
+        uint64_t n = 0;
+        for (size_t i = 0; i < BUCKETS; i++) {
+            snapshot[i] = counts[i].load(std::memory_order_relaxed);
+            n += snapshot[i];
+        }
+        if (n == 0) return 0.0;
+        const double rank = q * n;
+        double seen = 0.0;
+        for (size_t i = 0; i < BUCKETS; i++) {
+            if (snapshot[i] == 0) continue;
+            if (seen + snapshot[i] >= rank) {
+                const double lower = (i == 0) ? 0.0 : upper_bound(i - 1);
+                return lower + (upper_bound(i) - lower) * (rank - seen) / snapshot[i];
+            }
+            seen += snapshot[i];
+        }
+        return upper_bound(BUCKETS - 1);
+    }
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    double sum() const { return sum_ns.load(std::memory_order_relaxed) / 1e9; }
+
+private:
+    std::atomic<uint64_t> counts[BUCKETS] = {};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum_ns{0};
+};
+
+/**
+ * ThreadCpuClocks: CPU clocks of the live named threads
+ */
+class ThreadCpuClocks {
+public:
+    struct Entry {
+        std::string role;
+        int id;
+        clockid_t clock;
+    };
+
+    std::list<Entry>::iterator add(const std::string& role, int id) {
+        clockid_t clock;
+        pthread_getcpuclockid(pthread_self(), &clock);
+        std::lock_guard<std::mutex> lock(mtx);
+        return entries.insert(entries.end(), Entry{role, id, clock});
+    }
+
+    void remove(std::list<Entry>::iterator entry) {
+        std::lock_guard<std::mutex> lock(mtx);
+        entries.erase(entry);
+    }
+
+    /**
+     * for_each(): fn(role, id, cpu_seconds) for every live thread
+     */
+    template <typename Fn>
+    void for_each(Fn fn) {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (const Entry& e : entries) {
+            struct timespec ts;
+            if (clock_gettime(e.clock, &ts) == 0) fn(e.role, e.id, ts.tv_sec + ts.tv_nsec / 1e9);
+        }
+    }
+
+private:
+    std::mutex mtx;
+    std::list<Entry> entries;
+};
+
+/**
+ * ThreadCpuScope: registers the calling thread for its lifetime
+ */
+class ThreadCpuScope {
+public:
+    ThreadCpuScope(ThreadCpuClocks& clocks, const std::string& role, int id)
+        : registry(clocks), entry(clocks.add(role, id)) {}
+    ~ThreadCpuScope() { registry.remove(entry); }
+
+    ThreadCpuScope(const ThreadCpuScope&) = delete;
+    ThreadCpuScope& operator=(const ThreadCpuScope&) = delete;
+
+private:
+    ThreadCpuClocks& registry;
+    std::list<ThreadCpuClocks::Entry>::iterator entry;
+};
+
+/**
+ * MetricsWriter: Prometheus text exposition builder
+ */
+class MetricsWriter {
+public:
+    MetricsWriter() { out.precision(12); }   // Counters stay exact up to 1e12
+
+    /**
+     * family(): Start a metric family (HELP and TYPE lines)
+     * @param type: "counter", "gauge" or "summary"
+     */
+    void family(const std::string& name, const char* type, const std::string& help) {
+        out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+    }
+
+    /**
+     * sample(): One value of the current family
+     * @param labels: e.g. role="worker",id="1" (without braces; may be empty)
+     */
+    void sample(const std::string& name, double value, const std::string& labels = "") {
+        out << name;
+        if (!labels.empty()) out << "{" << labels << "}";
+        out << " ";
+        if (std::isnan(value)) out << "NaN";
+        else if (std::isinf(value)) out << (value > 0 ? "+Inf" : "-Inf");
+        else out << value;
+        out << "\n";
+    }
+
+    // Counter or gauge with a single sample
+    void counter(const std::string& name, const std::string& help, double value) {
+        family(name, "counter", help);
+        sample(name, value);
+    }
+    void gauge(const std::string& name, const std::string& help, double value) {
+        family(name, "gauge", help);
+        sample(name, value);
+    }
+
+    // Summary with p50 / p90 / p99 of a histogram
+    void summary(const std::string& name, const std::string& help, const LatencyHistogram& histogram) {
+        family(name, "summary", help);
+        for (double q : {0.5, 0.9, 0.99}) {
+            std::ostringstream label;
+            label << "quantile=\"" << q << "\"";
+            sample(name, histogram.quantile(q), label.str());
+        }
+        sample(name + "_sum", histogram.sum());
+        sample(name + "_count", static_cast<double>(histogram.count()));
+    }
+
+    std::string text() const { return out.str(); }
+
+private:
+    std::ostringstream out;
+};
+
+/**
+ * MetricsServer: HTTP listener on 127.0.0.1 serving GET /metrics
+ */
+class MetricsServer {
+public:
+    static const int POLL_MS = 200;                 // Shutdown check interval
+    static const int REQUEST_TIMEOUT_MS = 1000;     // Slow clients are dropped
+
+    using Collector = std::function<void(MetricsWriter&)>;
+
+    ~MetricsServer() { close(); }
+
+    /**
+     * open(): Bind and listen on localhost
+     * @return: false (with the reason in error) if the port is unavailable
+     */
+    bool open(int port, std::string& error) {
+        listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (listen_fd < 0) {
+            error = std::strerror(errno);
+            return false;
+        }
+        int reuse = 1;
+        ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+            ::listen(listen_fd, 8) < 0) {
+            error = std::strerror(errno);
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * run(): Serve scrapes until `stopping` is set
+     */
+    void run(const std::atomic<bool>& stopping, const Collector& collect) {
+        while (listen_fd >= 0 && !stopping.load()) {
+            pollfd p{listen_fd, POLLIN, 0};
+            if (::poll(&p, 1, POLL_MS) <= 0) continue;
+            const int client = ::accept(listen_fd, nullptr, nullptr);
+            if (client < 0) continue;
+            serve(client, collect);
+            ::close(client);
+        }
+    }
+
+    void close() {
+        if (listen_fd >= 0) ::close(listen_fd);
+        listen_fd = -1;
+    }
+
+    uint64_t scrapes() const { return scrape_count.load(); }
+
+private:
+    // Read the request head, answer it and close
+    void serve(int client, const Collector& collect) {
+        std::string request;
+        char chunk[1024];
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+            pollfd p{client, POLLIN, 0};
+            if (::poll(&p, 1, REQUEST_TIMEOUT_MS) <= 0) return;
+            const ssize_t n = ::read(client, chunk, sizeof(chunk));
+            if (n <= 0) return;
+            request.append(chunk, static_cast<size_t>(n));
+        }
+        if (request.rfind("GET /metrics ", 0) != 0 && request.rfind("GET /metrics?", 0) != 0) {
+            respond(client, "404 Not Found", "text/plain", "Try /metrics\n");
+            return;
+        }
+        MetricsWriter writer;
+        collect(writer);
+        scrape_count++;
+        respond(client, "200 OK", "text/plain; version=0.0.4", writer.text());
+    }
+
+    static void respond(int client, const char* status, const char* type, const std::string& body) {
+        std::ostringstream head;
+        head << "HTTP/1.0 " << status << "\r\nContent-Type: " << type << "\r\nContent-Length: "
+             << body.size() << "\r\nConnection: close\r\n\r\n";
+        const std::string response = head.str() + body;
+        size_t sent = 0;
+        while (sent < response.size()) {
+            const ssize_t n = ::send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) return;
+            sent += static_cast<size_t>(n);
+        }
+    }
+
+    int listen_fd = -1;
+    std::atomic<uint64_t> scrape_count{0};
+};
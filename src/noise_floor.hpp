@@ -0,0 +1,140 @@
+/*
+ * EEL6528 Lab 1: Minimum-statistics noise floor and per-block SNR
+ *
+ * avg_power alone cannot say whether a block holds a signal: it needs a
+ * noise reference. The noise floor is estimated from the blocks
+ * themselves by minimum statistics (after R. Martin, 2001). Over a
+ * window longer than a typical transmission, the weakest stretches of the
+ * stream are noise only, so the minimum of short-term powers over the
+ * window, corrected for its bias, tracks the noise power even on a busy
+ * channel.
+ *
+ * OBSERVATIONS:
+ * Each block is split into sub-blocks, and their powers come out of the
+ * same pass that computes the block power (see exact_power_segments()).
+ * Short sub-blocks find the gaps between bursts inside a block. A block
+ * whose power was subsampled contributes its block power instead.
+ *
+ * MINIMUM OVER A SLIDING WINDOW, CONSTANT MEMORY:
+ * The window (window_s of stream time) is split into SUBWINDOWS parts.
+ * Only the minimum of each finished part is kept, plus the running
+ * minimum of the current one. The floor therefore falls immediately and
+ * rises at most one window after the noise does. Gaps in the stream do
+ * not matter: time is counted in samples.
+ *
+ * BIAS:
+ * A sub-block power averages n samples. For noise it fluctuates by about
+ * 1/sqrt(n) relative, and the minimum of D such values sits about
+ * sqrt(2 ln D) standard deviations below the mean. The minimum is
+ * therefore scaled up by
+ *   B = 1 / (1 - sqrt(2 ln D) / sqrt(n))
+ * For example 1250-sample sub-blocks and a 2 s window at 1 MS/s give
+ * D = 1600 and B = 1.12 (+0.5 dB).
+ *
+ * SNR:
+ *   snr = (P_block - floor) / floor
+ * It is reported in dB (fast_db(), within 0.002 dB of 10 log10, so the
+ * per-block call under the estimator's lock stays cheap) and clamped to
+ * SNR_MIN_DB..SNR_MAX_DB. A floor of zero (digital silence somewhere in
+ * the window, e.g. a zero-padded replay) leaves any block with power at
+ * SNR_MAX_DB rather than below the floor.
+ */
+
+#pragma once
+
+#include "fast_magnitude.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+
+/**
+ * NoiseEstimate: what the estimator says about one block
+ */
+struct NoiseEstimate {
+    double noise_floor = 0.0;       // Floor estimate (fc32 power) including this block
+    double snr_db = 0.0;            // Block SNR relative to the floor
+};
+
+/**
+ * NoiseFloorEstimator: shared by the processing threads (one short lock
+ * per block)
+ */
+class NoiseFloorEstimator {
+public:
+    static const size_t SUBWINDOWS = 8;
+    static constexpr double SNR_MIN_DB = -30.0;
+    static constexpr double SNR_MAX_DB = 100.0;
+    static constexpr double MAX_BIAS = 2.0;          // Cap for very short sub-blocks
+
+    /**
+     * Constructor
+     * @param window_s: Stream time the minimum is taken over
+     */
+    explicit NoiseFloorEstimator(double window_s) : window(window_s) {
+        std::fill(part_min, part_min + SUBWINDOWS, INF);
+    }
+
+    /**
+     * update(): Fold in one block and estimate its SNR
+     * @param sub_power: Sub-block average powers (fc32 units)
+     * @param count: Number of sub-blocks
+     * @param averaged: Samples averaged per sub-block power
+     * @param span: Stream samples each sub-block covers (= averaged unless subsampled)
+     * @param block_power: Average power of the whole block
+     * @param rate: Stream rate (samples/s)
+     */
+    NoiseEstimate update(const double* sub_power, size_t count, size_t averaged, size_t span,
+                         double block_power, double rate) {
+        std::lock_guard<std::mutex> lock(mtx);
+        const double part_samples = window * rate / SUBWINDOWS;
+        for (size_t i = 0; i < count; i++) {
+            current_min = std::min(current_min, sub_power[i]);
+            current_samples += static_cast<double>(span);
+            if (current_samples >= part_samples) {
+                part_min[next_part] = current_min;
+                next_part = (next_part + 1) % SUBWINDOWS;
+                current_min = INF;
+                current_samples = 0.0;
+            }
+        }
+        double minimum = current_min;
+        for (double m : part_min) minimum = std::min(minimum, m);
+
+        // Expected shortfall of the minimum of D noise-only observations
+        const double observations = std::max(2.0, window * rate / std::max<size_t>(span, 1));
+        const double shortfall = std::sqrt(2.0 * std::log(observations) / std::max<size_t>(averaged, 1));
+        floor = minimum * std::min(MAX_BIAS, 1.0 / std::max(1.0 - shortfall, 1.0 / MAX_BIAS));
+
+        NoiseEstimate estimate;
+        estimate.noise_floor = floor;
+        if (floor > 0.0) {
+            const double excess = (block_power - floor) / floor;
+            estimate.snr_db = std::min(SNR_MAX_DB, std::max(SNR_MIN_DB, static_cast<double>(fast_db(excess))));
+        } else {
+            estimate.snr_db = block_power > 0.0 ? SNR_MAX_DB : SNR_MIN_DB;
+        }
+        return estimate;
+    }
+
+    // Current estimate (fc32 power, 0 before the first block)
+    double noise_floor() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return floor;
+    }
+
+    double window_seconds() const { return window; }
+
+private:
+    static constexpr double INF = std::numeric_limits<double>::infinity();
+
+    std::mutex mtx;
+    double window;                       // Seconds of stream the minimum covers
+    double part_min[SUBWINDOWS];         // Minima of the last finished parts
+    size_t next_part = 0;                // Part overwritten next
+    double current_min = INF;            // Running minimum of the current part
+    double current_samples = 0.0;        // Stream samples in the current part
+    double floor = 0.0;
+};
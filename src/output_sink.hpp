@@ -0,0 +1,109 @@
+/*
+ * EEL6528 Lab 1: Asynchronous bulk output for per-block result lines
+ *
+ * Every result line used to be written with std::endl: one write() system
+ * call (and a terminal or pipe wakeup) per block, issued by the worker
+ * that processed it. At high block rates that is a large share of the
+ * workers' time, and it is time spent outside the signal processing.
+ *
+ * OutputSink collects formatted lines in memory and a writer thread hands
+ * them to the stream in bulk, one write every flush interval (or sooner
+ * once MAX_PENDING bytes are waiting). Workers only append to a string
+ * under a short lock. Two buffers are swapped, so their capacity is reused
+ * and the stream is written outside the lock. Lines keep the order in
+ * which write() was called; output appears at most one interval late.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+/**
+ * OutputSink: buffered line output drained by its own writer thread
+ */
+class OutputSink {
+public:
+    static constexpr size_t MAX_PENDING = 1 << 20;   // Flush early above this many bytes
+
+    /**
+     * Constructor: starts the writer thread
+     * @param out: Stream the lines go to (std::cout)
+     * @param flush_interval_s: Longest time a line waits in memory
+     */
+    OutputSink(std::ostream& out, double flush_interval_s)
+        : stream(out), interval(flush_interval_s) {
+        pending.reserve(64 * 1024);
+        writing.reserve(64 * 1024);
+        writer = std::thread([this] { run(); });
+    }
+
+    ~OutputSink() { stop(); }
+
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+
+    /**
+     * write(): Queue text (complete lines) for the next flush
+     */
+    void write(const std::string& text) {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending += text;
+        lines++;
+        if (pending.size() >= MAX_PENDING) cv.notify_one();
+    }
+
+    /**
+     * stop(): Flush what is pending and join the writer (idempotent)
+     */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (stopping) return;
+            stopping = true;
+        }
+        cv.notify_one();
+        writer.join();
+    }
+
+    uint64_t lines_written() const { return lines.load(); }
+    uint64_t flushes() const { return flush_count.load(); }
+
+private:
+    // Writer thread: swap the buffers every interval, write outside the lock
+    void run() {
+        const auto period = std::chrono::duration<double>(interval);
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true) {
+            cv.wait_for(lock, period, [this] { return stopping || pending.size() >= MAX_PENDING; });
+            const bool last = stopping;
+            if (!pending.empty()) {
+                writing.swap(pending);
+                lock.unlock();
+                stream.write(writing.data(), static_cast<std::streamsize>(writing.size()));
+                stream.flush();
+                writing.clear();
+                flush_count++;
+                lock.lock();
+            }
+            if (last && pending.empty()) break;
+        }
+    }
+
+    std::ostream& stream;
+    double interval;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::string pending;                 // Filled by write() (under mtx)
+    std::string writing;                 // Being written by the writer thread
+    std::atomic<uint64_t> lines{0};      // Counted under mtx, read from any thread
+    std::atomic<uint64_t> flush_count{0};
+    bool stopping = false;
+    std::thread writer;
+};
@@ -0,0 +1,179 @@
+/*
+ * EEL6528 Lab 1: Exact and subsampled block power estimates
+ *
+ * Under overload the processing threads can estimate the average power from
+ * every stride-th sample instead of walking the whole block. The estimate
+ * carries a confidence bound so approximate results are never mistaken for
+ * exact ones.
+ *
+ * ESTIMATOR (systematic sampling with a random start):
+ *   p[k] = |x[offset + k*stride]|^2, k = 0..n-1
+ *   mean = (1/n) * sum(p[k])                      (unbiased for any offset)
+ *   s^2  = sample variance of p[k]
+ *   bound = Z * sqrt(s^2 / n * (1 - n/N))         (finite population correction)
+ * The random offset keeps the estimate unbiased even for signals periodic in
+ * the stride; the bound treats the subset as a simple random sample.
+ */
+
+#pragma once
+
+#include "sample_block.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Two-sided 95% normal quantile used for the error bound
+const double POWER_BOUND_Z = 1.96;
+
+/**
+ * PowerEstimate: average block power plus its statistical quality
+ */
+struct PowerEstimate {
+    double avg_power = 0.0;      // Estimated (1/N) * sum(|x[n]|^2)
+    double error_bound = 0.0;    // 95% confidence half-width (0 when exact)
+    size_t samples_used = 0;     // Samples actually read
+    size_t stride = 1;           // 1 = every sample (exact)
+    bool approximate = false;    // true when computed from a subset
+};
+
+/**
+ * exact_power(): Full-precision power over every sample of the block
+ */
+inline PowerEstimate exact_power(const SampleBlock& block) {
+    PowerEstimate estimate;
+    estimate.avg_power = block_avg_power(block);
+    estimate.samples_used = block.size();
+    return estimate;
+}
+
+/**
+ * exact_power_segments(): Exact power plus the powers of `segments`
+ * consecutive sub-blocks, in the same single pass
+ * @param segment_power: Receives one average power per sub-block; the
+ *   last sub-block takes the remainder of the division
+ * The block power is the sample-weighted mean of the sub-blocks (equal
+ * to exact_power() up to double rounding).
+ */
+inline PowerEstimate exact_power_segments(const SampleBlock& block, size_t segments, double* segment_power) {
+    PowerEstimate estimate;
+    const size_t total = block.size();
+    estimate.samples_used = total;
+    if (total == 0 || segments == 0) return estimate;
+    const size_t length = total / segments;
+    double sum = 0.0;
+    for (size_t s = 0; s < segments; s++) {
+        const size_t count = (s + 1 == segments) ? total - s * length : length;
+        segment_power[s] = range_avg_power(block, s * length, count);
+        sum += segment_power[s] * count;
+    }
+    estimate.avg_power = sum / total;
+    return estimate;
+}
+
+/**
+ * subsampled_power(): Power estimated from every stride-th sample
+ * @param block: Sample block (any format)
+ * @param stride: Sample spacing (>= 2 for a real saving)
+ * @param offset: Start index in [0, stride), chosen at random per block
+ */
+inline PowerEstimate subsampled_power(const SampleBlock& block, size_t stride, size_t offset) {
+    const size_t total = block.size();
+    if (stride <= 1 || total == 0) return exact_power(block);
+
+    double sum = 0.0, sum_sq = 0.0;
+    size_t n = 0;
+    if (block.format == SampleFormat::FC32) {
+        for (size_t i = offset; i < total; i += stride, n++) {
+            double p = std::norm(block.samples[i]);
+            sum += p;
+            sum_sq += p * p;
+        }
+    } else {
+        const double scale2 = double(block.int_scale) * block.int_scale;
+        for (size_t i = offset; i < total; i += stride, n++) {
+            double re, im;
+            if (block.format == SampleFormat::SC8) {
+                re = block.samples_sc8[i].real();
+                im = block.samples_sc8[i].imag();
+            } else {
+                re = block.samples_sc16[i].real();
+                im = block.samples_sc16[i].imag();
+            }
+            double p = (re * re + im * im) * scale2;
+            sum += p;
+            sum_sq += p * p;
+        }
+    }
+
+    PowerEstimate estimate;
+    estimate.samples_used = n;
+    estimate.stride = stride;
+    estimate.approximate = true;
+    if (n == 0) return estimate;
+    estimate.avg_power = sum / n;
+    if (n > 1) {
+        double variance = (sum_sq - n * estimate.avg_power * estimate.avg_power) / (n - 1);
+        double fpc = 1.0 - static_cast<double>(n) / total;
+        estimate.error_bound = POWER_BOUND_Z * std::sqrt(std::max(variance, 0.0) / n * fpc);
+    }
+    return estimate;
+}
+
+/**
+ * LoadShedder: per-thread overload controller driven by queue age
+ *
+ * - Enters overload when a popped block waited longer than age_threshold
+ * - Stride grows linearly with the age: the largest power of two
+ *   <= MIN_STRIDE * age / threshold, kept within MIN_STRIDE..MAX_STRIDE
+ *   (4 up to twice the threshold, 8 from 2x, 16 from 4x, 32 from 8x,
+ *   64 from 16x)
+ * - Leaves overload once the age falls below half the threshold
+ *   (hysteresis), so full-precision processing resumes automatically
+ */
+class LoadShedder {
+public:
+    static const size_t MIN_STRIDE = 4;
+    static const size_t MAX_STRIDE = 64;
+
+    /**
+     * Constructor
+     * @param age_threshold_sec: Queue age that triggers overload (0 = never)
+     * @param seed: Random offset seed (use a different one per thread)
+     */
+    LoadShedder(double age_threshold_sec, uint64_t seed)
+        : threshold(age_threshold_sec), rng_state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+
+    /**
+     * stride_for(): Choose the sample stride for a block of the given age
+     * @param age_sec: Time the block spent queued
+     * @return: 1 for exact processing, a power of two in
+     *          MIN_STRIDE..MAX_STRIDE in overload
+     */
+    size_t stride_for(double age_sec) {
+        if (threshold <= 0.0) return 1;
+        if (!overloaded && age_sec > threshold) overloaded = true;
+        if (overloaded && age_sec < threshold / 2) overloaded = false;
+        if (!overloaded) return 1;
+
+        double wanted = MIN_STRIDE * age_sec / threshold;
+        size_t stride = MIN_STRIDE;
+        while (stride < MAX_STRIDE && stride * 2 <= wanted) stride *= 2;
+        return stride;
+    }
+
+    /**
+     * random_offset(): Uniform start index in [0, stride)
+     */
+    size_t random_offset(size_t stride) {
+        rng_state ^= rng_state << 13;
+        rng_state ^= rng_state >> 7;
+        rng_state ^= rng_state << 17;
+        return static_cast<size_t>(rng_state % stride);
+    }
+
+private:
+    double threshold;                 // Queue age that triggers overload (s)
+    bool overloaded = false;
+    uint64_t rng_state;               // xorshift state, never zero
+};
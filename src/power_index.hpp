@@ -0,0 +1,204 @@
+/*
+ * EEL6528 Lab 1: Per-block power index for capture files
+ *
+ * A multi-hour capture is tens of GB of IQ. The index has one fixed-size
+ * entry per block (32 bytes vs 80 KB of fc32 samples), so finding the
+ * busy parts of a capture reads the index only, never the IQ.
+ *
+ * The entries live in one of two places:
+ * - Containers (capture_file.hpp, written by lab1 --record): a trailing
+ *   PowerIndexEntry[N] after the last chunk, located by the footer and
+ *   rebuilt from the chunk headers if the footer is missing. file_offset
+ *   is the byte offset of the block's chunk; timestamps are receive times.
+ * - Headerless dumps (raw fc32/sc8 blocks): a side file written after the
+ *   fact by `capture_tool index`. file_offset is the byte offset of the
+ *   block itself; timestamps follow from the sample rate.
+ *
+ * SIDE FILE LAYOUT (<capture>.idx, little-endian, append-only):
+ *   PowerIndexHeader                       64 bytes
+ *   PowerIndexEntry[N]                     32 bytes each, in block order
+ * N follows from the file size, so an index cut short by a crash is still
+ * valid up to its last complete entry.
+ */
+
+#pragma once
+
+#include "sample_format.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+// ============================================================================
+// ON-DISK FORMAT
+// ============================================================================
+
+const char POWER_INDEX_MAGIC[8] = {'L', '1', 'P', 'W', 'R', 'I', 'D', 'X'};
+const uint32_t POWER_INDEX_VERSION = 1;
+
+/**
+ * PowerIndexHeader: describes the capture the index belongs to
+ */
+struct PowerIndexHeader {
+    char magic[8];                  // POWER_INDEX_MAGIC
+    uint32_t version;               // POWER_INDEX_VERSION
+    uint32_t sc8;                   // 1 = sc8 samples, 0 = fc32
+    uint64_t block_samples;         // Samples per block
+    double sample_rate;             // Sampling rate (Hz), 0 if unknown
+    double int_scale;               // fc32 amplitude of one int8 step (sc8)
+    int64_t start_unix_ns;          // Wall-clock time of block 0 (0 if unknown)
+    uint8_t reserved[16];
+};
+
+/**
+ * PowerIndexEntry: one block of the capture
+ */
+struct PowerIndexEntry {
+    uint64_t block_number;          // Block number in the original stream
+    double timestamp;               // Seconds since block 0
+    uint64_t file_offset;           // Chunk offset (container) or block offset (dump)
+    float avg_power;                // (1/N) * sum(|x[n]|^2), fc32 units
+    float peak_power;               // max |x[n]|^2, fc32 units
+};
+
+static_assert(sizeof(PowerIndexHeader) == 64, "index header layout");
+static_assert(sizeof(PowerIndexEntry) == 32, "index entry layout");
+
+/**
+ * index_path_for(): Conventional index file name of a capture
+ */
+inline std::string index_path_for(const std::string& capture_path) {
+    return capture_path + ".idx";
+}
+
+// ============================================================================
+// BLOCK STATISTICS
+// ============================================================================
+
+/**
+ * block_peak_fc32() / block_peak_sc8(): Largest |x|^2 in a block
+ */
+inline float block_peak_fc32(const std::complex<float>* samples, size_t count) {
+    const float* x = reinterpret_cast<const float*>(samples);
+    float peak = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        peak = std::max(peak, x[2 * i] * x[2 * i] + x[2 * i + 1] * x[2 * i + 1]);
+    }
+    return peak;
+}
+
+inline float block_peak_sc8(const std::complex<int8_t>* samples, size_t count, float scale) {
+    const int8_t* x = reinterpret_cast<const int8_t*>(samples);
+    int32_t largest = 0;
+    for (size_t i = 0; i < count; i++) {
+        largest = std::max(largest, int32_t(x[2 * i]) * x[2 * i] + int32_t(x[2 * i + 1]) * x[2 * i + 1]);
+    }
+    return static_cast<float>(largest) * scale * scale;
+}
+
+// ============================================================================
+// WRITER
+// ============================================================================
+
+/**
+ * PowerIndexWriter: appends entries to an index file
+ */
+class PowerIndexWriter {
+public:
+    ~PowerIndexWriter() { close(); }
+
+    /**
+     * open(): Create (truncate) the index and write its header
+     * @param error: Reason on failure
+     */
+    bool open(const std::string& path, const PowerIndexHeader& header, std::string& error) {
+        file = std::fopen(path.c_str(), "wb");
+        if (!file || std::fwrite(&header, sizeof(header), 1, file) != 1) {
+            error = path + ": " + std::strerror(errno);
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    bool append(const PowerIndexEntry& entry) {
+        if (!file || std::fwrite(&entry, sizeof(entry), 1, file) != 1) return false;
+        entries++;
+        return true;
+    }
+
+    void close() {
+        if (file) std::fclose(file);
+        file = nullptr;
+    }
+
+    uint64_t size() const { return entries; }
+
+private:
+    std::FILE* file = nullptr;
+    uint64_t entries = 0;
+};
+
+/**
+ * make_index_header(): Header for a capture's index
+ * @param sc8: Capture holds sc8 samples (else fc32)
+ */
+inline PowerIndexHeader make_index_header(bool sc8, uint64_t block_samples, double sample_rate,
+                                          double int_scale, int64_t start_unix_ns) {
+    PowerIndexHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, POWER_INDEX_MAGIC, sizeof(header.magic));
+    header.version = POWER_INDEX_VERSION;
+    header.sc8 = sc8 ? 1 : 0;
+    header.block_samples = block_samples;
+    header.sample_rate = sample_rate;
+    header.int_scale = int_scale;
+    header.start_unix_ns = start_unix_ns;
+    return header;
+}
+
+// ============================================================================
+// READER
+// ============================================================================
+
+/**
+ * PowerIndexView: entries of a mapped index file
+ */
+struct PowerIndexView {
+    const PowerIndexHeader* header = nullptr;
+    const PowerIndexEntry* entries = nullptr;
+    uint64_t count = 0;
+
+    /**
+     * first_at_or_after(): First entry with timestamp >= t (binary search;
+     * timestamps increase with the block number)
+     */
+    uint64_t first_at_or_after(double t) const {
+        return std::lower_bound(entries, entries + count, t,
+            [](const PowerIndexEntry& e, double value) { return e.timestamp < value; }) - entries;
+    }
+};
+
+/**
+ * view_power_index(): Validate and interpret mapped index bytes
+ * @param error: Reason on failure
+ */
+inline bool view_power_index(const uint8_t* data, size_t size, PowerIndexView& view, std::string& error) {
+    if (size < sizeof(PowerIndexHeader) ||
+        std::memcmp(data, POWER_INDEX_MAGIC, sizeof(POWER_INDEX_MAGIC)) != 0) {
+        error = "not a power index";
+        return false;
+    }
+    view.header = reinterpret_cast<const PowerIndexHeader*>(data);
+    if (view.header->version != POWER_INDEX_VERSION) {
+        error = "unsupported index version " + std::to_string(view.header->version);
+        return false;
+    }
+    view.entries = reinterpret_cast<const PowerIndexEntry*>(data + sizeof(PowerIndexHeader));
+    view.count = (size - sizeof(PowerIndexHeader)) / sizeof(PowerIndexEntry);
+    return true;
+}
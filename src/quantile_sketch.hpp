@@ -0,0 +1,218 @@
+/*
+ * EEL6528 Lab 1: Mergeable streaming quantile sketches
+ *
+ * The mean block power of a run hides how the power is distributed: a
+ * channel busy 5% of the time and one with a constant weak carrier can
+ * have the same mean. Percentiles of block power per interval
+ * characterize channel occupancy, but exact percentiles need every value
+ * of the interval.
+ *
+ * KllSketch (Karnin, Lang, Liberty 2016) keeps a bounded sample of the
+ * stream in levels: level h holds items of weight 2^h. When the sketch is
+ * full, the lowest full level is sorted and every other item (random
+ * offset) is promoted to the next level, halving it. Level capacities
+ * shrink geometrically (x2/3) going down, so the sketch holds about
+ * 3 * K items whatever the stream length, and its rank error is about
+ * 1.7 / K (~1% for K = 200). Two sketches merge by concatenating levels
+ * and compacting, with the same error bound, so per-thread sketches are
+ * combined when a report is due.
+ *
+ * SketchSlots hands each worker its own sketch. Recording is wait-free for
+ * the worker (an exchange to take the sketch, a store to give it back);
+ * the reporter swaps in an empty sketch between two of a worker's updates,
+ * spinning only while that worker is inside one update.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * KllSketch: approximate quantiles of a stream in bounded memory
+ */
+class KllSketch {
+public:
+    static const size_t K = 200;                 // Capacity of the top level
+    static constexpr double SHRINK = 2.0 / 3.0;  // Capacity ratio between levels
+
+    explicit KllSketch(uint64_t seed = 0x9E3779B97F4A7C15ull) : rng(seed | 1) {
+        levels.resize(1);
+        levels[0].reserve(K);
+        limit = max_held();
+    }
+
+    void update(double value) {
+        levels[0].push_back(value);
+        n++;
+        held++;
+        if (held > limit) compress();
+    }
+
+    /**
+     * merge(): Add another sketch's stream to this one
+     */
+    void merge(const KllSketch& other) {
+        if (other.levels.size() > levels.size()) {
+            levels.resize(other.levels.size());
+            limit = max_held();
+        }
+        for (size_t h = 0; h < other.levels.size(); h++) {
+            levels[h].insert(levels[h].end(), other.levels[h].begin(), other.levels[h].end());
+            held += other.levels[h].size();
+        }
+        n += other.n;
+        while (held > limit) compress();
+    }
+
+    /**
+     * quantile(): Value with a fraction q of the stream below it (0 if empty)
+     */
+    double quantile(double q) const {
+        std::vector<std::pair<double, uint64_t>> weighted;
+        weighted.reserve(held);
+        for (size_t h = 0; h < levels.size(); h++) {
+            for (double v : levels[h]) weighted.emplace_back(v, uint64_t(1) << h);
+        }
+        if (weighted.empty()) return 0.0;
+        std::sort(weighted.begin(), weighted.end());
+        uint64_t total = 0;
+        for (const auto& w : weighted) total += w.second;
+        const double rank = std::min(std::max(q, 0.0), 1.0) * static_cast<double>(total);
+        uint64_t seen = 0;
+        for (const auto& w : weighted) {
+            seen += w.second;
+            if (static_cast<double>(seen) >= rank) return w.first;
+        }
+        return weighted.back().first;
+    }
+
+    // Empty the sketch (keeps the level 0 buffer)
+    void clear() {
+        levels.resize(1);
+        levels[0].clear();
+        limit = max_held();
+        n = 0;
+        held = 0;
+    }
+
+    uint64_t count() const { return n; }
+    size_t items() const { return held; }
+
+private:
+    // Capacity of level h (the top level gets K)
+    size_t capacity(size_t h) const {
+        const double depth = static_cast<double>(levels.size() - 1 - h);
+        return std::max<size_t>(2, static_cast<size_t>(std::ceil(K * std::pow(SHRINK, depth))));
+    }
+
+    size_t max_held() const {
+        size_t total = 0;
+        for (size_t h = 0; h < levels.size(); h++) total += capacity(h);
+        return total;
+    }
+
+    // Halve the lowest full level into the one above it
+    void compress() {
+        for (size_t h = 0; h < levels.size(); h++) {
+            if (levels[h].size() < capacity(h)) continue;
+            if (h + 1 == levels.size()) {
+                levels.emplace_back();
+                limit = max_held();
+            }
+            std::vector<double>& level = levels[h];
+            std::sort(level.begin(), level.end());
+            // An odd item out stays at this level
+            const bool odd = level.size() % 2 == 1;
+            const double kept = odd ? level.back() : 0.0;
+            const size_t pairs = level.size() / 2;
+            const size_t offset = next_bit();
+            for (size_t i = 0; i < pairs; i++) levels[h + 1].push_back(level[2 * i + offset]);
+            level.clear();
+            if (odd) level.push_back(kept);
+            held -= pairs;
+            return;
+        }
+    }
+
+    // xorshift64: the compaction coin
+    size_t next_bit() {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        return static_cast<size_t>(rng >> 63);
+    }
+
+    std::vector<std::vector<double>> levels;
+    uint64_t n = 0;          // Values seen
+    size_t held = 0;         // Items stored over all levels
+    size_t limit = 0;        // max_held() for the current number of levels
+    uint64_t rng;
+};
+
+/**
+ * SketchSlots: one KllSketch per recording thread, collected by a reporter
+ */
+class SketchSlots {
+public:
+    /**
+     * Constructor
+     * @param slots: Recording threads (thread i uses slot i)
+     */
+    explicit SketchSlots(size_t slots) : active(slots), spare(slots) {
+        for (size_t i = 0; i < slots; i++) {
+            active[i].store(new KllSketch(0x9E3779B97F4A7C15ull + 2 * i));
+            spare[i].reset(new KllSketch(0xD1B54A32D192ED03ull + 2 * i));
+        }
+    }
+
+    ~SketchSlots() {
+        for (auto& slot : active) delete slot.load();
+    }
+
+    SketchSlots(const SketchSlots&) = delete;
+    SketchSlots& operator=(const SketchSlots&) = delete;
+
+    /**
+     * record(): Add a value to slot `slot` (only ever one thread per slot)
+     * @return: false if there is no such slot (value not recorded)
+     */
+    bool record(size_t slot, double value) {
+        if (slot >= active.size()) return false;
+        KllSketch* sketch = active[slot].exchange(nullptr, std::memory_order_acquire);
+        sketch->update(value);
+        active[slot].store(sketch, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * collect(): Merge every slot's values since the last collect() into
+     * `into` and restart the slots empty (reporter thread only)
+     */
+    void collect(KllSketch& into) {
+        for (size_t i = 0; i < active.size(); i++) {
+            KllSketch* fresh = spare[i].release();
+            KllSketch* taken = active[i].load(std::memory_order_acquire);
+            while (taken == nullptr ||
+                   !active[i].compare_exchange_weak(taken, fresh, std::memory_order_acq_rel)) {
+                if (taken == nullptr) {
+                    std::this_thread::yield();   // The worker is inside record()
+                    taken = active[i].load(std::memory_order_acquire);
+                }
+            }
+            into.merge(*taken);
+            taken->clear();
+            spare[i].reset(taken);   // Reused by the next swap
+        }
+    }
+
+private:
+    std::vector<std::atomic<KllSketch*>> active;    // Owned; null while a worker records
+    std::vector<std::unique_ptr<KllSketch>> spare;  // Reporter only
+};
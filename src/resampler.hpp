@@ -0,0 +1,184 @@
+/*
+ * EEL6528 Lab 1: Polyphase rational resampler
+ *
+ * The N210 only produces 100 MHz / N sample rates. This stage converts a
+ * block stream at the actual RX rate to any rate out = in * L / M:
+ *   25 MHz -> 20 MHz (OFDM):   L/M = 4/5
+ *   12.5 MHz -> 11 MHz (DSSS): L/M = 22/25
+ *
+ * POLYPHASE FORM:
+ * Conceptually: upsample by L (insert zeros), lowpass at min(1/L, 1/M) of
+ * the upsampled rate, keep every M-th sample. Only the non-zero products are
+ * computed: output n sits at upsampled index t = n*M, i.e. input index
+ * t / L with filter phase t % L, so each output is one K-tap dot product
+ * with the taps of that phase (K = taps per phase).
+ *
+ * STATE ACROSS BLOCKS:
+ * The last K-1 input samples and the position of the next output (input
+ * index + phase) carry over to the next block, so feeding a stream block by
+ * block gives exactly the same output as one call over the whole stream.
+ *
+ * SIMD:
+ * Taps are stored per phase, reversed and duplicated for I and Q
+ * ([h0 h0 h1 h1 ...]), so a dot product is a plain multiply-accumulate of
+ * two float arrays: AVX (8 lanes) / SSE (4 lanes) with a scalar fallback.
+ */
+
+#pragma once
+
+#include "dsp_stages.hpp"
+
+#include <algorithm>
+#include <complex>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+/**
+ * rational_ratio(): Closest L/M to out_rate / in_rate with M <= max_denominator
+ * @param interp: Output L (upsampling factor)
+ * @param decim: Output M (downsampling factor)
+ */
+inline void rational_ratio(double out_rate, double in_rate, uint32_t& interp, uint32_t& decim,
+                           uint32_t max_denominator = 1000) {
+    const double ratio = out_rate / in_rate;
+    double best_error = -1.0;
+    for (uint32_t m = 1; m <= max_denominator; m++) {
+        uint32_t l = static_cast<uint32_t>(std::max(1.0, std::floor(ratio * m + 0.5)));
+        double error = std::abs(static_cast<double>(l) / m - ratio);
+        if (best_error < 0.0 || error < best_error - 1e-15) {
+            best_error = error;
+            interp = l;
+            decim = m;
+            if (error < 1e-12 * ratio) break;
+        }
+    }
+    const uint32_t g = std::gcd(interp, decim);
+    interp /= g;
+    decim /= g;
+}
+
+/**
+ * RationalResampler: streaming L/M polyphase resampler for fc32 samples
+ */
+class RationalResampler {
+public:
+    /**
+     * Constructor
+     * @param interp: Upsampling factor L
+     * @param decim: Downsampling factor M
+     * @param taps_per_phase: Prototype length per phase (K); more taps give
+     *                        a sharper anti-alias filter at higher cost
+     */
+    RationalResampler(uint32_t interp, uint32_t decim, size_t taps_per_phase = 24)
+        : L(interp), M(decim), K(round_up(taps_per_phase, LANE_SAMPLES)) {
+        // Prototype lowpass at the upsampled rate, cutoff just below the
+        // narrower of the input / output Nyquist bands, gain L
+        const double cutoff = 0.45 / std::max(L, M);
+        std::vector<float> prototype = design_lowpass(static_cast<size_t>(L) * taps_per_phase, cutoff);
+        phase_taps.assign(static_cast<size_t>(L) * 2 * K, 0.0f);
+        for (size_t i = 0; i < prototype.size(); i++) {
+            const size_t phase = i % L;
+            const size_t k = i / L;                       // Multiplies x[base - k]
+            float* taps = phase_taps.data() + phase * 2 * K;
+            taps[2 * (K - 1 - k)] = taps[2 * (K - 1 - k) + 1] = prototype[i] * L;
+        }
+        history.assign(K - 1, std::complex<float>(0.0f, 0.0f));
+    }
+
+    uint32_t interpolation() const { return L; }
+    uint32_t decimation() const { return M; }
+    size_t taps_per_phase() const { return K; }
+
+    // Upper bound on outputs produced for n more inputs
+    size_t max_output(size_t n) const {
+        return static_cast<size_t>((static_cast<uint64_t>(n) * L) / M + 1);
+    }
+
+    /**
+     * process(): Resample one block, continuing from the previous call
+     * @param in: Input samples at the input rate
+     * @param n: Number of input samples
+     * @param out: Output samples at the output rate (cleared and filled)
+     */
+    void process(const std::complex<float>* in, size_t n, std::vector<std::complex<float>>& out) {
+        buffer.resize(K - 1 + n);
+        std::copy(history.begin(), history.end(), buffer.begin());
+        std::copy(in, in + n, buffer.begin() + (K - 1));
+
+        out.clear();
+        out.reserve(max_output(n));
+        const float* x = reinterpret_cast<const float*>(buffer.data());
+        // Output uses input x[base - K + 1 .. base], i.e. buffer[base .. base + K)
+        while (next_base < n) {
+            const float* taps = phase_taps.data() + next_phase * 2 * K;
+            out.push_back(dot(taps, x + 2 * next_base));
+            next_phase += M;
+            next_base += next_phase / L;
+            next_phase %= L;
+        }
+        next_base -= n;
+        std::copy(buffer.end() - (K - 1), buffer.end(), history.begin());
+        samples_in += n;
+        samples_out += out.size();
+    }
+
+    uint64_t total_in() const { return samples_in; }
+    uint64_t total_out() const { return samples_out; }
+
+private:
+    static const size_t LANE_SAMPLES = 4;     // Complex samples per AVX register
+
+    static size_t round_up(size_t value, size_t multiple) {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+
+    // sum over 2K floats of taps[i] * x[i], folded into (I, Q)
+    std::complex<float> dot(const float* taps, const float* x) const {
+        const size_t count = 2 * K;
+#if defined(__AVX__)
+        __m256 acc = _mm256_setzero_ps();
+        for (size_t i = 0; i < count; i += 8) {
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(taps + i), _mm256_loadu_ps(x + i)));
+        }
+        alignas(32) float lanes[8];
+        _mm256_store_ps(lanes, acc);
+        return std::complex<float>(lanes[0] + lanes[2] + lanes[4] + lanes[6],
+                                   lanes[1] + lanes[3] + lanes[5] + lanes[7]);
+#elif defined(__SSE2__) || defined(_M_X64)
+        __m128 acc0 = _mm_setzero_ps();
+        __m128 acc1 = _mm_setzero_ps();
+        for (size_t i = 0; i < count; i += 8) {
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(taps + i), _mm_loadu_ps(x + i)));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(taps + i + 4), _mm_loadu_ps(x + i + 4)));
+        }
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, _mm_add_ps(acc0, acc1));
+        return std::complex<float>(lanes[0] + lanes[2], lanes[1] + lanes[3]);
+#else
+        float re = 0.0f, im = 0.0f;
+        for (size_t i = 0; i < count; i += 2) {
+            re += taps[i] * x[i];
+            im += taps[i + 1] * x[i + 1];
+        }
+        return std::complex<float>(re, im);
+#endif
+    }
+
+    uint32_t L;                                   // Interpolation factor
+    uint32_t M;                                   // Decimation factor
+    size_t K;                                     // Taps per phase (multiple of 4)
+    std::vector<float> phase_taps;                // L phases x 2K (reversed, I/Q duplicated)
+    std::vector<std::complex<float>> history;     // Last K-1 inputs of the previous block
+    std::vector<std::complex<float>> buffer;      // History + block, reused
+    size_t next_base = 0;                         // Input index of the next output
+    uint32_t next_phase = 0;                      // Filter phase of the next output
+    uint64_t samples_in = 0;
+    uint64_t samples_out = 0;
+};
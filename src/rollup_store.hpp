@@ -0,0 +1,471 @@
+/*
+ * EEL6528 Lab 1: Multi-resolution rollup store for block statistics
+ *
+ * Per-block power at 25 MHz is 2500 values per second; keeping them all
+ * for a long-term trend is neither affordable nor useful. The store keeps
+ * each series (block power, latency, queue depth) as min / mean / max per
+ * second, per minute and per hour, each tier a fixed ring in a
+ * memory-mapped file, so a series costs the same disk and memory after a
+ * year as after a minute.
+ *
+ * FILE LAYOUT (<dir>/<series>.rollup, host byte order):
+ *   RollupFileHeader                       64 bytes
+ *   RollupPoint[SECOND capacity]           40 bytes each (1 h of seconds)
+ *   RollupPoint[MINUTE capacity]           (7 days of minutes)
+ *   RollupPoint[HOUR capacity]             (400 days of hours)
+ * The point of interval t sits at slot (t / resolution) % capacity and
+ * carries its own start time, so a slot left over from an older lap of
+ * the ring is recognized and ignored. An existing file is reopened and
+ * continued: a restarted run adds to the same trend (~0.9 MB per series).
+ * A writer holds an exclusive flock() on the file while it is mapped, so
+ * two runs cannot feed the same series; readers take no lock.
+ *
+ * INGESTION (workers, lock-free):
+ * record() adds a value to the in-memory slot of its second: a few
+ * relaxed atomic updates (CAS loops for min / max / sum), no lock, no
+ * allocation. INGEST_SLOTS slots cover the seconds from GRACE_S in the
+ * past to a few ahead; values outside them (a block delayed by more than
+ * GRACE_S) are counted as rejected.
+ *
+ * ROLLUP (one thread, run()):
+ * Every ROLL_MS, seconds older than GRACE_S are sealed: the slot is
+ * closed to new writers, read, reset and reopened for the second one ring
+ * lap later; its min / mean / max is folded into the second, minute and
+ * hour points, in place in the mapped files. The partial minute and hour
+ * are therefore always visible to queries. close() seals what is left.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// ============================================================================
+// ON-DISK FORMAT
+// ============================================================================
+
+const char ROLLUP_MAGIC[8] = {'L', '1', 'R', 'O', 'L', 'L', 'U', 'P'};
+const uint32_t ROLLUP_VERSION = 1;
+
+/**
+ * RollupTier: resolution of a ring (one point per second, minute or hour)
+ */
+enum class RollupTier : uint32_t { SECOND, MINUTE, HOUR };
+
+const size_t ROLLUP_TIERS = 3;
+const int64_t ROLLUP_RESOLUTION[ROLLUP_TIERS] = {1, 60, 3600};              // Seconds per point
+const uint32_t ROLLUP_CAPACITY[ROLLUP_TIERS] = {3600, 7 * 1440, 400 * 24};  // Points per ring
+
+inline const char* rollup_tier_name(RollupTier tier) {
+    switch (tier) {
+        case RollupTier::SECOND: return "second";
+        case RollupTier::MINUTE: return "minute";
+        case RollupTier::HOUR:   return "hour";
+    }
+    return "?";
+}
+
+inline bool parse_rollup_tier(const std::string& name, RollupTier& tier) {
+    for (RollupTier t : {RollupTier::SECOND, RollupTier::MINUTE, RollupTier::HOUR}) {
+        if (name == rollup_tier_name(t)) {
+            tier = t;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * RollupFileHeader: identifies the series and the ring sizes
+ */
+struct RollupFileHeader {
+    char magic[8];                          // ROLLUP_MAGIC
+    uint32_t version;                       // ROLLUP_VERSION
+    uint32_t capacity[ROLLUP_TIERS];        // Points per tier
+    char series[40];                        // Series name (NUL-terminated)
+};
+
+/**
+ * RollupPoint: statistics of one interval
+ */
+struct RollupPoint {
+    int64_t start;                          // Unix time (s) the interval starts at
+    uint64_t count;                         // Values recorded (0 = empty slot)
+    double min;
+    double mean;
+    double max;
+};
+
+static_assert(sizeof(RollupFileHeader) == 64, "rollup header layout");
+static_assert(sizeof(RollupPoint) == 40, "rollup point layout");
+
+/**
+ * merge_rollup(): Fold an interval's statistics into the point of the
+ * interval starting at `start` (replaces a point from an older lap)
+ */
+inline void merge_rollup(RollupPoint& point, int64_t start, uint64_t count, double min, double mean, double max) {
+    if (point.start != start || point.count == 0) {
+        point = RollupPoint{start, count, min, mean, max};
+        return;
+    }
+    const uint64_t total = point.count + count;
+    point.mean += (mean - point.mean) * static_cast<double>(count) / static_cast<double>(total);
+    point.min = std::min(point.min, min);
+    point.max = std::max(point.max, max);
+    point.count = total;
+}
+
+/**
+ * unix_seconds(): Wall-clock time (s since the epoch)
+ */
+inline double unix_seconds() {
+    return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// ============================================================================
+// MAPPED SERIES FILE
+// ============================================================================
+
+/**
+ * RollupFile: one series' rings, memory-mapped (RAII)
+ */
+class RollupFile {
+public:
+    RollupFile() = default;
+    RollupFile(const RollupFile&) = delete;
+    RollupFile& operator=(const RollupFile&) = delete;
+    ~RollupFile() { close(); }
+
+    static size_t file_size() {
+        size_t points = 0;
+        for (size_t t = 0; t < ROLLUP_TIERS; t++) points += ROLLUP_CAPACITY[t];
+        return sizeof(RollupFileHeader) + points * sizeof(RollupPoint);
+    }
+
+    /**
+     * open(): Map a series file, creating it if needed
+     * @param series: Name written to a new file's header
+     * @param writable: false to inspect an existing file only
+     * @param error: Reason on failure (not a rollup file, other ring sizes,
+     *   written by another process, ...)
+     */
+    bool open(const std::string& path, const std::string& series, bool writable, std::string& error) {
+        close();
+        int fd = ::open(path.c_str(), writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+        if (fd < 0) {
+            error = path + ": " + std::strerror(errno);
+            return false;
+        }
+        if (writable && flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            error = path + (errno == EWOULDBLOCK ? ": in use by another process" : ": " + std::string(std::strerror(errno)));
+            ::close(fd);
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            error = path + ": " + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        const bool fresh = st.st_size == 0;
+        if (fresh && (!writable || ftruncate(fd, static_cast<off_t>(file_size())) != 0)) {
+            error = path + (writable ? ": " + std::string(std::strerror(errno)) : ": empty file");
+            ::close(fd);
+            return false;
+        }
+        if (!fresh && static_cast<size_t>(st.st_size) != file_size()) {
+            error = path + ": not a rollup file of this version";
+            ::close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, file_size(), writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            error = path + ": mmap: " + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        if (writable) lock_fd = fd;   // Closing it would release the lock
+        else ::close(fd);             // The mapping keeps the file referenced
+        base = static_cast<uint8_t*>(mapped);
+        RollupFileHeader& h = *reinterpret_cast<RollupFileHeader*>(base);
+        if (fresh) {
+            std::memcpy(h.magic, ROLLUP_MAGIC, sizeof(h.magic));
+            h.version = ROLLUP_VERSION;
+            std::memcpy(h.capacity, ROLLUP_CAPACITY, sizeof(h.capacity));
+            std::strncpy(h.series, series.c_str(), sizeof(h.series) - 1);
+        } else if (std::memcmp(h.magic, ROLLUP_MAGIC, sizeof(h.magic)) != 0 || h.version != ROLLUP_VERSION ||
+                   std::memcmp(h.capacity, ROLLUP_CAPACITY, sizeof(h.capacity)) != 0) {
+            error = path + ": not a rollup file of this version";
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (base) munmap(base, file_size());
+        base = nullptr;
+        if (lock_fd >= 0) ::close(lock_fd);
+        lock_fd = -1;
+    }
+
+    bool is_open() const { return base != nullptr; }
+    const RollupFileHeader& header() const { return *reinterpret_cast<const RollupFileHeader*>(base); }
+
+    /**
+     * slot(): The ring slot interval `start` maps to (check slot.start)
+     */
+    RollupPoint& slot(RollupTier tier, int64_t start) {
+        return ring(tier)[static_cast<uint64_t>(start / ROLLUP_RESOLUTION[index(tier)]) % ROLLUP_CAPACITY[index(tier)]];
+    }
+    const RollupPoint& slot(RollupTier tier, int64_t start) const {
+        return const_cast<RollupFile*>(this)->slot(tier, start);
+    }
+
+    /**
+     * points(): Non-empty points of a tier with start in [from, to), oldest
+     * first; the range is clipped to what the ring retains
+     */
+    std::vector<RollupPoint> points(RollupTier tier, int64_t from, int64_t to) const {
+        const int64_t step = ROLLUP_RESOLUTION[index(tier)];
+        const int64_t span = step * ROLLUP_CAPACITY[index(tier)];
+        from = std::max(floor_to(from, step), floor_to(to - 1, step) - span + step);
+        std::vector<RollupPoint> out;
+        for (int64_t t = from; t < to; t += step) {
+            const RollupPoint& p = slot(tier, t);
+            if (p.count > 0 && p.start == t) out.push_back(p);
+        }
+        return out;
+    }
+
+    /**
+     * newest(): Start of the latest non-empty point of a tier (0 if none)
+     */
+    int64_t newest(RollupTier tier) const {
+        int64_t latest = 0;
+        const RollupPoint* p = ring(tier);
+        for (uint32_t i = 0; i < ROLLUP_CAPACITY[index(tier)]; i++) {
+            if (p[i].count > 0) latest = std::max(latest, p[i].start);
+        }
+        return latest;
+    }
+
+    static int64_t floor_to(int64_t t, int64_t step) {
+        return (t >= 0 ? t : t - step + 1) / step * step;
+    }
+
+private:
+    static size_t index(RollupTier tier) { return static_cast<size_t>(tier); }
+
+
+    RollupPoint* ring(RollupTier tier) const {
+        size_t offset = sizeof(RollupFileHeader);
+        for (size_t t = 0; t < index(tier); t++) offset += ROLLUP_CAPACITY[t] * sizeof(RollupPoint);
+        return reinterpret_cast<RollupPoint*>(base + offset);
+    }
+
+    uint8_t* base = nullptr;
+    int lock_fd = -1;                  // Writer's descriptor, holds the flock()
+};
+
+// ============================================================================
+// STORE
+// ============================================================================
+
+/**
+ * RollupStore: named series fed by the workers, rolled up by one thread
+ */
+class RollupStore {
+public:
+    static const size_t INGEST_SLOTS = 8;       // Seconds collected in memory at a time
+    static const int64_t GRACE_S = 2;           // Seconds a late value is still accepted
+    static const int ROLL_MS = 250;             // Rollup interval
+
+    ~RollupStore() { close(); }
+
+    /**
+     * open(): Open (or create) <dir>/<name>.rollup for every series
+     * @param names: Series, in the order record() refers to them
+     * @param error: Reason on failure
+     */
+    bool open(const std::string& dir, const std::vector<std::string>& names, std::string& error) {
+        if (::mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+            error = dir + ": " + std::strerror(errno);
+            return false;
+        }
+        const int64_t now = static_cast<int64_t>(std::floor(unix_seconds()));
+        for (const std::string& name : names) {
+            std::unique_ptr<Series> s(new Series());
+            s->name = name;
+            if (!s->file.open(dir + "/" + name + ".rollup", name, true, error)) return false;
+            for (int64_t t = now - GRACE_S; t < now - GRACE_S + static_cast<int64_t>(INGEST_SLOTS); t++) {
+                s->ingest[slot_index(t)].reopen(t);
+            }
+            series.push_back(std::move(s));
+        }
+        next_seal = now - GRACE_S;
+        return true;
+    }
+
+    /**
+     * record(): Add one value to a series (any thread, lock-free)
+     * @param id: Index of the series in the names given to open()
+     * @param unix_s: Time the value belongs to
+     */
+    void record(size_t id, double unix_s, double value) {
+        const int64_t second = static_cast<int64_t>(std::floor(unix_s));
+        IngestSlot& slot = series[id]->ingest[slot_index(second)];
+        slot.writers.fetch_add(1);
+        if (slot.second.load() == second) {
+            slot.add(value);
+        } else {
+            rejected_count.fetch_add(1, std::memory_order_relaxed);
+        }
+        slot.writers.fetch_sub(1, std::memory_order_release);
+    }
+
+    /**
+     * run(): Roll completed seconds into the files until `stopping` is set
+     */
+    void run(const std::atomic<bool>& stopping) {
+        while (!stopping.load()) {
+            roll(static_cast<int64_t>(std::floor(unix_seconds())) - GRACE_S);
+            std::this_thread::sleep_for(std::chrono::milliseconds(ROLL_MS));
+        }
+    }
+
+    /**
+     * close(): Seal everything recorded (including the current second)
+     * and unmap the files; call once the writers have stopped
+     */
+    void close() {
+        if (series.empty()) return;
+        roll(static_cast<int64_t>(std::floor(unix_seconds())) + 1);
+        for (auto& s : series) s->file.close();
+        series.clear();
+    }
+
+    /**
+     * query(): Points of a series in [from, to) (unix seconds) at one tier
+     * @return: false if there is no such series
+     */
+    bool query(const std::string& name, RollupTier tier, int64_t from, int64_t to,
+               std::vector<RollupPoint>& out) {
+        for (auto& s : series) {
+            if (s->name != name) continue;
+            std::lock_guard<std::mutex> lock(mtx);
+            out = s->file.points(tier, from, to);
+            return true;
+        }
+        return false;
+    }
+
+    std::vector<std::string> names() const {
+        std::vector<std::string> out;
+        for (const auto& s : series) out.push_back(s->name);
+        return out;
+    }
+
+    uint64_t rejected() const { return rejected_count.load(); }
+    uint64_t sealed_seconds() const { return sealed_count.load(); }
+
+private:
+    /**
+     * IngestSlot: accumulators of one second; `second` is SEALED while the
+     * rollup thread reads it
+     */
+    struct IngestSlot {
+        static const int64_t SEALED = std::numeric_limits<int64_t>::min();
+
+        std::atomic<int64_t> second{SEALED};
+        std::atomic<uint32_t> writers{0};
+        std::atomic<uint64_t> count{0};
+        std::atomic<double> sum{0.0};
+        std::atomic<double> min{0.0};
+        std::atomic<double> max{0.0};
+
+        void add(double value) {
+            count.fetch_add(1, std::memory_order_relaxed);
+            double seen = sum.load(std::memory_order_relaxed);
+            while (!sum.compare_exchange_weak(seen, seen + value, std::memory_order_relaxed)) {}
+            seen = min.load(std::memory_order_relaxed);
+            while (value < seen && !min.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+            seen = max.load(std::memory_order_relaxed);
+            while (value > seen && !max.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+        }
+
+        // Reset the accumulators and accept values of second t
+        void reopen(int64_t t) {
+            count.store(0, std::memory_order_relaxed);
+            sum.store(0.0, std::memory_order_relaxed);
+            min.store(std::numeric_limits<double>::infinity(), std::memory_order_relaxed);
+            max.store(-std::numeric_limits<double>::infinity(), std::memory_order_relaxed);
+            second.store(t);
+        }
+    };
+
+    struct Series {
+        std::string name;
+        RollupFile file;
+        IngestSlot ingest[INGEST_SLOTS];
+    };
+
+    static size_t slot_index(int64_t second) {
+        return static_cast<size_t>(static_cast<uint64_t>(second) % INGEST_SLOTS);
+    }
+
+    // Seal every second before `until` (rollup thread, or close())
+    void roll(int64_t until) {
+        std::lock_guard<std::mutex> lock(mtx);
+        // After a long pause (suspend, clock step) only the last lap of slots
+        // can hold values; the seconds in between are empty
+        if (until - next_seal > static_cast<int64_t>(INGEST_SLOTS)) {
+            next_seal = std::max(next_seal, until - static_cast<int64_t>(INGEST_SLOTS));
+        }
+        for (; next_seal < until; next_seal++) {
+            for (auto& s : series) seal(*s, next_seal);
+            sealed_count++;
+        }
+    }
+
+    // Close a second's slot, wait out writers already inside, fold it into
+    // the tiers and reopen the slot one lap later
+    void seal(Series& s, int64_t t) {
+        IngestSlot& slot = s.ingest[slot_index(t)];
+        const int64_t held = slot.second.exchange(IngestSlot::SEALED);
+        while (slot.writers.load(std::memory_order_acquire) != 0) std::this_thread::yield();
+        const uint64_t n = slot.count.load(std::memory_order_relaxed);
+        if (held == t && n > 0) {
+            const double lo = slot.min.load(std::memory_order_relaxed);
+            const double hi = slot.max.load(std::memory_order_relaxed);
+            const double mean = slot.sum.load(std::memory_order_relaxed) / static_cast<double>(n);
+            for (RollupTier tier : {RollupTier::SECOND, RollupTier::MINUTE, RollupTier::HOUR}) {
+                const int64_t start = RollupFile::floor_to(t, ROLLUP_RESOLUTION[static_cast<size_t>(tier)]);
+                merge_rollup(s.file.slot(tier, start), start, n, lo, mean, hi);
+            }
+        }
+        slot.reopen(t + static_cast<int64_t>(INGEST_SLOTS));
+    }
+
+    std::vector<std::unique_ptr<Series>> series;
+    std::mutex mtx;                          // Rollup vs queries (never taken by record())
+    int64_t next_seal = 0;                   // First second not yet sealed (under mtx)
+    std::atomic<uint64_t> rejected_count{0};
+    std::atomic<uint64_t> sealed_count{0};
+};
@@ -0,0 +1,186 @@
+/*
+ * EEL6528 Lab 1: Sample block shared by the RX streamer and processing threads
+ *
+ * A block carries its samples in exactly one host format:
+ * - FC32: complex<float> (sc16 wire, converted by UHD)
+ * - SC16: complex<int16_t> (fc32 block compacted while queued)
+ * - SC8:  complex<int8_t> (sc8 wire kept packed end to end, or an fc32
+ *         block compacted while queued)
+ */
+
+#pragma once
+
+#include "sample_format.hpp"
+
+#include <chrono>
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+/**
+ * SampleFormat: host-side storage format of a SampleBlock
+ */
+enum class SampleFormat {
+    FC32,
+    SC16,
+    SC8
+};
+
+/**
+ * PriorityLane: queue lanes, highest priority first
+ * - LANE_FLAGGED: blocks flagged by the RX thread's front-end energy check
+ * - LANE_ROUTINE: everything else (routine power logging)
+ */
+enum PriorityLane : uint8_t {
+    LANE_FLAGGED = 0,
+    LANE_ROUTINE = 1,
+    NUM_LANES
+};
+
+/**
+ * Sample management block
+ *
+ * MEMORY LAYOUT:
+ * - block_number: Sequential identifier for ordering and debugging
+ * - format: Which sample vector holds the data
+ * - samples: fc32 IQ samples (FC32 blocks)
+ * - samples_sc16: int16 IQ samples (SC16 blocks), 2x smaller than fc32
+ * - samples_sc8: int8 IQ samples (SC8 blocks), 4x smaller than fc32
+ * - int_scale: fc32 amplitude of one integer step (SC16/SC8 blocks)
+ * - compacted: true if the queue packed an fc32 block to save memory
+ * - priority: queue lane (PriorityLane), LANE_ROUTINE unless the producer
+ *   flags the block
+ * - sample_offset: absolute stream index of the first sample
+ * - history: fc32 samples preceding the block (overlap for stateful
+ *   stages in ordered mode, empty otherwise)
+ * - timestamp: Time the block was received from the streamer
+ */
+struct SampleBlock {
+    size_t block_number;                          // Sequential block identifier
+    SampleFormat format;                          // Active storage format
+    std::vector<std::complex<float>> samples;     // IQ sample data (I + jQ format)
+    std::vector<std::complex<int16_t>> samples_sc16; // Packed IQ sample data (16-bit)
+    std::vector<std::complex<int8_t>> samples_sc8; // Packed IQ sample data (8-bit)
+    float int_scale;                              // Integer step -> fc32 amplitude
+    bool compacted;                               // Packed by the queue, expand on pop
+    uint8_t priority;                             // Queue lane, 0 = highest
+    uint64_t sample_offset;                       // Stream index of samples[0]
+    std::vector<std::complex<float>> history;     // Overlap from the previous block
+    std::chrono::steady_clock::time_point timestamp; // Receive time
+
+    // Default constructor: Creates empty block with ID 0
+    SampleBlock()
+        : block_number(0), format(SampleFormat::FC32), int_scale(1.0f), compacted(false),
+          priority(LANE_ROUTINE), sample_offset(0) {}
+
+    // Parameterized constructor: Pre-allocates an fc32 sample vector
+    // @param num: Block sequence number for tracking
+    // @param size: Number of samples to pre-allocate
+    SampleBlock(size_t num, size_t size)
+        : block_number(num), format(SampleFormat::FC32), samples(size), int_scale(1.0f),
+          compacted(false), priority(LANE_ROUTINE), sample_offset(0),
+          timestamp(std::chrono::steady_clock::now()) {}
+
+    // Number of complex samples held, regardless of format
+    size_t size() const {
+        switch (format) {
+            case SampleFormat::SC16: return samples_sc16.size();
+            case SampleFormat::SC8:  return samples_sc8.size();
+            default:                 return samples.size();
+        }
+    }
+
+    // Bytes of sample payload held, regardless of format
+    size_t payload_bytes() const {
+        switch (format) {
+            case SampleFormat::SC16: return samples_sc16.size() * sizeof(std::complex<int16_t>);
+            case SampleFormat::SC8:  return samples_sc8.size() * sizeof(std::complex<int8_t>);
+            default:                 return samples.size() * sizeof(std::complex<float>);
+        }
+    }
+};
+
+/**
+ * range_avg_power(): Average power (1/N) * sum(|x[n]|^2) of samples
+ * [begin, begin + count) of a block in fc32 units
+ * Dispatches to the int8 SIMD kernel for SC8 blocks. The pointer kernels are
+ * shared with offline tools, so their results match live processing exactly.
+ */
+inline double range_avg_power(const SampleBlock& block, size_t begin, size_t count) {
+    if (count == 0) return 0.0;
+    if (block.format == SampleFormat::SC8) {
+        return avg_power_sc8(block.samples_sc8.data() + begin, count, block.int_scale);
+    }
+    if (block.format == SampleFormat::SC16) {
+        double sum_power = 0.0;
+        for (size_t i = begin; i < begin + count; i++) {
+            const auto& sample = block.samples_sc16[i];
+            sum_power += double(sample.real()) * sample.real() + double(sample.imag()) * sample.imag();
+        }
+        return sum_power * block.int_scale * block.int_scale / count;
+    }
+    return avg_power_fc32(block.samples.data() + begin, count);
+}
+
+/**
+ * block_avg_power(): Average power of a whole block in fc32 units
+ */
+inline double block_avg_power(const SampleBlock& block) {
+    return range_avg_power(block, 0, block.size());
+}
+
+// ============================================================================
+// IN-QUEUE COMPACTION
+// ============================================================================
+
+/**
+ * compact_block(): Pack an fc32 block into SC16 or SC8 in place
+ *
+ * The integer step is chosen from the block's own peak component, so a
+ * weak block still uses the full 8/16-bit range (block floating point).
+ * Blocks that are not FC32 are left untouched.
+ *
+ * @param block: Block to pack
+ * @param target: SampleFormat::SC16 or SampleFormat::SC8
+ */
+inline void compact_block(SampleBlock& block, SampleFormat target) {
+    if (block.format != SampleFormat::FC32 || target == SampleFormat::FC32) return;
+
+    const size_t n = block.samples.size();
+    const float peak = peak_component(block.samples.data(), n);
+    const float full_scale = (target == SampleFormat::SC16) ? 32767.0f : 127.0f;
+    const float step = peak > 0.0f ? peak / full_scale : 1.0f;
+
+    if (target == SampleFormat::SC16) {
+        block.samples_sc16.resize(n);
+        pack_sc16(block.samples.data(), n, block.samples_sc16.data(), 1.0f / step);
+    } else {
+        block.samples_sc8.resize(n);
+        pack_sc8(block.samples.data(), n, block.samples_sc8.data(), 1.0f / step);
+    }
+    block.format = target;
+    block.int_scale = step;
+    block.compacted = true;
+    std::vector<std::complex<float>>().swap(block.samples);   // Release fc32 storage
+}
+
+/**
+ * expand_block(): Restore a queue-compacted block to fc32
+ * Blocks streamed natively as sc8 (not compacted) are left packed.
+ */
+inline void expand_block(SampleBlock& block) {
+    if (!block.compacted) return;
+
+    const size_t n = block.size();
+    block.samples.resize(n);
+    if (block.format == SampleFormat::SC16) {
+        unpack_sc16(block.samples_sc16.data(), n, block.samples.data(), block.int_scale);
+        std::vector<std::complex<int16_t>>().swap(block.samples_sc16);
+    } else {
+        unpack_sc8(block.samples_sc8.data(), n, block.samples.data(), block.int_scale);
+        std::vector<std::complex<int8_t>>().swap(block.samples_sc8);
+    }
+    block.format = SampleFormat::FC32;
+    block.int_scale = 1.0f;
+    block.compacted = false;
+}
@@ -0,0 +1,319 @@
+/*
+ * EEL6528 Lab 1: Sample formats and power kernels
+ *
+ * The N210 streams samples over Gigabit Ethernet in one of two wire formats:
+ * - sc16: 16-bit signed I/Q (4 bytes/sample) -> ~25 MS/s link limit
+ * - sc8:   8-bit signed I/Q (2 bytes/sample) -> ~50 MS/s link limit
+ *
+ * In sc16 mode UHD converts to fc32 on the host. In sc8 mode we keep the
+ * samples as complex<int8_t> all the way to the processing threads (4x less
+ * memory per block than fc32) and compute power directly on the integers.
+ *
+ * SIMD:
+ * - AVX2 path when compiled with -mavx2 / -march=native
+ * - SSE2 path otherwise on x86-64 (always available)
+ * - Portable scalar fallback everywhere else
+ */
+
+#pragma once
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// ============================================================================
+// WIRE / HOST FORMATS
+// ============================================================================
+
+/**
+ * WireFormat: sample format carried over the Ethernet link
+ */
+enum class WireFormat {
+    SC16,   // 16-bit I/Q on the wire, fc32 on the host
+    SC8     // 8-bit I/Q on the wire and on the host
+};
+
+// Full-scale integer value used to normalize sc8 samples (matches UHD convention)
+const double SC8_FULL_SCALE = 127.0;
+
+// Usable Gigabit Ethernet payload throughput between N210 and host (bytes/sec)
+const double GIGE_LINK_BYTES_PER_SEC = 100e6;
+
+/**
+ * wire_format_name(): Human-readable name ("sc16" / "sc8")
+ */
+inline const char* wire_format_name(WireFormat format) {
+    return format == WireFormat::SC8 ? "sc8" : "sc16";
+}
+
+/**
+ * parse_wire_format(): Parse "sc16" / "sc8" command-line values
+ * @param name: Format name
+ * @param format: Output format on success
+ * @return: true if the name was recognized
+ */
+inline bool parse_wire_format(const std::string& name, WireFormat& format) {
+    if (name == "sc16") { format = WireFormat::SC16; return true; }
+    if (name == "sc8")  { format = WireFormat::SC8;  return true; }
+    return false;
+}
+
+/**
+ * host_format_for(): CPU-side format requested from UHD for a wire format
+ * sc16 is converted to fc32; sc8 is kept as sc8 to avoid the 4x expansion.
+ */
+inline const char* host_format_for(WireFormat format) {
+    return format == WireFormat::SC8 ? "sc8" : "fc32";
+}
+
+/**
+ * wire_bytes_per_sample(): Bytes of link bandwidth per complex sample
+ */
+inline size_t wire_bytes_per_sample(WireFormat format) {
+    return format == WireFormat::SC8 ? 2 : 4;
+}
+
+/**
+ * max_link_rate(): Highest sample rate the link sustains for a wire format
+ */
+inline double max_link_rate(WireFormat format) {
+    return GIGE_LINK_BYTES_PER_SEC / wire_bytes_per_sample(format);
+}
+
+/**
+ * quantization_snr_db(): Theoretical full-scale SQNR of an N-bit converter
+ * SQNR = 6.02*N + 1.76 dB for a full-scale sinusoid. Signals below full
+ * scale lose 20*log10(peak/amplitude) dB from this figure.
+ */
+inline double quantization_snr_db(WireFormat format) {
+    const int bits = format == WireFormat::SC8 ? 8 : 16;
+    return 6.02 * bits + 1.76;
+}
+
+// ============================================================================
+// BLOCK POWER KERNELS
+// ============================================================================
+
+/**
+ * sum_power_sc8(): Sum of I^2 + Q^2 over int8 complex samples
+ *
+ * Each int8 pair is widened to int16 and squared/added with a multiply-add
+ * (pmaddwd), giving I^2 + Q^2 <= 2 * 128^2 per 32-bit lane. The 32-bit lanes
+ * are folded into a 64-bit total every FLUSH_ITERS iterations so no lane can
+ * overflow regardless of block size.
+ *
+ * @param samples: Pointer to interleaved int8 I/Q samples
+ * @param count: Number of complex samples
+ * @return: Exact integer sum of squared magnitudes
+ */
+inline uint64_t sum_power_sc8(const std::complex<int8_t>* samples, size_t count) {
+    const int8_t* data = reinterpret_cast<const int8_t*>(samples);
+    const size_t num_bytes = count * 2;
+    size_t i = 0;
+    uint64_t total = 0;
+
+#if defined(__AVX2__)
+    // 32 bytes (16 complex samples) per iteration; <= 2^16 added per lane
+    const size_t FLUSH_ITERS = 16384;
+    while (i + 32 <= num_bytes) {
+        __m256i acc = _mm256_setzero_si256();
+        for (size_t iter = 0; iter < FLUSH_ITERS && i + 32 <= num_bytes; iter++, i += 32) {
+            __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 16));
+            __m256i lo16 = _mm256_cvtepi8_epi16(lo);
+            __m256i hi16 = _mm256_cvtepi8_epi16(hi);
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(lo16, lo16));
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(hi16, hi16));
+        }
+        alignas(32) uint32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+        for (uint32_t lane : lanes) total += lane;
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    // 16 bytes (8 complex samples) per iteration; <= 2^16 added per lane
+    const size_t FLUSH_ITERS = 16384;
+    while (i + 16 <= num_bytes) {
+        __m128i acc = _mm_setzero_si128();
+        for (size_t iter = 0; iter < FLUSH_ITERS && i + 16 <= num_bytes; iter++, i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            // Sign-extend int8 -> int16 by duplicating bytes and shifting right
+            __m128i lo16 = _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+            __m128i hi16 = _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8);
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(lo16, lo16));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(hi16, hi16));
+        }
+        alignas(16) uint32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+        for (uint32_t lane : lanes) total += lane;
+    }
+#endif
+
+    // Scalar tail (or whole block without SIMD support)
+    for (; i < num_bytes; i++) {
+        const int32_t v = data[i];
+        total += static_cast<uint64_t>(v * v);
+    }
+    return total;
+}
+
+/**
+ * avg_power_sc8(): Average power of an sc8 block in fc32 units
+ * @param samples: Pointer to int8 I/Q samples
+ * @param count: Number of complex samples
+ * @param scale: Multiplier mapping one int8 step to fc32 amplitude
+ * @return: (1/N) * sum(|x[n]|^2) * scale^2
+ */
+inline double avg_power_sc8(const std::complex<int8_t>* samples, size_t count, double scale) {
+    if (count == 0) return 0.0;
+    return static_cast<double>(sum_power_sc8(samples, count)) * scale * scale / count;
+}
+
+/**
+ * avg_power_fc32(): Average power of an fc32 block
+ * @param samples: Pointer to complex float samples
+ * @param count: Number of complex samples
+ * @return: (1/N) * sum(|x[n]|^2), accumulated in double
+ */
+inline double avg_power_fc32(const std::complex<float>* samples, size_t count) {
+    if (count == 0) return 0.0;
+    double sum_power = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        sum_power += std::norm(samples[i]);
+    }
+    return sum_power / count;
+}
+
+/**
+ * quantize_sc8(): Convert one fc32 component to int8 with saturation
+ * @param value: Sample component in fc32 units
+ * @param inv_scale: 1 / (fc32 amplitude of one int8 step)
+ */
+inline int8_t quantize_sc8(float value, float inv_scale) {
+    float scaled = value * inv_scale;
+    scaled = scaled >= 0.0f ? scaled + 0.5f : scaled - 0.5f;   // round to nearest
+    if (scaled > 127.0f) return 127;
+    if (scaled < -128.0f) return -128;
+    return static_cast<int8_t>(scaled);
+}
+
+// ============================================================================
+// FC32 <-> INTEGER PACKING
+// ============================================================================
+// Unpacking is a plain int -> float loop that the compiler vectorizes at
+// -O3. The peak search and packing have explicit SSE2 paths. GCC does not
+// vectorize a float max reduction without -ffast-math (NaN ordering).
+// lrint() is a library call it will not vectorize either, while cvtps2dq
+// rounds the same way (to nearest even in the default mode).
+
+/**
+ * peak_component(): Largest |I| or |Q| in an fc32 buffer
+ */
+inline float peak_component(const std::complex<float>* samples, size_t count) {
+    const float* data = reinterpret_cast<const float*>(samples);
+    float peak = 0.0f;
+    size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 4 <= count * 2; i += 4) {
+        acc = _mm_max_ps(acc, _mm_and_ps(_mm_loadu_ps(data + i), abs_mask));
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, acc);
+    for (float lane : lanes) peak = lane > peak ? lane : peak;
+#endif
+    for (; i < count * 2; i++) {
+        float v = data[i] < 0.0f ? -data[i] : data[i];
+        peak = v > peak ? v : peak;
+    }
+    return peak;
+}
+
+/**
+ * pack_sc16(): fc32 -> int16 with rounding and saturation
+ * @param inv_step: 1 / (fc32 amplitude of one int16 step)
+ */
+inline void pack_sc16(const std::complex<float>* in, size_t count,
+                      std::complex<int16_t>* out, float inv_step) {
+    const float* src = reinterpret_cast<const float*>(in);
+    int16_t* dst = reinterpret_cast<int16_t*>(out);
+    size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128 scale = _mm_set1_ps(inv_step);
+    const __m128 hi = _mm_set1_ps(32767.0f), lo = _mm_set1_ps(-32768.0f);
+    for (; i + 8 <= count * 2; i += 8) {
+        __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i), scale), lo), hi);
+        __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale), lo), hi);
+        __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+    }
+#endif
+    for (; i < count * 2; i++) {
+        float v = src[i] * inv_step;
+        v = v > 32767.0f ? 32767.0f : (v < -32768.0f ? -32768.0f : v);
+        dst[i] = static_cast<int16_t>(std::lrint(v));
+    }
+}
+
+/**
+ * pack_sc8(): fc32 -> int8 with rounding and saturation
+ * @param inv_step: 1 / (fc32 amplitude of one int8 step)
+ */
+inline void pack_sc8(const std::complex<float>* in, size_t count,
+                     std::complex<int8_t>* out, float inv_step) {
+    const float* src = reinterpret_cast<const float*>(in);
+    int8_t* dst = reinterpret_cast<int8_t*>(out);
+    size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128 scale = _mm_set1_ps(inv_step);
+    const __m128 hi = _mm_set1_ps(127.0f), lo = _mm_set1_ps(-128.0f);
+    for (; i + 16 <= count * 2; i += 16) {
+        __m128i v[4];
+        for (int k = 0; k < 4; k++) {
+            __m128 f = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4 * k), scale), lo), hi);
+            v[k] = _mm_cvtps_epi32(f);
+        }
+        __m128i packed = _mm_packs_epi16(_mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+    }
+#endif
+    for (; i < count * 2; i++) {
+        float v = src[i] * inv_step;
+        v = v > 127.0f ? 127.0f : (v < -128.0f ? -128.0f : v);
+        dst[i] = static_cast<int8_t>(std::lrint(v));
+    }
+}
+
+/**
+ * unpack_sc16(): int16 -> fc32
+ * @param step: fc32 amplitude of one int16 step
+ */
+inline void unpack_sc16(const std::complex<int16_t>* in, size_t count,
+                        std::complex<float>* out, float step) {
+    const int16_t* src = reinterpret_cast<const int16_t*>(in);
+    float* dst = reinterpret_cast<float*>(out);
+    for (size_t i = 0; i < count * 2; i++) {
+        dst[i] = src[i] * step;
+    }
+}
+
+/**
+ * unpack_sc8(): int8 -> fc32
+ * @param step: fc32 amplitude of one int8 step
+ */
+inline void unpack_sc8(const std::complex<int8_t>* in, size_t count,
+                       std::complex<float>* out, float step) {
+    const int8_t* src = reinterpret_cast<const int8_t*>(in);
+    float* dst = reinterpret_cast<float*>(out);
+    for (size_t i = 0; i < count * 2; i++) {
+        dst[i] = src[i] * step;
+    }
+}
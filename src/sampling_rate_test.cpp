@@ -22,125 +22,45 @@
 #include <string>
 #include <memory>
 #include <cmath>
+#include <cstdlib>
 #include <sys/resource.h>  // For CPU usage monitoring
 
+#include "sample_block.hpp" // SampleBlock shared with lab1.cpp
+#include "spill_queue.hpp"  // Memory + spill file block queue
+#include "metrics_server.hpp" // Prometheus endpoint for live monitoring
+
 // N210 Hardware Configuration
 const double RX_FREQ = 2.437e9;
 const size_t SAMPLES_PER_BLOCK = 10000;
+const size_t MEMORY_QUEUE_BLOCKS = 100;   // Blocks kept in RAM before spilling to disk
+const int DEFAULT_METRICS_PORT = 9464;     // Prometheus scrape port (127.0.0.1)
 
 // Thread control and monitoring variables
 std::atomic<bool> stop_signal(false);
 std::atomic<size_t> overflow_count(0);
 std::atomic<size_t> total_blocks(0);
-std::atomic<size_t> dropped_blocks(0);
+std::atomic<size_t> processed_blocks(0);
 std::mutex console_mutex;
 
-// Performance monitoring
-struct PerformanceStats {
-    double cpu_usage = 0.0;
-    size_t memory_usage = 0;
-    size_t queue_max_size = 0;
-    double processing_rate = 0.0;
-    std::chrono::steady_clock::time_point start_time;
-};
-
-PerformanceStats perf_stats;
-
-// SampleBlock structure
-struct SampleBlock {
-    size_t block_number;
-    std::vector<std::complex<float>> samples;
-    std::chrono::steady_clock::time_point timestamp;
-    
-    SampleBlock() : block_number(0) {}
-    SampleBlock(size_t num, size_t num_samples) : block_number(num), samples(num_samples) {
-        timestamp = std::chrono::steady_clock::now();
-    }
-};
-
-// Enhanced thread-safe FIFO Queue with monitoring
-class MonitoredSampleQueue {
-private:
-    std::queue<SampleBlock> queue;
-    std::mutex mtx;
-    std::condition_variable cv;
-    std::atomic<size_t> max_size{0};
-    
-public:
-    void push(const SampleBlock& block) {
-        std::unique_lock<std::mutex> lock(mtx);
-        queue.push(block);
-        
-        // Update max queue size
-        size_t current_size = queue.size();
-        size_t expected = max_size.load();
-        while (current_size > expected && 
-               !max_size.compare_exchange_weak(expected, current_size)) {
-            expected = max_size.load();
-        }
-        
-        cv.notify_one();
-    }
-    
-    bool pop(SampleBlock& block) {
-        std::unique_lock<std::mutex> lock(mtx);
-        
-        cv.wait(lock, [this] { 
-            return !queue.empty() || stop_signal.load(); 
-        });
-        
-        if (stop_signal.load() && queue.empty()) {
-            return false;
-        }
-        
-        if (!queue.empty()) {
-            block = queue.front();
-            queue.pop();
-            return true;
-        }
-        return false;
-    }
-    
-    size_t size() {
-        std::lock_guard<std::mutex> lock(mtx);
-        return queue.size();
-    }
-    
-    size_t get_max_size() {
-        return max_size.load();
-    }
-    
-    void notify_all() {
-        cv.notify_all();
-    }
-};
+// Live monitoring: published with relaxed atomics by the threads and read
+// by the metrics endpoint; scrapes never touch the queue lock
+std::atomic<double> actual_rate(0.0);
+std::atomic<double> last_block_power(0.0);
+LatencyHistogram latency_histogram;
+ThreadCpuClocks thread_clocks;
+std::chrono::steady_clock::time_point start_time;
 
-MonitoredSampleQueue sample_queue;
+// Tiered FIFO queue: the first MEMORY_QUEUE_BLOCKS blocks stay in memory,
+// the rest are written to a spill file and read back in order, so a slow
+// consumer costs disk space instead of dropped blocks
+std::unique_ptr<SpillQueue> spill_queue;
 
-// CPU Usage monitoring
-double get_cpu_usage() {
+// CPU time of the whole process (user + system), in seconds
+double process_cpu_seconds() {
     struct rusage usage;
     getrusage(RUSAGE_SELF, &usage);
-    
-    long user_time = usage.ru_utime.tv_sec * 1000000 + usage.ru_utime.tv_usec;
-    long sys_time = usage.ru_stime.tv_sec * 1000000 + usage.ru_stime.tv_usec;
-    
-    static long prev_user = 0, prev_sys = 0;
-    static auto prev_time = std::chrono::steady_clock::now();
-    
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - prev_time).count();
-    
-    double cpu_percent = 0.0;
-    if (elapsed > 0) {
-        cpu_percent = ((user_time - prev_user) + (sys_time - prev_sys)) * 100.0 / elapsed;
-    }
-    
-    prev_user = user_time;
-    prev_sys = sys_time;
-    prev_time = now;
-    
-    return cpu_percent;
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6
+         + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
 }
 
 // Memory usage monitoring
@@ -152,9 +72,11 @@ size_t get_memory_usage() {
 
 // RX Streamer with performance monitoring
 void rx_streamer_thread(uhd::usrp::multi_usrp::sptr usrp, double sampling_rate) {
+    ThreadCpuScope cpu_clock(thread_clocks, "rx", 0);
     
     // Set parameters
     usrp->set_rx_rate(sampling_rate);
+    actual_rate.store(usrp->get_rx_rate());
     uhd::tune_request_t tune_request(RX_FREQ);
     usrp->set_rx_freq(tune_request);
     usrp->set_rx_gain(20.0);
@@ -180,7 +102,6 @@ void rx_streamer_thread(uhd::usrp::multi_usrp::sptr usrp, double sampling_rate)
     stream_cmd.time_spec = uhd::time_spec_t();
     
     rx_stream->issue_stream_cmd(stream_cmd);
-    perf_stats.start_time = std::chrono::steady_clock::now();
     
     uhd::rx_metadata_t md;
     size_t block_counter = 0;
@@ -206,13 +127,9 @@ void rx_streamer_thread(uhd::usrp::multi_usrp::sptr usrp, double sampling_rate)
             SampleBlock block(block_counter++, SAMPLES_PER_BLOCK);
             block.samples = buff;
             
-            // Check if queue is getting too full (potential overflow indicator)
-            if (sample_queue.size() > 100) {
-                dropped_blocks++;
-                continue; // Drop this block
-            }
-            
-            sample_queue.push(block);
+            // Blocks past the in-memory capacity spill to disk instead of
+            // being dropped
+            spill_queue->push(std::move(block));
             total_blocks++;
         }
     }
@@ -224,12 +141,14 @@ void rx_streamer_thread(uhd::usrp::multi_usrp::sptr usrp, double sampling_rate)
 
 // Processing thread with performance monitoring
 void processing_thread(int thread_id) {
+    ThreadCpuScope cpu_clock(thread_clocks, "worker", thread_id);
     size_t blocks_processed = 0;
     
-    while (!stop_signal.load()) {
+    // Runs until the queue is closed and drained, including spilled blocks
+    for (;;) {
         SampleBlock block;
         
-        if (!sample_queue.pop(block)) {
+        if (!spill_queue->pop(block)) {
             break;
         }
         
@@ -240,6 +159,13 @@ void processing_thread(int thread_id) {
         }
         double avg_power = sum_power / block.samples.size();
         
+        // Latency of the block's first sample: fill + queue (memory or disk) + work
+        const double fill = block.samples.size() / actual_rate.load(std::memory_order_relaxed);
+        latency_histogram.record(fill + std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - block.timestamp).count());
+        last_block_power.store(avg_power, std::memory_order_relaxed);
+        processed_blocks.fetch_add(1, std::memory_order_relaxed);
+        
         blocks_processed++;
         
         // Print every 100th block to avoid output spam
@@ -248,34 +174,41 @@ void processing_thread(int thread_id) {
             std::cout << "[Thread " << thread_id << "] "
                       << "Block #" << std::setw(6) << block.block_number 
                       << " | Avg Power: " << std::scientific << std::setprecision(3) << avg_power
-                      << " | Queue: " << std::setw(3) << sample_queue.size()
-                      << " | CPU: " << std::fixed << std::setprecision(1) << get_cpu_usage() << "%"
+                      << " | Queue: " << std::setw(3) << spill_queue->depth()
                       << std::endl;
         }
     }
 }
 
-// Performance monitoring thread
-void monitor_thread() {
-    while (!stop_signal.load()) {
-        std::this_thread::sleep_for(std::chrono::seconds(2));
-        
-        perf_stats.cpu_usage = get_cpu_usage();
-        perf_stats.memory_usage = get_memory_usage();
-        perf_stats.queue_max_size = sample_queue.get_max_size();
-        
-        auto now = std::chrono::steady_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - perf_stats.start_time).count();
-        if (elapsed > 0) {
-            perf_stats.processing_rate = total_blocks.load() / (double)elapsed;
-        }
-    }
+// Prometheus scrape: queue, block counts, per-thread CPU, latency and power
+void collect_metrics(MetricsWriter& out) {
+    out.counter("sampling_test_blocks_produced_total", "Blocks received from the radio", total_blocks.load());
+    out.counter("sampling_test_blocks_processed_total", "Blocks processed", processed_blocks.load());
+    out.counter("sampling_test_blocks_dropped_total", "Blocks lost to spill write errors",
+                spill_queue->lost_blocks());
+    out.counter("sampling_test_blocks_spilled_total", "Blocks that went through the spill file",
+                spill_queue->spilled_blocks());
+    out.counter("sampling_test_overflows_total", "RX overflow events", overflow_count.load());
+    out.gauge("sampling_test_queue_depth_blocks", "Blocks queued (memory + disk)", spill_queue->depth());
+    out.gauge("sampling_test_queue_max_blocks", "Largest queue depth so far", spill_queue->get_max_size());
+    out.gauge("sampling_test_block_power", "Average power of the latest processed block",
+              last_block_power.load(std::memory_order_relaxed));
+    out.summary("sampling_test_block_latency_seconds", "Block latency (fill + queue + work)",
+                latency_histogram);
+    out.family("sampling_test_thread_cpu_seconds_total", "counter", "CPU time per thread");
+    thread_clocks.for_each([&out](const std::string& role, int id, double seconds) {
+        out.sample("sampling_test_thread_cpu_seconds_total", seconds,
+                   "role=\"" + role + "\",id=\"" + std::to_string(id) + "\"");
+    });
+    out.counter("sampling_test_process_cpu_seconds_total", "CPU time of the process", process_cpu_seconds());
+    out.gauge("sampling_test_memory_peak_kilobytes", "Peak resident memory", get_memory_usage());
 }
 
 int main(int argc, char* argv[]) {
     
-    if (argc != 4) {
-        std::cout << "Usage: " << argv[0] << " <sampling_rate_MHz> <num_threads> <test_duration_sec>" << std::endl;
+    if (argc < 4 || argc > 6) {
+        std::cout << "Usage: " << argv[0] << " <sampling_rate_MHz> <num_threads> <test_duration_sec> [spill_dir (default $TMPDIR or /tmp)]"
+                  << " [metrics_port (0 = off, default " << DEFAULT_METRICS_PORT << ")]" << std::endl;
         std::cout << "Example: " << argv[0] << " 5 2 30" << std::endl;
         return -1;
     }
@@ -283,12 +216,21 @@ int main(int argc, char* argv[]) {
     double sampling_rate = std::stod(argv[1]) * 1e6;  // Convert MHz to Hz
     int num_threads = std::stoi(argv[2]);
     double run_time = std::stod(argv[3]);
+    const char* tmpdir = std::getenv("TMPDIR");
+    std::string spill_dir = (argc >= 5) ? argv[4] : (tmpdir && *tmpdir ? tmpdir : "/tmp");
+    int metrics_port = (argc == 6) ? std::stoi(argv[5]) : DEFAULT_METRICS_PORT;
+    spill_queue.reset(new SpillQueue(MEMORY_QUEUE_BLOCKS, spill_dir));
     
     try {
         std::cout << "\n=== Sampling Rate Performance Test ===" << std::endl;
         std::cout << "Target sampling rate: " << sampling_rate/1e6 << " MHz" << std::endl;
         std::cout << "Processing threads: " << num_threads << std::endl;
         std::cout << "Test duration: " << run_time << " seconds" << std::endl;
+        std::cout << "Spill file: " << (spill_queue->spill_path().empty() ? "none" : spill_queue->spill_path())
+                  << " (unlinked, after " << MEMORY_QUEUE_BLOCKS << " blocks in memory)" << std::endl;
+        if (metrics_port > 0) {
+            std::cout << "Metrics: http://127.0.0.1:" << metrics_port << "/metrics" << std::endl;
+        }
         std::cout << "==========================================\n" << std::endl;
         
         // Create USRP device
@@ -298,11 +240,20 @@ int main(int argc, char* argv[]) {
         // Create threads
         std::vector<std::thread> threads;
         
-        // Start monitoring thread
-        threads.emplace_back(monitor_thread);
+        // Live monitoring: Prometheus endpoint instead of a polling thread
+        MetricsServer metrics;
+        if (metrics_port > 0) {
+            std::string error;
+            if (metrics.open(metrics_port, error)) {
+                threads.emplace_back([&metrics] { metrics.run(stop_signal, collect_metrics); });
+            } else {
+                std::cerr << "Cannot serve metrics on port " << metrics_port << ": " << error << std::endl;
+            }
+        }
+        start_time = std::chrono::steady_clock::now();
         
-        // Start RX streamer thread
-        threads.emplace_back(rx_streamer_thread, usrp, sampling_rate);
+        // Start RX streamer thread (joined first at shutdown)
+        std::thread rx_thread(rx_streamer_thread, usrp, sampling_rate);
         
         // Start processing threads
         for (int i = 0; i < num_threads; i++) {
@@ -312,33 +263,56 @@ int main(int argc, char* argv[]) {
         // Run test
         std::this_thread::sleep_for(std::chrono::duration<double>(run_time));
         
-        // Stop all threads
+        // Stop the producer first: once it has exited nothing more is
+        // pushed and the queue can be closed. The workers then drain every
+        // tier, blocks on disk included, before they exit.
         stop_signal.store(true);
-        sample_queue.notify_all();
+        rx_thread.join();
+        const size_t backlog = spill_queue->size();
+        if (backlog > 0) {
+            std::cout << "\nDraining " << backlog << " queued blocks..." << std::endl;
+        }
+        spill_queue->notify_all();
         
         for (auto& t : threads) {
             t.join();
         }
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
         
         // Print final performance report
         std::cout << "\n=== PERFORMANCE ANALYSIS REPORT ===" << std::endl;
         std::cout << "Sampling Rate: " << sampling_rate/1e6 << " MHz" << std::endl;
         std::cout << "Test Duration: " << run_time << " seconds" << std::endl;
         std::cout << "Total Blocks Received: " << total_blocks.load() << std::endl;
-        std::cout << "Blocks Dropped (Queue Full): " << dropped_blocks.load() << std::endl;
+        std::cout << "Blocks Spilled to Disk: " << spill_queue->spilled_blocks() << std::endl;
+        std::cout << "Spill Writes: " << spill_queue->write_calls() << " ("
+                  << (spill_queue->write_calls() ? spill_queue->bytes_written() / spill_queue->write_calls() / 1024 : 0)
+                  << " KB avg) | Prefetch Reads: " << spill_queue->read_calls() << std::endl;
+        std::cout << "Peak Spill File Size: " << spill_queue->peak_disk_bytes() / 1024 << " KB" << std::endl;
+        std::cout << "Blocks Lost (Spill I/O Errors): " << spill_queue->lost_blocks() << std::endl;
+        std::cout << "Blocks Queued at Stop (drained): " << backlog << std::endl;
+        std::cout << "Blocks Processed: " << processed_blocks.load() << std::endl;
         std::cout << "Hardware Overflows: " << overflow_count.load() << std::endl;
-        std::cout << "Max Queue Size: " << perf_stats.queue_max_size << std::endl;
+        std::cout << "Max Queue Size: " << spill_queue->get_max_size() << std::endl;
         std::cout << "Processing Rate: " << std::fixed << std::setprecision(2) 
-                  << perf_stats.processing_rate << " blocks/sec" << std::endl;
-        std::cout << "Peak Memory Usage: " << perf_stats.memory_usage << " KB" << std::endl;
+                  << processed_blocks.load() / elapsed << " blocks/sec" << std::endl;
+        std::cout << "Block Latency p50/p90/p99: " << latency_histogram.quantile(0.5) * 1e3 << "/"
+                  << latency_histogram.quantile(0.9) * 1e3 << "/" << latency_histogram.quantile(0.99) * 1e3
+                  << " ms" << std::endl;
+        std::cout << "Peak Memory Usage: " << get_memory_usage() << " KB" << std::endl;
         std::cout << "Average CPU Usage: " << std::fixed << std::setprecision(1) 
-                  << perf_stats.cpu_usage << "%" << std::endl;
+                  << 100.0 * process_cpu_seconds() / elapsed << "%" << std::endl;
         
         // Performance assessment
         if (overflow_count.load() > 0) {
             std::cout << "\n❌ OVERFLOW DETECTED - Sampling rate too high!" << std::endl;
-        } else if (dropped_blocks.load() > 0) {
-            std::cout << "\n⚠️  QUEUE OVERFLOW - Processing can't keep up!" << std::endl;
+        } else if (spill_queue->lost_blocks() > 0) {
+            std::cout << "\n⚠️  SPILL FAILURE - Disk can't keep up!" << std::endl;
+        } else if (processed_blocks.load() != total_blocks.load()) {
+            std::cout << "\n⚠️  " << total_blocks.load() - processed_blocks.load()
+                      << " BLOCKS UNPROCESSED at shutdown" << std::endl;
+        } else if (spill_queue->spilled_blocks() > 0) {
+            std::cout << "\n⚠️  BACKLOG SPILLED - Processing can't keep up, no blocks lost" << std::endl;
         } else {
             std::cout << "\n✅ SUCCESS - No overflows at " << sampling_rate/1e6 << " MHz" << std::endl;
         }
@@ -0,0 +1,436 @@
+/*
+ * EEL6528 Lab 1: Spill-to-disk overflow queue
+ *
+ * A FIFO of SampleBlocks with two tiers:
+ * - memory: up to memory_blocks blocks, popped directly by consumers
+ * - disk:   blocks past the memory capacity, appended to a spill file
+ *
+ * ORDERING:
+ *   oldest [ memory ] [ spill file ] [ pending writes ] newest
+ *   Once anything is on disk (or waiting to be written), new blocks go
+ *   behind it, so consumers always see blocks in push order.
+ *
+ * I/O THREAD:
+ * - Pending blocks are serialized into one buffer and written with a single
+ *   large sequential pwrite() once write_batch_bytes accumulate (or after
+ *   FLUSH_INTERVAL), never from the producer thread
+ * - When the memory tier drains below half, the next records are read back
+ *   with one pread() and appended to memory before consumers run dry
+ * - The file is truncated back to zero whenever the disk tier empties
+ *
+ * SPILL FILE:
+ * Created with mkstemp() under a unique name in the spill directory and
+ * unlinked at once. mkstemp() opens with O_CREAT | O_EXCL, mode 0600, so
+ * a file or symlink planted in a shared directory such as /tmp is never
+ * followed or truncated.
+ *
+ * No block is lost as long as the disk keeps up; failed writes are counted
+ * in lost_blocks(). Closing the queue does not discard anything: consumers
+ * keep receiving blocks, read back from disk as needed, until all tiers
+ * are empty.
+ */
+
+#pragma once
+
+#include "sample_block.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+class SpillQueue {
+public:
+    // Longest time a partial batch waits before it is written anyway
+    static constexpr std::chrono::milliseconds FLUSH_INTERVAL{50};
+
+    /**
+     * Constructor: Create (and immediately unlink) the spill file, start I/O thread
+     * @param memory_blocks: Blocks held in memory before spilling
+     * @param spill_dir: Directory the spill file is created in
+     * @param write_batch_bytes: Target size of each sequential write
+     */
+    SpillQueue(size_t memory_blocks, const std::string& spill_dir,
+               size_t write_batch_bytes = 4 * 1024 * 1024)
+        : memory_capacity(std::max<size_t>(memory_blocks, 2)),
+          batch_bytes(write_batch_bytes) {
+        std::string name = spill_dir + "/sampling_test.spill.XXXXXX";
+        std::vector<char> templ(name.begin(), name.end());
+        templ.push_back('\0');
+        fd = ::mkstemp(templ.data());
+        if (fd < 0) {
+            std::cerr << "SpillQueue: cannot create a spill file in " << spill_dir << ": "
+                      << std::strerror(errno) << " - blocks past memory capacity will be lost" << std::endl;
+        } else {
+            path = templ.data();
+            ::unlink(path.c_str());   // Anonymous file: space returns on exit
+        }
+        io_thread = std::thread(&SpillQueue::io_loop, this);
+    }
+
+    ~SpillQueue() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            closed = true;
+            io_stop = true;
+        }
+        io_cv.notify_all();
+        consumer_cv.notify_all();
+        io_thread.join();
+        if (fd >= 0) ::close(fd);
+    }
+
+    SpillQueue(const SpillQueue&) = delete;
+    SpillQueue& operator=(const SpillQueue&) = delete;
+
+    /**
+     * push(): Append a block; spills to disk once memory is full
+     * @param block: Sample block (moved in)
+     */
+    void push(SampleBlock block) {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (disk_blocks == 0 && pending.empty() && in_flight == 0 &&
+            memory.size() < memory_capacity) {
+            memory.push_back(std::move(block));
+            update_max_size();
+            consumer_cv.notify_one();
+            return;
+        }
+        pending_bytes += record_bytes(block);
+        pending.push_back(std::move(block));
+        spilled++;
+        update_max_size();
+        if (pending_bytes >= batch_bytes) io_cv.notify_one();
+    }
+
+    /**
+     * pop(): Remove the oldest block, waiting while the queue is empty
+     * @param block: Reference to store the retrieved block
+     * @return: true if block retrieved, false once closed and every tier
+     *         (memory, disk, pending writes) is drained
+     */
+    bool pop(SampleBlock& block) {
+        std::unique_lock<std::mutex> lock(mtx);
+        consumer_cv.wait(lock, [this] { return !memory.empty() || (closed && total_blocks() == 0); });
+        if (memory.empty()) return false;
+
+        block = std::move(memory.front());
+        memory.pop_front();
+        depth_now.store(total_blocks(), std::memory_order_relaxed);
+
+        // Prefetch from the lower tiers before the memory tier runs dry
+        if (memory.size() <= memory_capacity / 2 &&
+            (disk_blocks > 0 || !pending.empty())) {
+            io_cv.notify_one();
+        }
+        return true;
+    }
+
+    /**
+     * size(): Blocks queued in all tiers (memory + disk + pending writes)
+     */
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return total_blocks();
+    }
+
+    // Largest number of blocks queued at once
+    size_t get_max_size() { return max_size.load(); }
+
+    // Blocks queued in all tiers, without the lock (monitoring snapshot)
+    size_t depth() const { return depth_now.load(std::memory_order_relaxed); }
+
+    /**
+     * notify_all(): Close the queue (no more pushes) and wake blocked
+     * consumers
+     * Consumers still receive every queued block, including those on disk
+     * or waiting to be written, then pop() fails.
+     */
+    void notify_all() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            closed = true;
+        }
+        io_cv.notify_one();          // Move what is left towards memory
+        consumer_cv.notify_all();
+    }
+
+    // Statistics
+    size_t spilled_blocks() const { return spilled.load(); }
+    size_t lost_blocks() const { return lost.load(); }
+    size_t peak_disk_bytes() const { return peak_disk.load(); }
+    size_t write_calls() const { return writes.load(); }
+    size_t read_calls() const { return reads.load(); }
+    size_t bytes_written() const { return written.load(); }
+
+    // Name the (already unlinked) spill file was created under, empty if none
+    const std::string& spill_path() const { return path; }
+
+private:
+    // On-disk record header; the payload follows immediately
+    struct RecordHeader {
+        uint64_t block_number;
+        int64_t timestamp_ns;    // steady_clock time since epoch
+        uint32_t format;         // SampleFormat
+        uint32_t count;          // Complex samples in payload
+        float int_scale;
+        uint32_t compacted;
+    };
+
+    static size_t record_bytes(const SampleBlock& block) {
+        return sizeof(RecordHeader) + block.payload_bytes();
+    }
+
+    static const void* payload_ptr(const SampleBlock& block) {
+        switch (block.format) {
+            case SampleFormat::SC16: return block.samples_sc16.data();
+            case SampleFormat::SC8:  return block.samples_sc8.data();
+            default:                 return block.samples.data();
+        }
+    }
+
+    static void serialize(const SampleBlock& block, std::vector<char>& out) {
+        RecordHeader header;
+        header.block_number = block.block_number;
+        header.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            block.timestamp.time_since_epoch()).count();
+        header.format = static_cast<uint32_t>(block.format);
+        header.count = static_cast<uint32_t>(block.size());
+        header.int_scale = block.int_scale;
+        header.compacted = block.compacted ? 1 : 0;
+        size_t offset = out.size();
+        out.resize(offset + sizeof(header) + block.payload_bytes());
+        std::memcpy(out.data() + offset, &header, sizeof(header));
+        std::memcpy(out.data() + offset + sizeof(header), payload_ptr(block), block.payload_bytes());
+    }
+
+    static SampleBlock deserialize(const char* data) {
+        RecordHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        const char* payload = data + sizeof(header);
+
+        SampleBlock block;
+        block.block_number = header.block_number;
+        block.timestamp = std::chrono::steady_clock::time_point(
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::nanoseconds(header.timestamp_ns)));
+        block.format = static_cast<SampleFormat>(header.format);
+        block.int_scale = header.int_scale;
+        block.compacted = header.compacted != 0;
+        switch (block.format) {
+            case SampleFormat::SC16:
+                block.samples_sc16.resize(header.count);
+                std::memcpy(block.samples_sc16.data(), payload, block.payload_bytes());
+                break;
+            case SampleFormat::SC8:
+                block.samples_sc8.resize(header.count);
+                std::memcpy(block.samples_sc8.data(), payload, block.payload_bytes());
+                break;
+            default:
+                block.samples.resize(header.count);
+                std::memcpy(block.samples.data(), payload, block.payload_bytes());
+                break;
+        }
+        return block;
+    }
+
+    size_t total_blocks() const {
+        return memory.size() + disk_blocks + in_flight + pending.size();
+    }
+
+    void update_max_size() {
+        size_t current = total_blocks();
+        depth_now.store(current, std::memory_order_relaxed);
+        size_t expected = max_size.load();
+        while (current > expected && !max_size.compare_exchange_weak(expected, current)) {}
+    }
+
+    /**
+     * io_loop(): Background writer (spill) and reader (prefetch)
+     */
+    void io_loop() {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (!io_stop) {
+            io_cv.wait_for(lock, FLUSH_INTERVAL, [this] {
+                return io_stop || pending_bytes >= batch_bytes || refill_needed();
+            });
+            if (io_stop) break;
+
+            if (refill_needed()) {
+                refill(lock);
+            }
+            // Write a full batch, or whatever is pending after FLUSH_INTERVAL
+            if (!pending.empty() && (pending_bytes >= batch_bytes ||
+                std::chrono::steady_clock::now() - last_write >= FLUSH_INTERVAL)) {
+                spill(lock);
+            }
+        }
+    }
+
+    bool refill_needed() const {
+        return memory.size() <= memory_capacity / 2 && (disk_blocks > 0 || !pending.empty());
+    }
+
+    /**
+     * refill(): Move the oldest spilled blocks back into memory
+     * Reads as many whole records as fit in the free memory slots (up to
+     * one write batch) with a single pread(). If nothing is on disk, pending
+     * blocks are moved across without touching the file.
+     */
+    void refill(std::unique_lock<std::mutex>& lock) {
+        size_t free_slots = memory_capacity - memory.size();
+
+        if (disk_blocks == 0) {
+            while (free_slots-- > 0 && !pending.empty()) {
+                pending_bytes -= record_bytes(pending.front());
+                memory.push_back(std::move(pending.front()));
+                pending.pop_front();
+            }
+            consumer_cv.notify_all();
+            return;
+        }
+
+        size_t count = 0, bytes = 0;
+        while (count < std::min(free_slots, disk_record_sizes.size()) &&
+               (count == 0 || bytes + disk_record_sizes[count] <= batch_bytes)) {
+            bytes += disk_record_sizes[count++];
+        }
+        const off_t offset = read_offset;
+        std::vector<size_t> sizes(disk_record_sizes.begin(), disk_record_sizes.begin() + count);
+
+        lock.unlock();
+        std::vector<char> buffer(bytes);
+        bool ok = read_fully(buffer.data(), bytes, offset);
+        std::vector<SampleBlock> blocks;
+        if (ok) {
+            size_t pos = 0;
+            for (size_t size : sizes) {
+                blocks.push_back(deserialize(buffer.data() + pos));
+                pos += size;
+            }
+        }
+        lock.lock();
+
+        reads++;
+        for (size_t i = 0; i < count; i++) disk_record_sizes.pop_front();
+        disk_blocks -= count;
+        read_offset += bytes;
+        if (ok) {
+            for (auto& block : blocks) memory.push_back(std::move(block));
+        } else {
+            std::cerr << "SpillQueue: read failed, " << count << " blocks lost" << std::endl;
+            lost += count;
+        }
+        if (disk_blocks == 0) {
+            // Disk tier empty: reclaim the file space
+            read_offset = write_offset = 0;
+            if (::ftruncate(fd, 0) != 0) { /* space is reclaimed at close anyway */ }
+        }
+        consumer_cv.notify_all();
+    }
+
+    /**
+     * spill(): Write all pending blocks with one sequential pwrite()
+     */
+    void spill(std::unique_lock<std::mutex>& lock) {
+        std::deque<SampleBlock> batch;
+        batch.swap(pending);
+        pending_bytes = 0;
+        in_flight = batch.size();
+        const off_t offset = write_offset;
+
+        lock.unlock();
+        std::vector<char> buffer;
+        std::vector<size_t> sizes;
+        buffer.reserve(batch_bytes + (batch_bytes >> 2));
+        for (const auto& block : batch) {
+            sizes.push_back(record_bytes(block));
+            serialize(block, buffer);
+        }
+        bool ok = write_fully(buffer.data(), buffer.size(), offset);
+        lock.lock();
+
+        in_flight = 0;
+        last_write = std::chrono::steady_clock::now();
+        if (!ok) {
+            std::cerr << "SpillQueue: write failed, " << batch.size() << " blocks lost" << std::endl;
+            lost += batch.size();
+            depth_now.store(total_blocks(), std::memory_order_relaxed);
+            consumer_cv.notify_all();    // A closed queue may now be drained
+            return;
+        }
+        writes++;
+        written += buffer.size();
+        write_offset += buffer.size();
+        disk_blocks += batch.size();
+        disk_record_sizes.insert(disk_record_sizes.end(), sizes.begin(), sizes.end());
+        size_t disk_bytes = static_cast<size_t>(write_offset - read_offset);
+        if (disk_bytes > peak_disk.load()) peak_disk.store(disk_bytes);
+    }
+
+    bool write_fully(const char* data, size_t bytes, off_t offset) {
+        if (fd < 0) return false;
+        while (bytes > 0) {
+            ssize_t n = ::pwrite(fd, data, bytes, offset);
+            if (n <= 0) return false;
+            data += n; bytes -= n; offset += n;
+        }
+        return true;
+    }
+
+    bool read_fully(char* data, size_t bytes, off_t offset) {
+        if (fd < 0) return false;
+        while (bytes > 0) {
+            ssize_t n = ::pread(fd, data, bytes, offset);
+            if (n <= 0) return false;
+            data += n; bytes -= n; offset += n;
+        }
+        return true;
+    }
+
+    // Configuration
+    const size_t memory_capacity;
+    const size_t batch_bytes;
+    std::string path;                // Name the spill file was created under (empty if none)
+    int fd = -1;
+
+    // Tiers (guarded by mtx)
+    std::mutex mtx;
+    std::condition_variable consumer_cv;     // Consumers wait for memory blocks
+    std::condition_variable io_cv;           // I/O thread waits for work
+    std::deque<SampleBlock> memory;          // Oldest blocks, popped by consumers
+    std::deque<SampleBlock> pending;         // Newest blocks, waiting to be written
+    size_t pending_bytes = 0;
+    size_t in_flight = 0;                    // Blocks being written right now
+    size_t disk_blocks = 0;                  // Blocks in the spill file
+    std::deque<size_t> disk_record_sizes;    // Record sizes, oldest first
+    off_t read_offset = 0;
+    off_t write_offset = 0;
+    std::chrono::steady_clock::time_point last_write = std::chrono::steady_clock::now();
+    bool closed = false;
+    bool io_stop = false;
+    std::thread io_thread;
+
+    // Statistics
+    std::atomic<size_t> max_size{0};
+    std::atomic<size_t> depth_now{0};     // total_blocks() as of the last change
+    std::atomic<size_t> spilled{0};
+    std::atomic<size_t> lost{0};
+    std::atomic<size_t> peak_disk{0};
+    std::atomic<size_t> writes{0};
+    std::atomic<size_t> reads{0};
+    std::atomic<size_t> written{0};
+};
@@ -0,0 +1,69 @@
+/*
+ * EEL6528 Lab 1: Squelch gate for expensive per-block analysis
+ *
+ * On a quiet channel most blocks are noise only. The squelch compares each
+ * block's average power against the noise floor that came with it (both
+ * already computed by the processing threads; see noise_floor.hpp) and
+ * decides whether the heavy downstream stages run for that block at all.
+ *
+ * GATE (per block):
+ *   open when power > floor * 10^(threshold_db / 10)
+ * The decision uses nothing but the block's own power and floor. Workers
+ * finish blocks in any order, so an open / closed state carried from one
+ * decision to the next (hysteresis) would depend on thread timing.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * SquelchStats: counters for the final report
+ */
+struct SquelchStats {
+    uint64_t blocks = 0;            // Decisions made
+    uint64_t gated = 0;             // Blocks that skipped the heavy stages
+    double noise_floor = 0.0;       // Floor of the latest decision (fc32 power)
+};
+
+/**
+ * Squelch: shared by all processing threads; only the counters are shared
+ * (one short lock per block)
+ */
+class Squelch {
+public:
+
+    /**
+     * Constructor
+     * @param threshold_db: Power above the floor that opens the gate
+     */
+    explicit Squelch(double threshold_db)
+        : open_ratio(std::pow(10.0, threshold_db / 10.0)) {}
+
+    /**
+     * update(): Decide for one block
+     * @param power: Block average power (fc32 units)
+     * @param floor: Noise floor estimated with the block (fc32 units)
+     * @return: true if the heavy stages should run (gate open)
+     */
+    bool update(double power, double floor) {
+        const bool open = power > floor * open_ratio;
+        std::lock_guard<std::mutex> lock(mtx);
+        stats.blocks++;
+        stats.noise_floor = floor;
+        if (!open) stats.gated++;
+        return open;
+    }
+
+    SquelchStats snapshot() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return stats;
+    }
+
+private:
+    std::mutex mtx;
+    double open_ratio;              // Linear open threshold over the floor
+    SquelchStats stats;
+};
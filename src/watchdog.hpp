@@ -0,0 +1,370 @@
+/*
+ * EEL6528 Lab 1: Watchdog for stalled threads
+ *
+ * A hung processing thread or an RX thread that stopped getting samples
+ * otherwise goes unnoticed until the queue explodes (or, in the hardware
+ * build, until the program quietly runs out of blocks).
+ *
+ * HEARTBEATS (hot path):
+ * Every monitored thread owns a Heartbeat and, once per block, stores its
+ * state, the block number and a bumped beat counter with relaxed atomics.
+ * No clock reads, no locks, no shared cache lines (one Heartbeat per line).
+ *
+ * CHECKS (low frequency, watchdog thread, every timeout / 4):
+ * - a worker WORKING on the same block for longer than the timeout: hung
+ * - the producer without a new block for longer than the timeout:
+ *   starved (the report shows RECEIVING when it is blocked in recv())
+ * - a thread STOPPED while the program is still running: exited early
+ *   (RETIRED threads left on purpose and are not checked)
+ * - the oldest queued block older than the timeout: consumers behind
+ * Each stall is reported once with a state report of every thread (state,
+ * time since its last beat, current block and the kernel's view of the
+ * thread: run state and wait channel from /proc), and once more when it
+ * clears. The checks only copy the heartbeats under the watchdog's lock;
+ * /proc reads and printing happen after it is released, so threads
+ * attaching meanwhile never wait on file I/O.
+ *
+ * SLOTS:
+ * A thread attaching takes over the heartbeat of a RETIRED thread of the
+ * same role, so resizing the pool back and forth does not grow the list.
+ *
+ * RESTART (optional):
+ * On a producer stall the watchdog raises a restart request; the RX thread
+ * picks it up between recv() calls and restarts the stream. Requests repeat
+ * every timeout while the stall lasts, up to MAX_RESTARTS in total.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * ThreadState: what a monitored thread is doing right now
+ */
+enum class ThreadState : uint8_t {
+    STARTING,       // Not streaming / processing yet (setup, settling)
+    WAITING,        // Waiting for work (consumer on an empty queue)
+    RECEIVING,      // Blocked in recv() (producer)
+    WORKING,        // Processing a block
+    STOPPED,        // Left its main loop
+    RETIRED         // Left on purpose while the program runs (pool shrunk)
+};
+
+inline const char* thread_state_name(ThreadState state) {
+    switch (state) {
+        case ThreadState::STARTING:  return "starting";
+        case ThreadState::WAITING:   return "waiting";
+        case ThreadState::RECEIVING: return "receiving";
+        case ThreadState::WORKING:   return "working";
+        case ThreadState::STOPPED:   return "stopped";
+        case ThreadState::RETIRED:   return "retired";
+    }
+    return "?";
+}
+
+/**
+ * Heartbeat: written by one thread only, read by the watchdog
+ */
+struct alignas(64) Heartbeat {
+    std::string role;                         // "rx" or "worker"
+    int id = 0;
+    long tid = 0;                             // Kernel thread id (/proc/self/task/<tid>)
+    bool producer = false;
+    std::atomic<uint64_t> beats{0};           // Blocks completed
+    std::atomic<uint64_t> block{0};           // Block number of the last / current block
+    std::atomic<ThreadState> state{ThreadState::STARTING};
+
+    void set_state(ThreadState s) { state.store(s, std::memory_order_relaxed); }
+
+    // Start of a block (consumers): its number, then WORKING
+    void begin(uint64_t block_number) {
+        block.store(block_number, std::memory_order_relaxed);
+        state.store(ThreadState::WORKING, std::memory_order_relaxed);
+    }
+
+    // One block done; single writer, so no read-modify-write needed
+    void beat() {
+        beats.store(beats.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * kernel_thread_state(): Run state and wait channel of a thread of this
+ * process, e.g. "S (futex_wait_queue)"; empty if /proc is unavailable
+ */
+inline std::string kernel_thread_state(long tid) {
+    const std::string dir = "/proc/self/task/" + std::to_string(tid) + "/";
+    std::ifstream stat(dir + "stat");
+    std::string line;
+    if (!std::getline(stat, line)) return "";
+    const size_t paren = line.rfind(')');        // comm may contain spaces
+    if (paren == std::string::npos || paren + 2 >= line.size()) return "";
+    std::string result(1, line[paren + 2]);
+    std::ifstream wchan(dir + "wchan");
+    std::string channel;
+    if (std::getline(wchan, channel) && !channel.empty() && channel != "0") {
+        result += " (" + channel + ")";
+    }
+    return result;
+}
+
+/**
+ * Watchdog: periodic stall detection over registered heartbeats
+ */
+class Watchdog {
+public:
+    static const unsigned MAX_RESTARTS = 5;
+
+    /**
+     * QueueProbe: depth of the queue and age of its oldest block (s)
+     */
+    using QueueProbe = std::function<void(size_t& depth, double& oldest_age)>;
+
+    /**
+     * configure(): Set before the threads start
+     * @param timeout_s: Stall threshold (0 disables the checks)
+     * @param restart: Request stream restarts on producer stalls
+     */
+    void configure(double timeout_s, bool restart) {
+        timeout = timeout_s;
+        restart_enabled = restart;
+    }
+
+    bool enabled() const { return timeout > 0.0; }
+
+    /**
+     * attach(): Register the calling thread (call once, from the thread)
+     * @return: The thread's heartbeat, valid for the watchdog's lifetime
+     */
+    Heartbeat& attach(const std::string& role, int id, bool producer = false) {
+        std::lock_guard<std::mutex> lock(mtx);
+        size_t slot = 0;
+        while (slot < beats.size() &&
+               !(beats[slot].role == role && beats[slot].state.load() == ThreadState::RETIRED)) {
+            slot++;
+        }
+        if (slot == beats.size()) {
+            beats.emplace_back();
+            watched.emplace_back();
+        }
+        Heartbeat& hb = beats[slot];
+        hb.role = role;
+        hb.id = id;
+        hb.producer = producer;
+        hb.tid = static_cast<long>(syscall(SYS_gettid));
+        hb.beats.store(0);
+        hb.block.store(0);
+        hb.state.store(ThreadState::STARTING);
+        watched[slot] = Watched();
+        return hb;
+    }
+
+    /**
+     * run(): Watchdog thread body; returns once stop() is called
+     * @param stopping: Set when the program shuts down (threads exit)
+     * @param probe: Reads the sample queue's depth and oldest block age
+     */
+    void run(const std::atomic<bool>& stopping, QueueProbe probe) {
+        if (!enabled()) return;
+        const auto period = std::chrono::duration<double>(timeout / 4.0);
+        std::unique_lock<std::mutex> lock(mtx);
+        while (!stop_requested) {
+            cv.wait_for(lock, period, [this] { return stop_requested; });
+            if (stop_requested || stopping.load()) break;
+            lock.unlock();
+            size_t depth = 0;
+            double oldest = 0.0;
+            probe(depth, oldest);
+            lock.lock();
+            std::vector<Notice> notices;
+            std::vector<ThreadSnapshot> threads;
+            check(std::chrono::steady_clock::now(), depth, oldest, stopping, notices, threads);
+            lock.unlock();
+            print(notices, threads);
+            lock.lock();
+        }
+    }
+
+    void stop() {
+        std::lock_guard<std::mutex> lock(mtx);
+        stop_requested = true;
+        cv.notify_all();
+    }
+
+    /**
+     * take_restart_request(): Producer side; true once per request
+     */
+    bool take_restart_request() {
+        return restart_pending.load(std::memory_order_relaxed) &&
+               restart_pending.exchange(false, std::memory_order_relaxed);
+    }
+
+    // The producer should keep trying after a timeout (a restart may follow)
+    bool restart_possible() const {
+        return restart_enabled && restarts.load(std::memory_order_relaxed) < MAX_RESTARTS;
+    }
+
+    uint64_t stalls() const { return stall_count.load(); }
+    unsigned restarts_requested() const { return restarts.load(); }
+
+private:
+    // Watchdog-side view of one heartbeat
+    struct Watched {
+        uint64_t beats = 0;
+        std::chrono::steady_clock::time_point last_beat;  // When beats last changed
+        std::chrono::steady_clock::time_point since;      // Start of the current no-progress stretch
+        std::string problem;                           // Stall being reported (empty = none)
+        std::chrono::steady_clock::time_point last_restart;
+    };
+
+    // Copy of one heartbeat for a state report, printed without mtx
+    struct ThreadSnapshot {
+        std::string role;
+        int id = 0;
+        long tid = 0;
+        ThreadState state = ThreadState::STARTING;
+        double since_beat = 0.0;                       // Seconds since the last beat
+        uint64_t beats = 0;
+        uint64_t block = 0;
+    };
+
+    // One message of a pass, optionally followed by the state report
+    struct Notice {
+        std::string text;
+        bool with_report = false;
+    };
+
+    /**
+     * check(): One pass over all threads and the queue (caller holds mtx)
+     * @param notices: Receives the messages to print
+     * @param threads: Receives the state report, if any notice needs it
+     */
+    void check(std::chrono::steady_clock::time_point now, size_t depth, double oldest,
+               const std::atomic<bool>& stopping, std::vector<Notice>& notices,
+               std::vector<ThreadSnapshot>& threads) {
+        for (size_t i = 0; i < beats.size(); i++) {
+            const Heartbeat& hb = beats[i];
+            Watched& w = watched[i];
+            const uint64_t count = hb.beats.load(std::memory_order_relaxed);
+            const ThreadState state = hb.state.load(std::memory_order_relaxed);
+            // Progress restarts the stall clock; so does waiting for work
+            if (count != w.beats || w.last_beat == std::chrono::steady_clock::time_point()) {
+                w.beats = count;
+                w.last_beat = now;
+                w.since = now;
+            } else if (state == ThreadState::STARTING || state == ThreadState::WAITING) {
+                w.since = now;
+            }
+            const double idle = std::chrono::duration<double>(now - w.since).count();
+
+            std::string problem;
+            if (state == ThreadState::STOPPED && !stopping.load()) {
+                problem = "exited while the program is still running";
+            } else if (hb.producer && state != ThreadState::STARTING && idle > timeout) {
+                problem = "starved: no blocks received";
+            } else if (!hb.producer && state == ThreadState::WORKING && idle > timeout) {
+                problem = "hung on block " + std::to_string(hb.block.load(std::memory_order_relaxed));
+            }
+
+            if (!problem.empty() && problem != w.problem) {
+                w.problem = problem;
+                stall_count++;
+                std::ostringstream text;
+                text << "\n[Watchdog] " << hb.role << " " << hb.id << " " << problem
+                     << " (no progress for " << std::fixed << std::setprecision(1) << idle << " s)";
+                notices.push_back({text.str(), true});
+            } else if (problem.empty() && !w.problem.empty()) {
+                w.problem.clear();
+                notices.push_back({"[Watchdog] " + hb.role + " " + std::to_string(hb.id) + " recovered", false});
+            }
+
+            // Producer stalls: ask for a stream restart, again every timeout
+            if (!w.problem.empty() && hb.producer && state != ThreadState::STOPPED && restart_possible() &&
+                std::chrono::duration<double>(now - w.last_restart).count() > timeout) {
+                w.last_restart = now;
+                restarts++;
+                restart_pending.store(true, std::memory_order_relaxed);
+                notices.push_back({"[Watchdog] Requesting stream restart (" + std::to_string(restarts.load()) +
+                                   "/" + std::to_string(MAX_RESTARTS) + ")", false});
+            }
+        }
+
+        if (oldest > timeout && !queue_stalled) {
+            queue_stalled = true;
+            stall_count++;
+            std::ostringstream text;
+            text << "\n[Watchdog] Consumers behind: oldest of " << depth << " queued blocks is "
+                 << std::fixed << std::setprecision(1) << oldest << " s old";
+            notices.push_back({text.str(), true});
+        } else if (oldest <= timeout / 2 && queue_stalled) {
+            queue_stalled = false;
+            notices.push_back({"[Watchdog] Queue backlog cleared", false});
+        }
+
+        for (const Notice& notice : notices) {
+            if (!notice.with_report) continue;
+            for (size_t i = 0; i < beats.size(); i++) {
+                const Heartbeat& hb = beats[i];
+                ThreadSnapshot t;
+                t.role = hb.role;
+                t.id = hb.id;
+                t.tid = hb.tid;
+                t.state = hb.state.load(std::memory_order_relaxed);
+                t.since_beat = std::chrono::duration<double>(now - watched[i].last_beat).count();
+                t.beats = hb.beats.load(std::memory_order_relaxed);
+                t.block = hb.block.load(std::memory_order_relaxed);
+                threads.push_back(t);
+            }
+            break;
+        }
+    }
+
+    /**
+     * print(): Write a pass's messages, each stall followed by the state
+     * report of every monitored thread (no lock held: reads /proc)
+     */
+    static void print(const std::vector<Notice>& notices, const std::vector<ThreadSnapshot>& threads) {
+        std::vector<std::string> kernel;
+        if (!notices.empty()) {
+            for (const ThreadSnapshot& t : threads) kernel.push_back(kernel_thread_state(t.tid));
+        }
+        for (const Notice& notice : notices) {
+            std::cerr << notice.text << std::endl;
+            if (!notice.with_report) continue;
+            for (size_t i = 0; i < threads.size(); i++) {
+                const ThreadSnapshot& t = threads[i];
+                std::cerr << "  " << std::left << std::setw(6) << t.role << std::right << std::setw(2) << t.id
+                          << " | " << std::left << std::setw(9) << thread_state_name(t.state) << std::right
+                          << " | last beat " << std::fixed << std::setprecision(1) << t.since_beat << " s ago"
+                          << " | beats " << t.beats << " | block " << t.block
+                          << " | tid " << t.tid << (kernel[i].empty() ? "" : " " + kernel[i]) << std::endl;
+            }
+        }
+    }
+
+    double timeout = 0.0;
+    bool restart_enabled = false;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool stop_requested = false;
+    std::deque<Heartbeat> beats;            // Stable addresses for attach()
+    std::deque<Watched> watched;
+    bool queue_stalled = false;
+    std::atomic<bool> restart_pending{false};
+    std::atomic<unsigned> restarts{0};
+    std::atomic<uint64_t> stall_count{0};
+};